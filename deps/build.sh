@@ -97,16 +97,34 @@ if [ ! -f $ROOT/lib/libsnappy.a ]; then
     build_snappy
 fi
 
+# Build zstd
+function build_zstd() {
+    ZSTD=zstd-1.4.9
+    if [ ! -d $ZSTD ]; then
+        wget https://github.com/facebook/zstd/archive/v1.4.9.tar.gz -O $ZSTD.tar.gz
+        tar xf $ZSTD.tar.gz
+    fi
+    cd $ZSTD
+    make -j 10 lib-release
+    make install PREFIX=$ROOT
+    cd $ROOT
+}
+
+if [ ! -f $ROOT/lib/libzstd.a ]; then
+    build_zstd
+fi
+
 # Build rocksdb
 function build_rocksdb() {
-    ROCKSDB=rocksdb-4.3.1
+    ROCKSDB=rocksdb-6.29.5
     if [ ! -d $ROCKSDB ]; then
-        wget https://github.com/facebook/rocksdb/archive/v4.3.1.tar.gz -O $ROCKSDB.tar.gz
+        wget https://github.com/facebook/rocksdb/archive/v6.29.5.tar.gz -O $ROCKSDB.tar.gz
         tar xf $ROCKSDB.tar.gz
     fi
     cd $ROCKSDB
-    make -j 10 static_lib EXTRA_CXXFLAGS="-I../include -DSNAPPY"
-    make install INSTALL_PATH=$ROOT
+    make -j 10 static_lib PORTABLE=1 DISABLE_WARNING_AS_ERROR=1 USE_RTTI=1 \
+        EXTRA_CXXFLAGS="-I../include -DSNAPPY -DZLIB -DBZIP2 -DLZ4 -DZSTD"
+    make install-static INSTALL_PATH=$ROOT
     cd $ROOT
 }
 
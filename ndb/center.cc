@@ -206,17 +206,17 @@ Result Center::GetNamespaces(std::map<std::string, Configs>* nss) const {
     Configs configs;
 
     if (ns.HasMember("expire")) {
-      if (!ns["expire"].IsInt()) {
+      if (!ns["expire"].IsUint64()) {
         return Result::Error("Invalid expire");
       }
-      configs.set_expire(ns["expire"].GetInt());
+      configs.set_expire(ns["expire"].GetUint64());
     }
 
     if (ns.HasMember("maxlen")) {
-      if (!ns["maxlen"].IsInt()) {
+      if (!ns["maxlen"].IsUint64()) {
         return Result::Error("Invalid maxlen");
       }
-      configs.set_maxlen(ns["maxlen"].GetInt());
+      configs.set_maxlen(ns["maxlen"].GetUint64());
     }
 
     if (ns.HasMember("pruning")) {
@@ -233,6 +233,93 @@ Result Center::GetNamespaces(std::map<std::string, Configs>* nss) const {
       }
     }
 
+    if (ns.HasMember("block_size")) {
+      if (!ns["block_size"].IsUint()) {
+        return Result::Error("Invalid block_size");
+      }
+      configs.set_block_size(ns["block_size"].GetUint());
+    }
+
+    if (ns.HasMember("bloom_bits")) {
+      if (!ns["bloom_bits"].IsUint()) {
+        return Result::Error("Invalid bloom_bits");
+      }
+      configs.set_bloom_bits(ns["bloom_bits"].GetUint());
+    }
+
+    if (ns.HasMember("compression")) {
+      if (!ns["compression"].IsArray()) {
+        return Result::Error("Invalid compression");
+      }
+      const auto& cs = ns["compression"];
+      for (auto c = cs.Begin(); c != cs.End(); c++) {
+        Compression compression;
+        if (!c->IsString() || !ParseCompression(c->GetString(), &compression)) {
+          return Result::Error("Invalid compression");
+        }
+        configs.add_compression(compression);
+      }
+    }
+
+    if (ns.HasMember("memtable_size")) {
+      if (!ns["memtable_size"].IsUint64()) {
+        return Result::Error("Invalid memtable_size");
+      }
+      configs.set_memtable_size(ns["memtable_size"].GetUint64());
+    }
+
+    if (ns.HasMember("data_block_hash_index")) {
+      if (!ns["data_block_hash_index"].IsBool()) {
+        return Result::Error("Invalid data_block_hash_index");
+      }
+      configs.set_data_block_hash_index(ns["data_block_hash_index"].GetBool());
+    }
+
+    if (ns.HasMember("cache_priority")) {
+      if (!ns["cache_priority"].IsString()) {
+        return Result::Error("Invalid cache_priority");
+      }
+      auto p = ns["cache_priority"].GetString();
+      CachePriority priority;
+      if (!ParseCachePriority(p, &priority)) {
+        return Result::Error("Invalid cache_priority: %s", p);
+      }
+      configs.set_cache_priority(priority);
+    }
+
+    if (ns.HasMember("value_cache_size")) {
+      if (!ns["value_cache_size"].IsUint64()) {
+        return Result::Error("Invalid value_cache_size");
+      }
+      configs.set_value_cache_size(ns["value_cache_size"].GetUint64());
+    }
+
+    if (ns.HasMember("durability")) {
+      if (!ns["durability"].IsString()) {
+        return Result::Error("Invalid durability");
+      }
+      auto d = ns["durability"].GetString();
+      Durability durability;
+      if (!ParseDurability(d, &durability)) {
+        return Result::Error("Invalid durability: %s", d);
+      }
+      configs.set_durability(durability);
+    }
+
+    if (ns.HasMember("packed_entries")) {
+      if (!ns["packed_entries"].IsUint64()) {
+        return Result::Error("Invalid packed_entries");
+      }
+      configs.set_packed_entries(ns["packed_entries"].GetUint64());
+    }
+
+    if (ns.HasMember("packed_value_size")) {
+      if (!ns["packed_value_size"].IsUint64()) {
+        return Result::Error("Invalid packed_value_size");
+      }
+      configs.set_packed_value_size(ns["packed_value_size"].GetUint64());
+    }
+
     nss->emplace(nsname, configs);
   }
 
@@ -4,7 +4,7 @@ namespace ndb {
 
 #define INSTALL(name, func, mode, argc)    \
   Response func(const Request& request);   \
-  cmds_[name] = {func, mode, argc};
+  cmds_[name] = {func, mode, argc, NULL, true};
 
 Command::Command(const Options& options, Engine* engine)
     : options_(options), synchro_(engine) {
@@ -40,6 +40,7 @@ Command::Command(const Options& options, Engine* engine)
   // Int
   INSTALL("INCR",               CommandINCR,               "w",  2);
   INSTALL("INCRBY",             CommandINCRBY,             "w",  3);
+  INSTALL("INCRBYNR",           CommandINCRBYNR,           "w",  3);
   INSTALL("DECR",               CommandDECR,               "w",  2);
   INSTALL("DECRBY",             CommandDECRBY,             "w",  3);
 
@@ -131,11 +132,20 @@ Command::Command(const Options& options, Engine* engine)
   INSTALL("LRANGE",             CommandLRANGE,             "r",  4);
   INSTALL("LLEN",               CommandLLEN,               "r",  2);
 
+  // Commands without a key or with multiple keys.
+  for (auto name : {"PING", "ECHO", "INFO", "BACKUP", "COMPACT", "SLOWLOG", "SHUTDOWN",
+                    "NSNEW", "NSDEL", "NSGET", "NSSET", "NSLIST",
+                    "KEYS", "EXISTS", "DEL", "MGET", "MSET", "MSETNX"}) {
+    cmds_[name].keyed = false;
+  }
+
   // Init commands' stats here so we don't need to protect them later.
-  for (const auto& cmd : cmds_) {
-    cmdstats_[cmd.first].calls = 0;
-    cmdstats_[cmd.first].usecs = 0;
-    cmdstats_[cmd.first].slows = 0;
+  for (auto& cmd : cmds_) {
+    auto& stats = cmdstats_[cmd.first.ToString()];
+    stats.calls = 0;
+    stats.usecs = 0;
+    stats.slows = 0;
+    cmd.second.stats = &stats;
   }
   // "*" is the sum of all commands' stats.
   cmdstats_["*"].calls = 0;
@@ -155,7 +165,7 @@ Result Command::Run() {
 }
 
 Client* Command::ProcessClient(Client* client) {
-  while (client->HasRequest()) {
+  while (client->HasQuota()) {
     const auto& request = client->GetRequest();
     if (request.args(0) == "PSYNC") {
       synchro_.AddClient(client);
@@ -172,6 +182,18 @@ Client* Command::ProcessClient(Client* client) {
   return client;
 }
 
+bool Command::HashRequest(const Request& request, uint64_t* hash) const {
+  if (request.argc() < 2) {
+    return false;
+  }
+  auto it = cmds_.find(request.args(0));
+  if (it == cmds_.end() || !it->second.keyed) {
+    return false;
+  }
+  *hash = BKDRHash(request.args(1).data(), request.args(1).size());
+  return true;
+}
+
 Response Command::ProcessRequest(const Request& request) {
   auto it = cmds_.find(request.args(0));
   if (it == cmds_.end()) {
@@ -194,7 +216,7 @@ Response Command::ProcessRequest(const Request& request) {
 
   auto begin = getustime();
   auto response = cmd.func(request);
-  UpdateCmdStats(request, getustime() - begin);
+  UpdateCmdStats(request, cmd.stats, getustime() - begin);
   return response;
 }
 
@@ -224,21 +246,25 @@ Stats Command::GetStats(const std::string& cmd) const {
 
 #define INCRBY(c, inc) c.fetch_add(inc, std::memory_order_relaxed)
 
-void Command::UpdateCmdStats(const Request& request, uint64_t usecs) {
-  const auto& cmd = request.args(0);
-  INCRBY(cmdstats_[cmd].calls, 1);
-  INCRBY(cmdstats_[cmd].usecs, usecs);
-  INCRBY(cmdstats_["*"].calls, 1);
-  INCRBY(cmdstats_["*"].usecs, usecs);
+void Command::UpdateCmdStats(const Request& request, CmdStats* cmdstats, uint64_t usecs) {
+  auto& allstats = cmdstats_["*"];
+  INCRBY(cmdstats->calls, 1);
+  INCRBY(cmdstats->usecs, usecs);
+  INCRBY(allstats.calls, 1);
+  INCRBY(allstats.usecs, usecs);
   // Slowlogs
   if (usecs > (uint64_t) options_.slowlogs_slower_than_usecs) {
+    std::vector<std::string> args;
+    for (const auto& arg : request.args()) {
+      args.push_back(arg.ToString());
+    }
     std::unique_lock<std::mutex> lock(slowlogs_lock_);
-    slowlogs_.push_front({slowlogs_id_++, usecs, request, time(NULL)});
+    slowlogs_.push_front({slowlogs_id_++, usecs, std::move(args), time(NULL)});
     while (slowlogs_.size() > (size_t) options_.slowlogs_maxlen) {
       slowlogs_.pop_back();
     }
-    INCRBY(cmdstats_[cmd].slows, 1);
-    INCRBY(cmdstats_["*"].slows, 1);
+    INCRBY(cmdstats->slows, 1);
+    INCRBY(allstats.slows, 1);
   }
 }
 
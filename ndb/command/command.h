@@ -19,7 +19,8 @@ class Command {
   struct Slowlog {
     uint64_t id;
     uint64_t usecs;
-    Request request;
+    // Copy arguments, don't keep request's buffer alive.
+    std::vector<std::string> args;
     time_t timestamp;
   };
 
@@ -31,6 +32,10 @@ class Command {
 
   Client* ProcessClient(Client* client);
 
+  // Hash the key of the request, return false if the request
+  // does not have exactly one key.
+  bool HashRequest(const Request& request, uint64_t* hash) const;
+
   std::deque<Slowlog> GetSlowlogs();
 
   Stats GetStats(const std::string& cmd = "") const;
@@ -38,7 +43,13 @@ class Command {
  private:
   Response ProcessRequest(const Request& request);
 
-  void UpdateCmdStats(const Request& request, uint64_t usecs);
+  struct CmdStats {
+    std::atomic<uint64_t> calls {0};
+    std::atomic<uint64_t> usecs {0};
+    std::atomic<uint64_t> slows {0};
+  };
+
+  void UpdateCmdStats(const Request& request, CmdStats* cmdstats, uint64_t usecs);
 
  private:
   Options options_;
@@ -53,14 +64,12 @@ class Command {
     Response (*func)(const Request& request);
     const char* mode;
     int argc;
+    CmdStats* stats;
+    // The only key is args(1).
+    bool keyed;
   };
-  std::map<std::string, Cmd> cmds_;
-
-  struct CmdStats {
-    std::atomic<uint64_t> calls {0};
-    std::atomic<uint64_t> usecs {0};
-    std::atomic<uint64_t> slows {0};
-  };
+  // Commands are looked up by the argument directly.
+  std::map<Slice, Cmd, SliceLess> cmds_;
   std::map<std::string, CmdStats> cmdstats_;
 };
 
@@ -7,16 +7,26 @@ namespace hash {
 #define NDB_TRY_GETMETA_BYKEY(k, ns, kmeta, vmeta)                  \
   NDB_TRY_GETMETA_TYPE_BYKEY(k, ns, kmeta, vmeta, Meta::HASH)
 
-std::string EncodePrefix(const Slice& kmeta, uint64_t version) {
-  return ndb::EncodePrefix(kmeta, version, Meta::HASH, 1);
+std::string EncodePrefix(const Slice& kmeta, const Meta& meta) {
+  return ndb::EncodePrefix(kmeta, meta, Meta::HASH, 1);
 }
 
-std::string EncodeMember(const Slice& kmeta, uint64_t version, const Slice& field) {
-  std::string dst = EncodePrefix(kmeta, version);
+std::string EncodeMember(const Slice& kmeta, const Meta& meta, const Slice& field) {
+  std::string dst = EncodePrefix(kmeta, meta);
   dst.append(field.data(), field.size());
   return dst;
 }
 
+void Unpack(NSBatch* batch, const Slice& kmeta, const Meta& meta,
+            const Slice& field, const Slice& value) {
+  batch->Put(EncodeMember(kmeta, meta, field), value);
+}
+
+#define NDB_HASH_MEMBERS(members)                                   \
+  Members members(ns, configs, kmeta, &vmeta,                       \
+                  hash::EncodeMember, hash::Unpack);                \
+  NDB_TRY(members.Load())
+
 }  // namespace hash
 
 // HGET key field
@@ -25,28 +35,25 @@ Response CommandHGET(const Request& request) {
   if (length == 0) return Response::Null();
 
   Value value;
-  auto member = hash::EncodeMember(kmeta, version, request.args(2));
-  NDB_TRY(ns->Get(member, &value));
+  NDB_TRY(GetMember(ns, kmeta, vmeta, request.args(2), hash::EncodeMember, &value));
   return ConvertValueToBulk(value);
 }
 
 // HMGET key field [field ...]
 Response CommandHMGET(const Request& request) {
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_HASH_MEMBERS(members);
 
-  std::vector<std::string> members;
-  for (size_t i = 2; i < request.argc(); i++) {
-    members.push_back(hash::EncodeMember(kmeta, version, request.args(i)));
-  }
-
-  std::vector<Value> values;
-  auto results = ns->MultiGet(members, &values);
+  std::vector<Slice> fields(request.args().begin() + 2, request.args().end());
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> values;
+  auto results = members.MultiGet(fields, &pins, &values);
   auto res = Response::Size(results.size());
   for (size_t i = 0; i < results.size(); i++) {
     const auto& v = values[i];
     const auto& r = results[i];
     if (r.ok()) {
-      res.Append(ConvertValueToBulk(v));
+      AppendValueToBulk(v, &res);
     } else {
       res.Append(r);
     }
@@ -57,10 +64,11 @@ Response CommandHMGET(const Request& request) {
 Response GenericHSET(const Request& request, bool not_exists) {
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_HASH_MEMBERS(members);
+  NDB_COMMAND_NEW_COLLECTION(members, kmeta, vmeta);
 
   int64_t count = 0;
-  auto member = hash::EncodeMember(kmeta, version, request.args(2));
-  auto r = ns->Get(member, NULL);
+  auto r = members.Get(request.args(2), NULL);
   if (r.IsNotFound()) {
     count++;
   } else if (!r.ok()) {
@@ -72,10 +80,8 @@ Response GenericHSET(const Request& request, bool not_exists) {
   NDB_COMMAND_UPDATE_LENGTH(vmeta, +count);
   vmeta.SetConfigs(configs);
 
-  NSBatch batch(ns);
-  batch.Put(member, Value::FromBytes(request.args(3)));
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  members.Put(request.args(2), Value::FromBytes(request.args(3)));
+  NDB_TRY(members.Commit());
   return Response::Int(count);
 }
 
@@ -96,24 +102,27 @@ Response CommandHMSET(const Request& request) {
   }
 
   // Remove duplication.
-  std::map<std::string, Slice> kv;
+  std::map<Slice, Slice, SliceLess> kv;
   for (size_t i = 2; i < request.argc(); i += 2) {
     kv[request.args(i)] = request.args(i+1);
   }
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_HASH_MEMBERS(members);
+  NDB_COMMAND_NEW_COLLECTION(members, kmeta, vmeta);
 
-  std::vector<std::string> members;
+  std::vector<Slice> fields;
   std::vector<Slice> values;
   for (const auto& it : kv) {
-    members.push_back(hash::EncodeMember(kmeta, version, it.first));
+    fields.push_back(it.first);
     values.push_back(it.second);
   }
 
-  NSBatch batch(ns);
   uint64_t count = 0;
-  auto results = ns->MultiGet(members, NULL);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> views;
+  auto results = members.MultiGet(fields, &pins, &views);
   for (size_t i = 0; i < results.size(); i++) {
     const auto& r = results[i];
     if (r.IsNotFound()) {
@@ -121,38 +130,34 @@ Response CommandHMSET(const Request& request) {
     } else if (!r.ok()) {
       return r;
     }
-    batch.Put(members[i], Value::FromBytes(values[i]));
+    members.Put(fields[i], Value::FromBytes(values[i]));
   }
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, +count);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::OK();
 }
 
 // HDEL key field [field ...]
 Response CommandHDEL(const Request& request) {
   // Remove duplication.
-  std::set<std::string> fields(request.args().begin() + 2, request.args().end());
+  std::set<Slice, SliceLess> fields(request.args().begin() + 2, request.args().end());
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Int(0);
+  NDB_HASH_MEMBERS(members);
 
-  std::vector<std::string> members;
-  for (const auto& field : fields) {
-    members.push_back(hash::EncodeMember(kmeta, version, field));
-  }
-
-  NSBatch batch(ns);
+  std::vector<Slice> keys(fields.begin(), fields.end());
   uint64_t count = 0;
-  auto results = ns->MultiGet(members, NULL);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> views;
+  auto results = members.MultiGet(keys, &pins, &views);
   for (size_t i = 0; i < results.size(); i++) {
-    const auto& m = members[i];
     const auto& r = results[i];
     if (r.ok()) {
-      batch.Delete(m);
+      members.Delete(keys[i]);
       count++;
     } else if (!r.IsNotFound()) {
       return r;
@@ -161,8 +166,7 @@ Response CommandHDEL(const Request& request) {
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, -count);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Int(count);
 }
 
@@ -171,8 +175,7 @@ Response CommandHEXISTS(const Request& request) {
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Int(0);
 
-  auto member = hash::EncodeMember(kmeta, version, request.args(2));
-  auto r = ns->Get(member, NULL);
+  auto r = GetMember(ns, kmeta, vmeta, request.args(2), hash::EncodeMember, NULL);
   if (r.ok()) return Response::Int(1);
   if (r.IsNotFound()) return Response::Int(0);
   return r;
@@ -184,8 +187,7 @@ Response CommandHSTRLEN(const Request& request) {
   if (length == 0) return Response::Int(0);
 
   Value value;
-  auto member = hash::EncodeMember(kmeta, version, request.args(2));
-  auto r = ns->Get(member, &value);
+  auto r = GetMember(ns, kmeta, vmeta, request.args(2), hash::EncodeMember, &value);
   if (r.ok()) {
     auto size = 0;
     if (value.has_int64()) {
@@ -211,10 +213,11 @@ Response CommandHINCRBY(const Request& request) {
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_HASH_MEMBERS(members);
+  NDB_COMMAND_NEW_COLLECTION(members, kmeta, vmeta);
 
   Value value;
-  auto member = hash::EncodeMember(kmeta, version, request.args(2));
-  auto r = ns->Get(member, &value);
+  auto r = members.Get(request.args(2), &value);
   if (r.IsNotFound()) {
     value.set_int64(0);
     NDB_COMMAND_UPDATE_LENGTH(vmeta, +1);
@@ -230,12 +233,10 @@ Response CommandHINCRBY(const Request& request) {
     return Response::OutofRange();
   }
 
-  NSBatch batch(ns);
   value.set_int64(origin + increment);
-  batch.Put(member, value);
+  members.Put(request.args(2), value);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Int(value.int64());
 }
 
@@ -249,10 +250,33 @@ Response GenericHGETALL(const Request& request, bool with_fields, bool with_valu
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Size(0);
 
-  auto begin = hash::EncodePrefix(kmeta, version);
-  auto end = FindNextSuccessor(begin);
   auto res = Response::Size((with_fields + with_values) * length);
+  if (vmeta.meta().has_packed()) {
+    // All members are in the meta.
+    Slice in = vmeta.meta().packed(), field, v;
+    for (; in.size() > 0; length--) {
+      if (!PackedMembers::Next(&in, &field, &v)) {
+        return NDB_COMMAND_ERROR("corruption");
+      }
+      if (with_fields) {
+        res.AppendBulk(field.data(), field.size());
+      }
+      if (with_values) {
+        ValueView value;
+        NDB_TRY(value.Decode(v));
+        AppendValueToBulk(value, &res);
+      }
+    }
+    if (length != 0) {
+      return NDB_COMMAND_ERROR("corruption");
+    }
+    return res;
+  }
+
+  auto begin = hash::EncodePrefix(kmeta, vmeta.meta());
+  auto end = FindNextSuccessor(begin);
 
+  size_t mark = res.size();
   auto it = ns->RangeGet(begin, end, 0, length);
   for (it->Seek(); it->Valid(); it->Next(), length--) {
     if (with_fields) {
@@ -263,9 +287,14 @@ Response GenericHGETALL(const Request& request, bool with_fields, bool with_valu
       res.AppendBulk(field.data(), field.size());
     }
     if (with_values) {
-      Value value;
+      ValueView value;
       NDB_TRY(value.Decode(it->value()));
-      res.Append(ConvertValueToBulk(value));
+      AppendValueToBulk(value, &res);
+    }
+    if (mark != 0) {
+      // Estimate the reply by the first element.
+      res.ReserveMore(mark, length - 1);
+      mark = 0;
     }
   }
   NDB_TRY(it->result());
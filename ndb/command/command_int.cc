@@ -42,6 +42,24 @@ Response CommandINCRBY(const Request& request) {
   return GenericINCRBY(request, increment);
 }
 
+// INCRBYNR key increment
+// Increment without reply of the new value, so it merges blindly without
+// read. Increments on non-integers or overflow are dropped. The key is still
+// locked, so read-modify-writes like INCRBY never overwrite the merge.
+Response CommandINCRBYNR(const Request& request) {
+  int64_t increment = 0;
+  if (!ParseInt64(request.args(2), &increment)) {
+    return Response::InvalidArgument();
+  }
+  NDB_LOCK_KEY(request.args(1));
+  NDB_TRY_GETNS_BYKEY(request.args(1), ns, id);
+
+  auto value = Value::FromInt64(increment);
+  value.SetConfigs(configs);
+  NDB_TRY(ns->Merge(id, value));
+  return Response::OK();
+}
+
 // DECR key
 Response CommandDECR(const Request& request) {
   return GenericINCRBY(request, -1);
@@ -70,10 +70,14 @@ Response CommandKEYS(const Request& request) {
 
 // EXISTS key [key ...]
 Response CommandEXISTS(const Request& request) {
+  // Meta keys need a null-terminated copy of the key.
+  std::vector<std::string> ids;
+  ids.reserve(request.argc());
   std::vector<Slice> keys;
   for (size_t i = 1; i < request.argc(); i++) {
+    ids.push_back(request.args(i).ToString());
     keys.push_back(request.args(i));
-    keys.push_back(EncodeMeta(request.args(i)));
+    keys.push_back(EncodeMeta(ids.back()));
   }
 
   uint64_t count = 0;
@@ -92,10 +96,14 @@ Response CommandEXISTS(const Request& request) {
 
 // DEL key [key ...]
 Response CommandDEL(const Request& request) {
+  // Meta keys need a null-terminated copy of the key.
+  std::vector<std::string> ids;
+  ids.reserve(request.argc());
   std::vector<Slice> keys;
   for (size_t i = 1; i < request.argc(); i++) {
+    ids.push_back(request.args(i).ToString());
     keys.push_back(request.args(i));
-    keys.push_back(EncodeMeta(request.args(i)));
+    keys.push_back(EncodeMeta(ids.back()));
   }
 
   NDB_LOCK_KEY(keys);
@@ -103,6 +111,14 @@ Response CommandDEL(const Request& request) {
   Batch batch(ndb->engine);
   uint64_t count = 0;
   std::vector<Value> values;
+  // Members of deleted collections are freed after commit.
+  struct Free {
+    NSRef ns;
+    std::string kmeta;
+    uint64_t version;
+    uint64_t cid;
+  };
+  std::vector<Free> frees;
   auto results = GenericMGET(ndb->engine, keys, &values);
   for (size_t i = 0; i < results.size(); i++) {
     auto& k = keys[i];
@@ -117,8 +133,13 @@ Response CommandDEL(const Request& request) {
 
     NDB_TRY_GETNS_BYKEY(k, ns, id);
     if (v.has_meta()) {
-      v.mutable_meta()->set_deleted(true);
+      auto meta = v.mutable_meta();
+      meta->set_deleted(true);
+      // Packed members are deleted with the meta.
+      bool packed = meta->has_packed();
+      meta->clear_packed();
       batch.Put(ns, id, v);
+      if (!packed) frees.push_back({ns, id, meta->version(), meta->cid()});
     } else {
       batch.Delete(ns, id);
     }
@@ -127,6 +148,9 @@ Response CommandDEL(const Request& request) {
   }
 
   NDB_TRY(batch.Commit());
+  for (const auto& free : frees) {
+    ndb->lazyfree->Free(free.ns, free.kmeta, free.version, free.cid);
+  }
   return Response::Int(count);
 }
 
@@ -13,12 +13,12 @@ namespace list {
   auto minindex = vmeta.meta().minindex();                          \
   auto maxindex = vmeta.meta().maxindex()
 
-std::string EncodePrefix(const Slice& kmeta, uint64_t version) {
-  return ndb::EncodePrefix(kmeta, version, Meta::LIST, 1);
+std::string EncodePrefix(const Slice& kmeta, const Meta& meta) {
+  return ndb::EncodePrefix(kmeta, meta, Meta::LIST, 1);
 }
 
-std::string EncodeMember(const Slice& kmeta, uint64_t version, uint64_t index) {
-  std::string dst = EncodePrefix(kmeta, version);
+std::string EncodeMember(const Slice& kmeta, const Meta& meta, uint64_t index) {
+  std::string dst = EncodePrefix(kmeta, meta);
   EncodeUint64(&dst, index);
   return dst;
 }
@@ -46,18 +46,19 @@ Response GenericLPUSH(const Request& request, bool exists, bool reverse) {
   if (length == 0 && exists) return Response::Int(0);
 
   NSBatch batch(ns);
+  NDB_COMMAND_NEW_COLLECTION(batch, kmeta, vmeta);
   int64_t count = request.argc() - 2;
   if (!reverse) {
     if (length > 0) minindex--;
     for (size_t i = 2; i < request.argc(); i++) {
-      auto member = list::EncodeMember(kmeta, version, minindex--);
+      auto member = list::EncodeMember(kmeta, vmeta.meta(), minindex--);
       batch.Put(member, Value::FromBytes(request.args(i)));
     }
     vmeta.mutable_meta()->set_minindex(minindex + 1);
   } else {
     if (length > 0) maxindex++;
     for (size_t i = 2; i < request.argc(); i++) {
-      auto member = list::EncodeMember(kmeta, version, maxindex++);
+      auto member = list::EncodeMember(kmeta, vmeta.meta(), maxindex++);
       batch.Put(member, Value::FromBytes(request.args(i)));
     }
     vmeta.mutable_meta()->set_maxindex(maxindex - 1);
@@ -96,8 +97,8 @@ Response GenericLPOP(const Request& request, bool reverse) {
   // Return nil if not exists.
   if (length == 0) return Response::Null();
 
-  auto begin = list::EncodeMember(kmeta, version, minindex);
-  auto end = list::EncodeMember(kmeta, version, maxindex);
+  auto begin = list::EncodeMember(kmeta, vmeta.meta(), minindex);
+  auto end = list::EncodeMember(kmeta, vmeta.meta(), maxindex);
   auto it = ns->RangeGet(begin, end, 0, UINT64_MAX, reverse);
 
   it->Seek();
@@ -152,15 +153,15 @@ Response CommandLREM(const Request& request) {
     count = -count;
   }
 
-  auto begin = list::EncodeMember(kmeta, version, minindex);
-  auto end = list::EncodeMember(kmeta, version, maxindex);
+  auto begin = list::EncodeMember(kmeta, vmeta.meta(), minindex);
+  auto end = list::EncodeMember(kmeta, vmeta.meta(), maxindex);
   auto it = ns->RangeGet(begin, end, 0, UINT64_MAX, reverse);
 
   NSBatch batch(ns);
   bool is_first = false;
   int64_t deleted_count = 0;
   for (it->Seek(); it->Valid(); it->Next()) {
-    Value value;
+    ValueView value;
     NDB_TRY(value.Decode(it->value()));
     if (value.has_bytes() && value.bytes() == request.args(3)) {
       batch.Delete(it->id());
@@ -222,8 +223,8 @@ Response CommandLTRIM(const Request& request) {
   NSBatch batch(ns);
 
   if (CheckLimit(length, &start, &stop)) {
-    auto begin = list::EncodeMember(kmeta, version, minindex);
-    auto end = list::EncodeMember(kmeta, version, maxindex);
+    auto begin = list::EncodeMember(kmeta, vmeta.meta(), minindex);
+    auto end = list::EncodeMember(kmeta, vmeta.meta(), maxindex);
     // Trim left
     auto res = InternalLTRIM(ns, batch, vmeta, begin, end, start, false);
     if (!res.IsOK()) return res;
@@ -258,8 +259,8 @@ Response CommandLSET(const Request& request) {
     index = length - index - 1;
   }
 
-  auto begin = list::EncodeMember(kmeta, version, minindex);
-  auto end = list::EncodeMember(kmeta, version, maxindex);
+  auto begin = list::EncodeMember(kmeta, vmeta.meta(), minindex);
+  auto end = list::EncodeMember(kmeta, vmeta.meta(), maxindex);
   auto it = ns->RangeGet(begin, end, index, 1, reverse);
 
   it->Seek();
@@ -288,8 +289,8 @@ Response CommandLINDEX(const Request& request) {
     index = length - index - 1;
   }
 
-  auto begin = list::EncodeMember(kmeta, version, minindex);
-  auto end = list::EncodeMember(kmeta, version, maxindex);
+  auto begin = list::EncodeMember(kmeta, vmeta.meta(), minindex);
+  auto end = list::EncodeMember(kmeta, vmeta.meta(), maxindex);
   auto it = ns->RangeGet(begin, end, index, 1, reverse);
 
   it->Seek();
@@ -318,15 +319,21 @@ Response CommandLRANGE(const Request& request) {
   }
 
   int64_t offset = start, count = stop - start + 1;
-  auto begin = list::EncodeMember(kmeta, version, minindex);
-  auto end = list::EncodeMember(kmeta, version, maxindex);
+  auto begin = list::EncodeMember(kmeta, vmeta.meta(), minindex);
+  auto end = list::EncodeMember(kmeta, vmeta.meta(), maxindex);
   auto it = ns->RangeGet(begin, end, offset, count);
 
   auto res = Response::Size(count);
+  size_t mark = res.size();
   for (it->Seek(); it->Valid(); it->Next(), count--) {
-    Value value;
+    ValueView value;
     NDB_TRY(value.Decode(it->value()));
-    res.Append(ConvertValueToBulk(value));
+    AppendValueToBulk(value, &res);
+    if (mark != 0) {
+      // Estimate the reply by the first element.
+      res.ReserveMore(mark, count - 1);
+      mark = 0;
+    }
   }
   if (count != 0) {
     NDB_LOG_ERROR("*COMMAND* LRANGE namespace %s id %s count %lld",
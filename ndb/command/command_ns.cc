@@ -4,53 +4,139 @@ namespace ndb {
 
 // NSNEW namespace
 Response CommandNSNEW(const Request& request) {
-  return ndb->engine->NewNamespace(request.args(1));
+  return ndb->engine->NewNamespace(request.args(1).ToString());
 }
 
 // NSDEL namespace
 Response CommandNSDEL(const Request& request) {
-  return ndb->engine->DropNamespace(request.args(1));
+  return ndb->engine->DropNamespace(request.args(1).ToString());
+}
+
+// Compressions are formatted as [none,lz4,zstd], one for each level.
+static std::string FormatCompressions(const Configs& configs) {
+  std::string s;
+  for (auto compression : configs.compression()) {
+    if (s.size() > 0) s.append(",");
+    s.append(CompressionName(static_cast<Compression>(compression)));
+  }
+  return s;
+}
+
+static bool ParseCompressions(const Slice& s, Configs* configs) {
+  configs->clear_compression();
+  std::stringstream ss(s.ToString());
+  std::string name;
+  while (std::getline(ss, name, ',')) {
+    Compression compression;
+    if (!ParseCompression(name.c_str(), &compression)) {
+      return false;
+    }
+    configs->add_compression(compression);
+  }
+  return configs->compression_size() > 0;
 }
 
 // NSGET namespace name
 Response CommandNSGET(const Request& request) {
-  auto ns = NDB_TRY_GETNS(request.args(1));
+  auto ns = NDB_TRY_GETNS(request.args(1).ToString());
   auto configs = ns->GetConfigs();
 
-  auto name = request.args(2).c_str();
-  if (strcasecmp(name, "expire") == 0) {
+  const auto& name = request.args(2);
+  if (EqualsIgnoreCase(name, "expire")) {
     return Response::Bulk(configs.expire());
   }
-  if (strcasecmp(name, "maxlen") == 0) {
+  if (EqualsIgnoreCase(name, "maxlen")) {
     return Response::Bulk(configs.maxlen());
   }
-  if (strcasecmp(name, "pruning") == 0) {
+  if (EqualsIgnoreCase(name, "pruning")) {
     return Response::Bulk(PruningName(configs.pruning()));
   }
+  if (EqualsIgnoreCase(name, "block_size")) {
+    return Response::Bulk(configs.block_size());
+  }
+  if (EqualsIgnoreCase(name, "bloom_bits")) {
+    return Response::Bulk(configs.bloom_bits());
+  }
+  if (EqualsIgnoreCase(name, "compression")) {
+    return Response::Bulk(FormatCompressions(configs));
+  }
+  if (EqualsIgnoreCase(name, "memtable_size")) {
+    return Response::Bulk(configs.memtable_size());
+  }
+  if (EqualsIgnoreCase(name, "data_block_hash_index")) {
+    return Response::Bulk(configs.data_block_hash_index() ? 1 : 0);
+  }
+  if (EqualsIgnoreCase(name, "cache_priority")) {
+    return Response::Bulk(CachePriorityName(configs.cache_priority()));
+  }
+  if (EqualsIgnoreCase(name, "value_cache_size")) {
+    return Response::Bulk(configs.value_cache_size());
+  }
+  if (EqualsIgnoreCase(name, "durability")) {
+    return Response::Bulk(DurabilityName(configs.durability()));
+  }
+  if (EqualsIgnoreCase(name, "packed_entries")) {
+    return Response::Bulk(configs.packed_entries());
+  }
+  if (EqualsIgnoreCase(name, "packed_value_size")) {
+    return Response::Bulk(configs.packed_value_size());
+  }
   return Response::InvalidArgument();
 }
 
 // NSSET namespace name value
+// Column family options except memtable_size take effect after restart,
+// value_cache_size, durability and packed configs take effect immediately.
 Response CommandNSSET(const Request& request) {
-  auto ns = NDB_TRY_GETNS(request.args(1));
+  auto ns = NDB_TRY_GETNS(request.args(1).ToString());
   auto configs = ns->GetConfigs();
 
-  auto name = request.args(2).c_str();
-  if (strcasecmp(name, "pruning") == 0) {
+  const auto& name = request.args(2);
+  if (EqualsIgnoreCase(name, "pruning")) {
     Pruning pruning;
     if (!ParsePruning(request.args(3), &pruning)) {
       return Response::InvalidArgument();
     }
     configs.set_pruning(pruning);
+  } else if (EqualsIgnoreCase(name, "compression")) {
+    if (!ParseCompressions(request.args(3), &configs)) {
+      return Response::InvalidArgument();
+    }
+  } else if (EqualsIgnoreCase(name, "cache_priority")) {
+    CachePriority priority;
+    if (!ParseCachePriority(request.args(3).ToString().c_str(), &priority)) {
+      return Response::InvalidArgument();
+    }
+    configs.set_cache_priority(priority);
+  } else if (EqualsIgnoreCase(name, "durability")) {
+    Durability durability;
+    if (!ParseDurability(request.args(3).ToString().c_str(), &durability)) {
+      return Response::InvalidArgument();
+    }
+    configs.set_durability(durability);
   } else {
     uint64_t value = 0;
     if (!ParseUint64(request.args(3), &value)) {
       return Response::InvalidArgument();
     }
-    if (strcasecmp(name, "expire") == 0) {
+    if (EqualsIgnoreCase(name, "expire")) {
       configs.set_expire(value);
-    } else if (strcasecmp(name, "maxlen") == 0) {
+    } else if (EqualsIgnoreCase(name, "maxlen")) {
       configs.set_maxlen(value);
+    } else if (EqualsIgnoreCase(name, "block_size")) {
+      configs.set_block_size(value);
+    } else if (EqualsIgnoreCase(name, "bloom_bits")) {
+      configs.set_bloom_bits(value);
+    } else if (EqualsIgnoreCase(name, "memtable_size")) {
+      configs.set_memtable_size(value);
+    } else if (EqualsIgnoreCase(name, "data_block_hash_index")) {
+      configs.set_data_block_hash_index(value != 0);
+    } else if (EqualsIgnoreCase(name, "value_cache_size")) {
+      configs.set_value_cache_size(value);
+    } else if (EqualsIgnoreCase(name, "packed_entries")) {
+      configs.set_packed_entries(value);
+    } else if (EqualsIgnoreCase(name, "packed_value_size")) {
+      configs.set_packed_value_size(value);
     } else {
       return Response::InvalidArgument();
     }
@@ -7,12 +7,12 @@ namespace oset {
 #define NDB_TRY_GETMETA_BYKEY(k, ns, kmeta, vmeta)                  \
   NDB_TRY_GETMETA_TYPE_BYKEY(k, ns, kmeta, vmeta, Meta::OSET)
 
-std::string EncodePrefix(const Slice& kmeta, uint64_t version) {
-  return ndb::EncodePrefix(kmeta, version, Meta::OSET, 1);
+std::string EncodePrefix(const Slice& kmeta, const Meta& meta) {
+  return ndb::EncodePrefix(kmeta, meta, Meta::OSET, 1);
 }
 
-std::string EncodeMember(const Slice& kmeta, uint64_t version, int64_t field) {
-  std::string dst = EncodePrefix(kmeta, version);
+std::string EncodeMember(const Slice& kmeta, const Meta& meta, int64_t field) {
+  std::string dst = EncodePrefix(kmeta, meta);
   EncodeInt64(&dst, field);
   return dst;
 }
@@ -51,8 +51,8 @@ Response GenericOREMRANGEBYRANK(const Request& request, int64_t start, int64_t s
   }
 
   NSBatch batch(ns);
-  auto begin = oset::EncodeMember(kmeta, version, INT64_MIN);
-  auto end = oset::EncodeMember(kmeta, version, INT64_MAX);
+  auto begin = oset::EncodeMember(kmeta, vmeta.meta(), INT64_MIN);
+  auto end = oset::EncodeMember(kmeta, vmeta.meta(), INT64_MAX);
   auto it = ns->RangeGet(begin, end, offset, count, reverse);
   for (it->Seek(), count = 0; it->Valid(); it->Next(), count++) {
     batch.Delete(it->id());
@@ -73,14 +73,14 @@ Response CommandOADD(const Request& request) {
   // Parse options.
   Configs options;
   for (auto i = idx; i < request.argc(); i++) {
-    auto opt = request.args(i).c_str();
-    if (strcasecmp(opt, "MAXLEN") == 0 || strcasecmp(opt, "FINITY") == 0) {
+    const auto& opt = request.args(i);
+    if (EqualsIgnoreCase(opt, "MAXLEN") || EqualsIgnoreCase(opt, "FINITY")) {
       uint64_t maxlen = 0;
       if (++i == request.argc() || !ParseUint64(request.args(i), &maxlen)) {
         return Response::InvalidArgument();
       }
       options.set_maxlen(maxlen);
-    } else if (strcasecmp(opt, "PRUNING") == 0) {
+    } else if (EqualsIgnoreCase(opt, "PRUNING")) {
       Pruning pruning;
       if (++i == request.argc() || !ParsePruning(request.args(i), &pruning)) {
         return Response::InvalidArgument();
@@ -101,12 +101,14 @@ Response CommandOADD(const Request& request) {
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
 
+  NSBatch batch(ns);
+  NDB_COMMAND_NEW_COLLECTION(batch, kmeta, vmeta);
+
   std::vector<std::string> members;
   for (const auto& field : fields) {
-    members.push_back(oset::EncodeMember(kmeta, version, field));
+    members.push_back(oset::EncodeMember(kmeta, vmeta.meta(), field));
   }
 
-  NSBatch batch(ns);
   uint64_t count = 0;
   auto results = ns->MultiGet(members, NULL);
   for (size_t i = 0; i < results.size(); i++) {
@@ -147,7 +149,7 @@ Response CommandOREM(const Request& request) {
 
   std::vector<std::string> members;
   for (const auto& field : fields) {
-    members.push_back(oset::EncodeMember(kmeta, version, field));
+    members.push_back(oset::EncodeMember(kmeta, vmeta.meta(), field));
   }
 
   NSBatch batch(ns);
@@ -196,8 +198,8 @@ Response GenericORANGEGET(const Request& request,
 
   std::vector<int64_t> fields;
   uint64_t offset = start, count = stop - start + 1;
-  auto begin = oset::EncodeMember(kmeta, version, min);
-  auto end = oset::EncodeMember(kmeta, version, max);
+  auto begin = oset::EncodeMember(kmeta, vmeta.meta(), min);
+  auto end = oset::EncodeMember(kmeta, vmeta.meta(), max);
 
   auto it = ns->RangeGet(begin, end, offset, count, reverse);
   for (it->Seek(); it->Valid(); it->Next()) {
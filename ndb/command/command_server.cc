@@ -14,34 +14,38 @@ Response CommandECHO(const Request& request) {
 
 // INFO section [name]
 Response CommandINFO(const Request& request) {
-  auto name = request.args(1).c_str();
+  const auto& name = request.args(1);
 
   Stats stats;
-  if (strcasecmp(name, "engine") == 0) {
+  if (EqualsIgnoreCase(name, "engine")) {
     if (request.argc() == 2) {
       stats = ndb->engine->GetStats();
     } else {
-      auto ns = NDB_TRY_GETNS(request.args(2));
+      auto ns = NDB_TRY_GETNS(request.args(2).ToString());
       stats = ns->GetStats();
     }
-  } else if (strcasecmp(name, "backup") == 0) {
+  } else if (EqualsIgnoreCase(name, "backup")) {
     stats = ndb->engine->GetBackup()->GetStats();
-  } else if (strcasecmp(name, "server") == 0) {
+  } else if (EqualsIgnoreCase(name, "server")) {
     stats = ndb->server->GetStats();
-  } else if (strcasecmp(name, "replica") == 0) {
+  } else if (EqualsIgnoreCase(name, "replica")) {
     stats = ndb->replica->GetStats();
-  } else if (strcasecmp(name, "command") == 0) {
+  } else if (EqualsIgnoreCase(name, "expirer")) {
+    stats = ndb->expirer->GetStats();
+  } else if (EqualsIgnoreCase(name, "lazyfree")) {
+    stats = ndb->lazyfree->GetStats();
+  } else if (EqualsIgnoreCase(name, "command")) {
     if (request.argc() == 2) {
       stats = ndb->command->GetStats();
     } else {
-      auto cmd = stoupper(request.args(2));
+      auto cmd = stoupper(request.args(2).ToString());
       stats = ndb->command->GetStats(cmd);
     }
-  } else if (strcasecmp(name, "nsstats") == 0) {
+  } else if (EqualsIgnoreCase(name, "nsstats")) {
     if (request.argc() == 2) {
       stats = nsstats.GetStats();
     } else {
-      stats = nsstats.GetStats(request.args(2));
+      stats = nsstats.GetStats(request.args(2).ToString());
     }
   } else {
     return Response::InvalidArgument();
@@ -49,7 +53,7 @@ Response CommandINFO(const Request& request) {
 
   std::string info;
   info.append("# ");
-  info.append(name);
+  info.append(name.data(), name.size());
   info.append("\r\n");
   info.append(stats.Print());
   return Response::Bulk(info);
@@ -57,9 +61,9 @@ Response CommandINFO(const Request& request) {
 
 // BACKUP backup
 Response CommandBACKUP(const Request& request) {
-  auto dbname = request.args(1).c_str();
+  auto dbname = request.args(1).ToString();
   auto backup = ndb->engine->GetBackup();
-  if (strcasecmp(dbname, "STOP") == 0) {
+  if (EqualsIgnoreCase(dbname, "STOP")) {
     backup->Stop();
     return Response::OK();
   }
@@ -68,7 +72,7 @@ Response CommandBACKUP(const Request& request) {
 
 // COMPACT namespace begin end
 Response CommandCOMPACT(const Request& request) {
-  auto ns = NDB_TRY_GETNS(request.args(1));
+  auto ns = NDB_TRY_GETNS(request.args(1).ToString());
   Slice begin, end;
   if (request.argc() >= 3) begin = request.args(2);
   if (request.argc() >= 4) end = request.args(3);
@@ -79,12 +83,12 @@ Response CommandCOMPACT(const Request& request) {
 Response CommandSLOWLOG(const Request& request) {
   auto slowlogs = ndb->command->GetSlowlogs();
 
-  auto name = request.args(1).c_str();
-  if (strcasecmp(name, "LEN") == 0) {
+  const auto& name = request.args(1);
+  if (EqualsIgnoreCase(name, "LEN")) {
     return Response::Int(slowlogs.size());
   }
 
-  if (strcasecmp(name, "GET") == 0) {
+  if (EqualsIgnoreCase(name, "GET")) {
     uint64_t count = slowlogs.size();
     if (request.argc() == 3) {
       if (!ParseUint64(request.args(2), &count)) {
@@ -99,7 +103,7 @@ Response CommandSLOWLOG(const Request& request) {
       res.AppendInt(it->id);
       res.AppendInt(it->timestamp);
       res.AppendInt(it->usecs);
-      res.AppendBulks(it->request.args());
+      res.AppendBulks(it->args);
     }
     return res;
   }
@@ -7,39 +7,47 @@ namespace set {
 #define NDB_TRY_GETMETA_BYKEY(k, ns, kmeta, vmeta)                  \
   NDB_TRY_GETMETA_TYPE_BYKEY(k, ns, kmeta, vmeta, Meta::SET)
 
-std::string EncodePrefix(const Slice& kmeta, uint64_t version) {
-  return ndb::EncodePrefix(kmeta, version, Meta::SET, 1);
+std::string EncodePrefix(const Slice& kmeta, const Meta& meta) {
+  return ndb::EncodePrefix(kmeta, meta, Meta::SET, 1);
 }
 
-std::string EncodeMember(const Slice& kmeta, uint64_t version, const Slice& field) {
-  std::string dst = EncodePrefix(kmeta, version);
+std::string EncodeMember(const Slice& kmeta, const Meta& meta, const Slice& field) {
+  std::string dst = EncodePrefix(kmeta, meta);
   dst.append(field.data(), field.size());
   return dst;
 }
 
+void Unpack(NSBatch* batch, const Slice& kmeta, const Meta& meta,
+            const Slice& field, const Slice& value) {
+  batch->Put(EncodeMember(kmeta, meta, field), value);
+}
+
+#define NDB_SET_MEMBERS(members)                                    \
+  Members members(ns, configs, kmeta, &vmeta,                       \
+                  set::EncodeMember, set::Unpack);                  \
+  NDB_TRY(members.Load())
+
 }  // namespace set
 
 // SADD key field [field ...]
 Response CommandSADD(const Request& request) {
   // Remove duplication.
-  std::set<std::string> fields(request.args().begin() + 2, request.args().end());
+  std::set<Slice, SliceLess> fields(request.args().begin() + 2, request.args().end());
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_SET_MEMBERS(members);
+  NDB_COMMAND_NEW_COLLECTION(members, kmeta, vmeta);
 
-  std::vector<std::string> members;
-  for (const auto& field : fields) {
-    members.push_back(set::EncodeMember(kmeta, version, field));
-  }
-
-  NSBatch batch(ns);
+  std::vector<Slice> keys(fields.begin(), fields.end());
   uint64_t count = 0;
-  auto results = ns->MultiGet(members, NULL);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> views;
+  auto results = members.MultiGet(keys, &pins, &views);
   for (size_t i = 0; i < results.size(); i++) {
-    const auto& m = members[i];
     const auto& r = results[i];
     if (r.IsNotFound()) {
-      batch.Put(m);
+      members.Put(keys[i]);
       count++;
     } else if (!r.ok()) {
       return r;
@@ -48,33 +56,29 @@ Response CommandSADD(const Request& request) {
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, +count);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Int(count);
 }
 
 // SREM key field [field ...]
 Response CommandSREM(const Request& request) {
   // Remove duplication.
-  std::set<std::string> fields(request.args().begin() + 2, request.args().end());
+  std::set<Slice, SliceLess> fields(request.args().begin() + 2, request.args().end());
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Int(0);
+  NDB_SET_MEMBERS(members);
 
-  std::vector<std::string> members;
-  for (const auto& field : fields) {
-    members.push_back(set::EncodeMember(kmeta, version, field));
-  }
-
-  NSBatch batch(ns);
+  std::vector<Slice> keys(fields.begin(), fields.end());
   uint64_t count = 0;
-  auto results = ns->MultiGet(members, NULL);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> views;
+  auto results = members.MultiGet(keys, &pins, &views);
   for (size_t i = 0; i < results.size(); i++) {
-    const auto& m = members[i];
     const auto& r = results[i];
     if (r.ok()) {
-      batch.Delete(m);
+      members.Delete(keys[i]);
       count++;
     } else if (!r.IsNotFound()) {
       return r;
@@ -83,8 +87,7 @@ Response CommandSREM(const Request& request) {
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, -count);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Int(count);
 }
 
@@ -99,9 +102,25 @@ Response CommandSMEMBERS(const Request& request) {
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Size(0);
 
-  auto begin = set::EncodePrefix(kmeta, version);
-  auto end = FindNextSuccessor(begin);
   auto res = Response::Size(length);
+  if (vmeta.meta().has_packed()) {
+    // All members are in the meta.
+    Slice in = vmeta.meta().packed(), field, v;
+    for (; in.size() > 0; length--) {
+      if (!PackedMembers::Next(&in, &field, &v)) {
+        return NDB_COMMAND_ERROR("corruption");
+      }
+      res.AppendBulk(field.data(), field.size());
+    }
+    if (length != 0) {
+      return NDB_COMMAND_ERROR("corruption");
+    }
+    return res;
+  }
+
+  auto begin = set::EncodePrefix(kmeta, vmeta.meta());
+  auto end = FindNextSuccessor(begin);
+  size_t mark = res.size();
 
   auto it = ns->RangeGet(begin, end, 0, length);
   for (it->Seek(); it->Valid(); it->Next(), length--) {
@@ -110,6 +129,11 @@ Response CommandSMEMBERS(const Request& request) {
       return NDB_COMMAND_ERROR("corruption");
     }
     res.AppendBulk(field.data(), field.size());
+    if (mark != 0) {
+      // Estimate the reply by the first element.
+      res.ReserveMore(mark, length - 1);
+      mark = 0;
+    }
   }
   NDB_TRY(it->result());
   if (length != 0) {
@@ -125,8 +149,7 @@ Response CommandSISMEMBER(const Request& request) {
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Int(0);
 
-  auto member = set::EncodeMember(kmeta, version, request.args(2));
-  auto r = ns->Get(member, NULL);
+  auto r = GetMember(ns, kmeta, vmeta, request.args(2), set::EncodeMember, NULL);
   if (r.ok()) {
     return Response::Int(1);
   }
@@ -13,14 +13,15 @@ Response CommandGET(const Request& request) {
 // MGET key [key ...]
 Response CommandMGET(const Request& request) {
   std::vector<Slice> keys(request.args().begin() + 1, request.args().end());
-  std::vector<Value> values;
-  auto results = GenericMGET(ndb->engine, keys, &values);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> values;
+  auto results = GenericMGET(ndb->engine, keys, &pins, &values);
   auto res = Response::Size(results.size());
   for (size_t i = 0; i < results.size(); i++) {
     const auto& v = values[i];
     const auto& r = results[i];
     if (r.ok()) {
-      res.Append(ConvertValueToBulk(v));
+      AppendValueToBulk(v, &res);
     } else {
       res.Append(r);
     }
@@ -66,18 +67,18 @@ Response CommandSET(const Request& request) {
   int options = 0;
   uint64_t expire = 0;
   for (size_t i = 3; i < request.argc(); i++) {
-    auto opt = request.args(i).c_str();
-    if (strcasecmp(opt, "EX") == 0 || strcasecmp(opt, "PX") == 0) {
+    const auto& opt = request.args(i);
+    if (EqualsIgnoreCase(opt, "EX") || EqualsIgnoreCase(opt, "PX")) {
       if (++i == request.argc() || !ParseUint64(request.args(i), &expire)) {
         return Response::InvalidArgument();
       }
-      if (strcasecmp(opt, "EX") == 0) {
+      if (EqualsIgnoreCase(opt, "EX")) {
         expire *= 1000;
       }
       options |= NDB_OPTION_EX;
-    } else if (strcasecmp(opt, "NX") == 0) {
+    } else if (EqualsIgnoreCase(opt, "NX")) {
       options |= NDB_OPTION_NX;
-    } else if (strcasecmp(opt, "XX") == 0) {
+    } else if (EqualsIgnoreCase(opt, "XX")) {
       options |= NDB_OPTION_XX;
     } else {
       return Response::InvalidOption();
@@ -7,38 +7,78 @@ namespace zset {
 #define NDB_TRY_GETMETA_BYKEY(k, ns, kmeta, vmeta)                  \
   NDB_TRY_GETMETA_TYPE_BYKEY(k, ns, kmeta, vmeta, Meta::ZSET)
 
-std::string EncodeMemberPrefix(const Slice& kmeta, uint64_t version) {
-  return ndb::EncodePrefix(kmeta, version, Meta::ZSET, 1);
+std::string EncodeMemberPrefix(const Slice& kmeta, const Meta& meta) {
+  return ndb::EncodePrefix(kmeta, meta, Meta::ZSET, 1);
 }
 
-std::string EncodeMember(const Slice& kmeta, uint64_t version, const Slice& field) {
-  std::string dst = EncodeMemberPrefix(kmeta, version);
+std::string EncodeMember(const Slice& kmeta, const Meta& meta, const Slice& field) {
+  std::string dst = EncodeMemberPrefix(kmeta, meta);
   dst.append(field.data(), field.size());
   return dst;
 }
 
-std::string EncodeScorePrefix(const Slice& kmeta, uint64_t version, int64_t score) {
-  std::string dst = ndb::EncodePrefix(kmeta, version, Meta::ZSET, 2);
+std::string EncodeScorePrefix(const Slice& kmeta, const Meta& meta, int64_t score) {
+  std::string dst = ndb::EncodePrefix(kmeta, meta, Meta::ZSET, 2);
   EncodeInt64(&dst, score);
   return dst;
 }
 
-std::string EncodeScore(const Slice& kmeta, uint64_t version, int64_t score, const Slice& field) {
-  std::string dst = EncodeScorePrefix(kmeta, version, score);
+std::string EncodeScore(const Slice& kmeta, const Meta& meta, int64_t score, const Slice& field) {
+  std::string dst = EncodeScorePrefix(kmeta, meta, score);
   dst.append(field.data(), field.size());
   return dst;
 }
 
+void Unpack(NSBatch* batch, const Slice& kmeta, const Meta& meta,
+            const Slice& field, const Slice& value) {
+  batch->Put(EncodeMember(kmeta, meta, field), value);
+  ValueView score;
+  if (score.Decode(value).ok() && score.has_int64()) {
+    batch->Put(EncodeScore(kmeta, meta, score.int64(), field));
+  }
+}
+
+#define NDB_ZSET_MEMBERS(members)                                   \
+  Members members(ns, configs, kmeta, &vmeta,                       \
+                  zset::EncodeMember, zset::Unpack);                \
+  NDB_TRY(members.Load())
+
+// Select members of a packed zset like RangeGet() of score keys in
+// [score prefix of min, score prefix of max], members are in the order
+// of scores then fields, the same as score keys.
+Result RangePacked(const Value& vmeta, int64_t min, int64_t max,
+                   uint64_t offset, uint64_t count, bool reverse,
+                   std::vector<std::pair<int64_t, Slice>>* selected) {
+  std::vector<std::pair<int64_t, Slice>> sorted;
+  Slice in = vmeta.meta().packed(), field, value;
+  while (in.size() > 0) {
+    ValueView score;
+    if (!PackedMembers::Next(&in, &field, &value) ||
+        !score.Decode(value).ok() || !score.has_int64()) {
+      return Result::Error("corruption");
+    }
+    auto s = score.int64();
+    if (s >= min && (s < max || (s == max && field.empty()))) {
+      sorted.emplace_back(s, field);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const std::pair<int64_t, Slice>& a,
+                                             const std::pair<int64_t, Slice>& b) {
+    return a.first < b.first || (a.first == b.first && a.second.compare(b.second) < 0);
+  });
+  if (reverse) {
+    std::reverse(sorted.begin(), sorted.end());
+  }
+  for (size_t i = offset; i < sorted.size() && (count == 0 || i - offset < count); i++) {
+    selected->push_back(sorted[i]);
+  }
+  return Result::OK();
+}
+
 bool ParseFields(const Request& request, size_t idx,
                  std::vector<Slice>* fields,
                  std::vector<int64_t>* scores = NULL) {
-  class Compare {
-   public:
-    bool operator()(const Slice& a, const Slice& b) {
-      return a.compare(b) < 0;
-    }
-  };
-  std::set<Slice, Compare> set;
+  std::set<Slice, SliceLess> set;
 
   auto step = (scores == NULL) ? 1 : 2;
 
@@ -94,25 +134,34 @@ Response GenericZREMRANGEBYRANK(const Request& request,
     offset = length - stop - 1;
   }
 
-  NSBatch batch(ns);
-  auto begin = zset::EncodeScorePrefix(kmeta, version, min);
-  auto end = zset::EncodeScorePrefix(kmeta, version, max);
-  auto it = ns->RangeGet(begin, end, offset, count, reverse);
-  for (it->Seek(), count = 0; it->Valid(); it->Next(), count++) {
-    int64_t score = 0;
-    auto field = it->id();
-    if (!RemovePrefix(&field) || !DecodeInt64(&field, &score)) {
-      return NDB_COMMAND_ERROR("corruption");
+  NDB_ZSET_MEMBERS(members);
+  if (members.packed()) {
+    std::vector<std::pair<int64_t, Slice>> selected;
+    NDB_TRY(zset::RangePacked(vmeta, min, max, offset, count, reverse, &selected));
+    for (const auto& it : selected) {
+      members.Delete(it.second);
+    }
+    count = selected.size();
+  } else {
+    auto batch = members.batch();
+    auto begin = zset::EncodeScorePrefix(kmeta, vmeta.meta(), min);
+    auto end = zset::EncodeScorePrefix(kmeta, vmeta.meta(), max);
+    auto it = ns->RangeGet(begin, end, offset, count, reverse);
+    for (it->Seek(), count = 0; it->Valid(); it->Next(), count++) {
+      int64_t score = 0;
+      auto field = it->id();
+      if (!RemovePrefix(&field) || !DecodeInt64(&field, &score)) {
+        return NDB_COMMAND_ERROR("corruption");
+      }
+      batch->Delete(zset::EncodeMember(kmeta, vmeta.meta(), field));
+      batch->Delete(zset::EncodeScore(kmeta, vmeta.meta(), score, field));
     }
-    batch.Delete(zset::EncodeMember(kmeta, version, field));
-    batch.Delete(zset::EncodeScore(kmeta, version, score, field));
+    NDB_TRY(it->result());
   }
-  NDB_TRY(it->result());
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, -count);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Int(count);
 }
 
@@ -123,22 +172,22 @@ Response GenericZADD(const Request& request, int64_t default_maxlen) {
   int flags = 0;
   Configs options;
   for (size_t i = idx; i < request.argc(); i++) {
-    auto opt = request.args(i).c_str();
-    if (strcasecmp(opt, "NX") == 0) {
+    const auto& opt = request.args(i);
+    if (EqualsIgnoreCase(opt, "NX")) {
       flags |= NDB_OPTION_NX;
-    } else if (strcasecmp(opt, "XX") == 0) {
+    } else if (EqualsIgnoreCase(opt, "XX")) {
       flags |= NDB_OPTION_XX;
-    } else if (strcasecmp(opt, "CH") == 0) {
+    } else if (EqualsIgnoreCase(opt, "CH")) {
       flags |= NDB_OPTION_CH;
-    } else if (strcasecmp(opt, "INCR") == 0) {
+    } else if (EqualsIgnoreCase(opt, "INCR")) {
       return Response::InvalidOption();
-    } else if (strcasecmp(opt, "MAXLEN") == 0 || strcasecmp(opt, "FINITY") == 0) {
+    } else if (EqualsIgnoreCase(opt, "MAXLEN") || EqualsIgnoreCase(opt, "FINITY")) {
       uint64_t maxlen;
       if (++i >= request.argc() || !ParseUint64(request.args(i), &maxlen)) {
         return Response::InvalidArgument();
       }
       options.set_maxlen(maxlen);
-    } else if (strcasecmp(opt, "PRUNING") == 0) {
+    } else if (EqualsIgnoreCase(opt, "PRUNING")) {
       Pruning pruning;
       if (++i >= request.argc() || !ParsePruning(request.args(i), &pruning)) {
         return Response::InvalidArgument();
@@ -170,15 +219,15 @@ Response GenericZADD(const Request& request, int64_t default_maxlen) {
     }
   }
 
-  std::vector<std::string> members;
-  for (const auto& field : fields) {
-    members.push_back(zset::EncodeMember(kmeta, version, field));
-  }
+  NDB_ZSET_MEMBERS(members);
+  NDB_COMMAND_NEW_COLLECTION(members, kmeta, vmeta);
+  // Score keys are written only if members are not packed.
+  NSBatch* batch = members.packed() ? NULL : members.batch();
 
-  NSBatch batch(ns);
   uint64_t count = 0, changed_count = 0;
-  std::vector<Value> values;
-  auto results = ns->MultiGet(members, &values);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> values;
+  auto results = members.MultiGet(fields, &pins, &values);
   for (size_t i = 0; i < results.size(); i++) {
     const auto& s = scores[i];
     const auto& f = fields[i];
@@ -198,21 +247,20 @@ Response GenericZADD(const Request& request, int64_t default_maxlen) {
           continue;
         }
         // Delete previous score.
-        batch.Delete(zset::EncodeScore(kmeta, version, v.int64(), f));
+        if (batch != NULL) batch->Delete(zset::EncodeScore(kmeta, vmeta.meta(), v.int64(), f));
       }
       changed_count++;
     } else {
       return r;
     }
-    batch.Put(members[i], Value::FromInt64(s));
-    batch.Put(zset::EncodeScore(kmeta, version, s, f));
+    members.Put(f, Value::FromInt64(s));
+    if (batch != NULL) batch->Put(zset::EncodeScore(kmeta, vmeta.meta(), s, f));
   }
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, +count);
   vmeta.SetConfigs(configs);
   vmeta.SetConfigs(options);  // options replace configs.
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
 
   uint64_t start, stop;
   if (vmeta.ExceedMaxlen(&start, &stop)) {
@@ -243,23 +291,20 @@ Response CommandZREM(const Request& request) {
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_ZSET_MEMBERS(members);
+  NSBatch* batch = members.packed() ? NULL : members.batch();
 
-  std::vector<std::string> members;
-  for (const auto& field : fields) {
-    members.push_back(zset::EncodeMember(kmeta, version, field));
-  }
-
-  NSBatch batch(ns);
   uint64_t count = 0;
-  std::vector<Value> values;
-  auto results = ns->MultiGet(members, &values);
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> values;
+  auto results = members.MultiGet(fields, &pins, &values);
   for (size_t i = 0; i < results.size(); i++) {
     const auto& f = fields[i];
     const auto& v = values[i];
     const auto& r = results[i];
     if (r.ok()) {
-      batch.Delete(members[i]);
-      batch.Delete(zset::EncodeScore(kmeta, version, v.int64(), f));
+      if (batch != NULL) batch->Delete(zset::EncodeScore(kmeta, vmeta.meta(), v.int64(), f));
+      members.Delete(f);
       count++;
     } else if (!r.IsNotFound()) {
       return r;
@@ -268,8 +313,7 @@ Response CommandZREM(const Request& request) {
 
   NDB_COMMAND_UPDATE_LENGTH(vmeta, -count);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Int(count);
 }
 
@@ -303,10 +347,11 @@ Response CommandZINCRBY(const Request& request) {
 
   NDB_LOCK_KEY(request.args(1));
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
+  NDB_ZSET_MEMBERS(members);
+  NDB_COMMAND_NEW_COLLECTION(members, kmeta, vmeta);
 
   Value value;
-  auto member = zset::EncodeMember(kmeta, version, request.args(3));
-  auto r = ns->Get(member, &value);
+  auto r = members.Get(request.args(3), &value);
   if (r.IsNotFound()) {
     value.set_int64(0);
     NDB_COMMAND_UPDATE_LENGTH(vmeta, +1);
@@ -323,13 +368,14 @@ Response CommandZINCRBY(const Request& request) {
   }
   value.set_int64(origin + increment);
 
-  NSBatch batch(ns);
-  batch.Delete(zset::EncodeScore(kmeta, version, origin, request.args(3)));
-  batch.Put(zset::EncodeScore(kmeta, version, value.int64(), request.args(3)));
-  batch.Put(member, value);
+  if (!members.packed()) {
+    auto batch = members.batch();
+    batch->Delete(zset::EncodeScore(kmeta, vmeta.meta(), origin, request.args(3)));
+    batch->Put(zset::EncodeScore(kmeta, vmeta.meta(), value.int64(), request.args(3)));
+  }
+  members.Put(request.args(3), value);
   vmeta.SetConfigs(configs);
-  batch.Put(kmeta, vmeta);
-  NDB_TRY(batch.Commit());
+  NDB_TRY(members.Commit());
   return Response::Bulk(value.int64());
 }
 
@@ -348,27 +394,51 @@ Response GenericZRANGEGET(const Request& request,
     return Response::Size(0);
   }
 
-  std::vector<std::string> fields;
+  // Fields are packed in one buffer.
+  std::string fields;
+  std::vector<size_t> sizes;
   std::vector<int64_t> scores;
   uint64_t offset = start, count = stop - start + 1;
-  auto begin = zset::EncodeScorePrefix(kmeta, version, min);
-  auto end = zset::EncodeScorePrefix(kmeta, version, max);
-
-  auto it = ns->RangeGet(begin, end, offset, count, reverse);
-  for (it->Seek(); it->Valid(); it->Next()) {
-    int64_t score = 0;
-    auto field = it->id();
-    if (!RemovePrefix(&field) || !DecodeInt64(&field, &score)) {
-      return NDB_COMMAND_ERROR("corruption");
+  if (vmeta.meta().has_packed()) {
+    std::vector<std::pair<int64_t, Slice>> selected;
+    NDB_TRY(zset::RangePacked(vmeta, min, max, offset, count, reverse, &selected));
+    for (const auto& it : selected) {
+      fields.append(it.second.data(), it.second.size());
+      sizes.push_back(it.second.size());
+      scores.push_back(it.first);
     }
-    fields.emplace_back(field.data(), field.size());
-    scores.push_back(score);
+  } else {
+    auto begin = zset::EncodeScorePrefix(kmeta, vmeta.meta(), min);
+    auto end = zset::EncodeScorePrefix(kmeta, vmeta.meta(), max);
+    auto it = ns->RangeGet(begin, end, offset, count, reverse);
+    for (it->Seek(); it->Valid(); it->Next()) {
+      int64_t score = 0;
+      auto field = it->id();
+      if (!RemovePrefix(&field) || !DecodeInt64(&field, &score)) {
+        return NDB_COMMAND_ERROR("corruption");
+      }
+      fields.append(field.data(), field.size());
+      sizes.push_back(field.size());
+      scores.push_back(score);
+    }
+    NDB_TRY(it->result());
   }
-  NDB_TRY(it->result());
 
-  auto res = Response::Size((1 + with_scores) * fields.size());
-  for (size_t i = 0; i < fields.size(); i++) {
-    res.AppendBulk(fields[i]);
+  // Reserve the exact size of the reply.
+  auto size = (1 + with_scores) * sizes.size();
+  auto total = Response::SizeOfSize(size);
+  for (size_t i = 0; i < sizes.size(); i++) {
+    total += Response::SizeOfBulk(fields.data(), sizes[i]);
+    if (with_scores) {
+      total += Response::SizeOfBulk(scores[i]);
+    }
+  }
+  auto res = Response::Size(size);
+  res.Reserve(total);
+  const char* field = fields.data();
+  for (size_t i = 0; i < sizes.size(); i++) {
+    res.AppendBulk(field, sizes[i]);
+    field += sizes[i];
     if (with_scores) {
       res.AppendBulk(scores[i]);
     }
@@ -385,7 +455,7 @@ Response GenericZRANGE(const Request& request, bool reverse) {
 
   bool with_scores = false;
   if (request.argc() == 5) {
-    if (strcasecmp(request.args(4).c_str(), "WITHSCORES") == 0) {
+    if (EqualsIgnoreCase(request.args(4), "WITHSCORES")) {
       with_scores = true;
     } else {
       return Response::InvalidOption();
@@ -421,10 +491,10 @@ Response GenericZRANGEBYSCORE(const Request& request, bool reverse) {
   bool with_scores = false;
   int64_t offset = 0, count = INT64_MAX;
   for (size_t i = 4; i < request.argc(); i++) {
-    auto opt = request.args(i).c_str();
-    if (strcasecmp(opt, "WITHSCORES") == 0) {
+    const auto& opt = request.args(i);
+    if (EqualsIgnoreCase(opt, "WITHSCORES")) {
       with_scores = true;
-    } else if (strcasecmp(opt, "LIMIT") == 0) {
+    } else if (EqualsIgnoreCase(opt, "LIMIT")) {
       if (!ParseLimit(request, i, &offset, &count)) {
         return Response::InvalidArgument();
       }
@@ -460,9 +530,8 @@ Response CommandZSCORE(const Request& request) {
   NDB_TRY_GETMETA_BYKEY(request.args(1), ns, kmeta, vmeta);
   if (length == 0) return Response::Null();
 
-  auto member = zset::EncodeMember(kmeta, version, request.args(2));
   Value value;
-  NDB_TRY(ns->Get(member, &value));
+  NDB_TRY(GetMember(ns, kmeta, vmeta, request.args(2), zset::EncodeMember, &value));
   return Response::Bulk(value.int64());
 }
 
@@ -4,14 +4,33 @@ namespace ndb {
 
 NSStats nsstats;
 
-bool ParseInt64(const std::string& s, int64_t* i) {
-  if (s.size() == 0 || isspace(s.front()) || isspace(s.back())) {
+bool EqualsIgnoreCase(const Slice& s, const char* name) {
+  return s.size() == strlen(name) && strncasecmp(s.data(), name, s.size()) == 0;
+}
+
+// Copy s to a null-terminated string, use buf if it is large enough.
+static const char* ToCString(const Slice& s, char* buf, size_t bufsize, std::string* str) {
+  if (s.size() < bufsize) {
+    memcpy(buf, s.data(), s.size());
+    buf[s.size()] = '\0';
+    return buf;
+  }
+  str->assign(s.data(), s.size());
+  return str->c_str();
+}
+
+bool ParseInt64(const Slice& s, int64_t* i) {
+  if (s.size() == 0 || isspace(s[0]) || isspace(s[s.size()-1])) {
     return false;
   }
 
+  char buf[64];
+  std::string str;
+  auto cs = ToCString(s, buf, sizeof(buf), &str);
+
   errno = 0;
   char* end = NULL;
-  *i = strtoll(s.data(), &end, 10);
+  *i = strtoll(cs, &end, 10);
   if (errno != 0) return false;
 
   if (*end == '.') {
@@ -22,29 +41,33 @@ bool ParseInt64(const std::string& s, int64_t* i) {
   return *end == '\0';
 }
 
-bool ParseUint64(const std::string& s, uint64_t* u) {
-  if (s.size() == 0 || isspace(s.front()) || isspace(s.back())) {
+bool ParseUint64(const Slice& s, uint64_t* u) {
+  if (s.size() == 0 || isspace(s[0]) || isspace(s[s.size()-1])) {
     return false;
   }
-  if (s.front() == '-') {
+  if (s[0] == '-') {
     return false;
   }
 
+  char buf[64];
+  std::string str;
+  auto cs = ToCString(s, buf, sizeof(buf), &str);
+
   errno = 0;
   char* end = NULL;
-  *u = strtoull(s.data(), &end, 10);
+  *u = strtoull(cs, &end, 10);
   if (errno != 0) return false;
   return *end == '\0';
 }
 
-bool ParsePruning(const std::string& s, Pruning* pruning) {
-  if (strcasecmp(s.data(), "MIN") == 0 ||
-      strcasecmp(s.data(), "MINSCORE") == 0) {
+bool ParsePruning(const Slice& s, Pruning* pruning) {
+  if (EqualsIgnoreCase(s, "MIN") ||
+      EqualsIgnoreCase(s, "MINSCORE")) {
     *pruning = Pruning::MIN;
     return true;
   }
-  if (strcasecmp(s.data(), "MAX") == 0 ||
-      strcasecmp(s.data(), "MAXSCORE") == 0) {
+  if (EqualsIgnoreCase(s, "MAX") ||
+      EqualsIgnoreCase(s, "MAXSCORE")) {
     *pruning = Pruning::MAX;
     return true;
   }
@@ -76,8 +99,7 @@ bool RemoveFront(Slice* s) {
   auto pos = sfind(*s, '_');
 
   int64_t v = 0;
-  std::string id(s->data(), pos);
-  if (ParseInt64(id, &v)) return false;
+  if (ParseInt64(Slice(s->data(), pos), &v)) return false;
 
   s->remove_prefix(std::min(pos + 1, s->size()));
   return true;
@@ -106,13 +128,22 @@ bool ParseNamespace(const Slice& s, std::string* nsname, std::string* id) {
   return false;
 }
 
+std::vector<std::string> FormatNamespace(const std::string& nsname, const Slice& id) {
+  std::string key(id.data(), id.size());
+  if (IsMetaKey(id)) key.pop_back();
+  if (nsname == "default") {
+    return {key};
+  }
+  return {nsname + ":" + key, nsname + "_" + key};
+}
+
 bool ParseLimit(const Request& request, size_t idx, int64_t* offset, int64_t* count) {
   *offset = 0, *count = INT64_MAX;
 
   if (request.argc() == idx) return true;
   if (request.argc() <= idx + 2) return false;
 
-  if (strcasecmp(request.args(idx).c_str(), "LIMIT") != 0) {
+  if (!EqualsIgnoreCase(request.args(idx), "LIMIT")) {
     return false;
   }
   if (!ParseInt64(request.args(idx+1), offset)) {
@@ -139,19 +170,20 @@ bool CheckLimit(int64_t length, int64_t* start, int64_t* stop) {
   return true;
 }
 
-static bool ParseMin(const std::string& s, int64_t* i) {
-  auto p = s.c_str();
-  if (s[0] == '(') {
-    p++;
+static bool ParseMin(const Slice& s, int64_t* i) {
+  bool exclusive = s.size() > 0 && s[0] == '(';
+  auto p = s;
+  if (exclusive) {
+    p.remove_prefix(1);
   }
 
-  if (strcasecmp(p, "-inf") == 0) {
+  if (EqualsIgnoreCase(p, "-inf")) {
     *i = INT64_MIN;
   } else if (!ParseInt64(p, i)) {
     return false;
   }
 
-  if (s[0] == '(') {
+  if (exclusive) {
     if (*i < INT64_MAX) {
       *i += 1;
     }
@@ -160,19 +192,20 @@ static bool ParseMin(const std::string& s, int64_t* i) {
   return true;
 }
 
-static bool ParseMax(const std::string& s, int64_t* i) {
-  auto p = s.c_str();
-  if (s[0] == '(') {
-    p++;
+static bool ParseMax(const Slice& s, int64_t* i) {
+  bool exclusive = s.size() > 0 && s[0] == '(';
+  auto p = s;
+  if (exclusive) {
+    p.remove_prefix(1);
   }
 
-  if (strcasecmp(p, "+inf") == 0) {
+  if (EqualsIgnoreCase(p, "+inf")) {
     *i = INT64_MAX;
   } else if (!ParseInt64(p, i)) {
     return false;
   }
 
-  if (s[0] == '(') {
+  if (exclusive) {
     if (*i > INT64_MIN) {
       *i -= 1;
     }
@@ -221,6 +254,26 @@ Response ConvertValueToBulk(const Value& value) {
   return Response::Null();
 }
 
+void AppendValueToBulk(const Value& value, Response* res) {
+  if (value.has_int64()) {
+    res->AppendBulk(value.int64());
+  } else if (value.has_bytes()) {
+    res->AppendBulk(value.bytes());
+  } else {
+    res->AppendNull();
+  }
+}
+
+void AppendValueToBulk(const ValueView& value, Response* res) {
+  if (value.has_int64()) {
+    res->AppendBulk(value.int64());
+  } else if (value.has_bytes()) {
+    res->AppendBulk(value.bytes());
+  } else {
+    res->AppendNull();
+  }
+}
+
 std::string FindNextSuccessor(const std::string& s) {
   auto t = s;
   // Find last character that can be incrementd.
@@ -234,9 +287,8 @@ std::string FindNextSuccessor(const std::string& s) {
   return t;
 }
 
-std::vector<Result> GenericMGET(Engine* engine, const std::vector<Slice>& keys, std::vector<Value>* values) {
-  std::vector<NSRef> namespaces;
-  std::vector<std::string> ids;
+static void ParseKeys(Engine* engine, const std::vector<Slice>& keys,
+                      std::vector<NSRef>* namespaces, std::vector<std::string>* ids) {
   for (const auto& k : keys) {
     std::string nsname, id;
     ParseNamespace(k, &nsname, &id);
@@ -246,10 +298,146 @@ std::vector<Result> GenericMGET(Engine* engine, const std::vector<Slice>& keys,
       ns = engine->GetNamespace("default");
       id = "__this_id_does_not_exist__";
     }
-    namespaces.push_back(ns);
-    ids.push_back(id);
+    namespaces->push_back(ns);
+    ids->push_back(id);
   }
+}
+
+std::vector<Result> GenericMGET(Engine* engine, const std::vector<Slice>& keys, std::vector<Value>* values) {
+  std::vector<NSRef> namespaces;
+  std::vector<std::string> ids;
+  ParseKeys(engine, keys, &namespaces, &ids);
   return engine->MultiGet(namespaces, ids, values);
 }
 
+std::vector<Result> GenericMGET(Engine* engine, const std::vector<Slice>& keys,
+                                std::vector<PinnableSlice>* pins, std::vector<ValueView>* views) {
+  std::vector<NSRef> namespaces;
+  std::vector<std::string> ids;
+  ParseKeys(engine, keys, &namespaces, &ids);
+  return engine->MultiGet(namespaces, ids, pins, views);
+}
+
+Result GetMember(NSRef ns, const Slice& kmeta, const Value& vmeta, const Slice& field,
+                 Members::Encoder encoder, Value* value) {
+  if (!vmeta.meta().has_packed()) {
+    return ns->Get(encoder(kmeta, vmeta.meta(), field), value);
+  }
+  Slice v;
+  NDB_TRY(PackedMembers::Find(vmeta.meta().packed(), field, &v));
+  if (value == NULL) {
+    ValueView view;
+    return view.DecodeLive(v);
+  }
+  return value->Decode(v);
+}
+
+Members::Members(NSRef ns, const Configs& configs, const Slice& kmeta, Value* vmeta,
+                 Encoder encoder, Unpacker unpacker)
+    : ns_(ns), configs_(configs), kmeta_(kmeta), vmeta_(vmeta),
+      encoder_(encoder), unpacker_(unpacker), batch_(ns) {
+  const auto& meta = vmeta->meta();
+  // Empty collections are created packed if packing is enabled.
+  packed_ = meta.has_packed() || (meta.length() == 0 && configs.packed_entries() > 0);
+}
+
+Result Members::Load() {
+  if (!packed_) {
+    return Result::OK();
+  }
+  return members_.Decode(vmeta_->meta().packed());
+}
+
+Result Members::NewCollection(const Slice& kmeta, Meta* meta) {
+  if (packed_) {
+    return Result::OK();
+  }
+  return batch_.NewCollection(kmeta, meta);
+}
+
+std::vector<Result> Members::MultiGet(const std::vector<Slice>& fields,
+                                      std::vector<PinnableSlice>* pins,
+                                      std::vector<ValueView>* views) {
+  if (!packed_) {
+    std::vector<std::string> members;
+    for (const auto& field : fields) {
+      members.push_back(encoder_(kmeta_, vmeta_->meta(), field));
+    }
+    return ns_->MultiGet(members, pins, views);
+  }
+
+  std::vector<Result> results(fields.size());
+  views->assign(fields.size(), ValueView());
+  for (size_t i = 0; i < fields.size(); i++) {
+    auto v = members_.Get(fields[i]);
+    if (v == NULL) {
+      results[i] = Result::NotFound();
+    } else {
+      results[i] = (*views)[i].DecodeLive(*v);
+    }
+  }
+  return results;
+}
+
+Result Members::Get(const Slice& field, Value* value) {
+  if (!packed_) {
+    auto member = encoder_(kmeta_, vmeta_->meta(), field);
+    return ns_->Get(member, value);
+  }
+  auto v = members_.Get(field);
+  if (v == NULL) {
+    return Result::NotFound();
+  }
+  if (value == NULL) {
+    ValueView view;
+    return view.DecodeLive(*v);
+  }
+  return value->Decode(*v);
+}
+
+void Members::Put(const Slice& field, const Value& value) {
+  if (packed_) {
+    members_.Put(field, value.Encode());
+  } else {
+    batch_.Put(encoder_(kmeta_, vmeta_->meta(), field), value);
+  }
+}
+
+void Members::Put(const Slice& field) {
+  if (packed_) {
+    members_.Put(field, Slice());
+  } else {
+    batch_.Put(encoder_(kmeta_, vmeta_->meta(), field));
+  }
+}
+
+void Members::Delete(const Slice& field) {
+  if (packed_) {
+    members_.Delete(field);
+  } else {
+    batch_.Delete(encoder_(kmeta_, vmeta_->meta(), field));
+  }
+}
+
+Result Members::Commit() {
+  if (packed_) {
+    auto meta = vmeta_->mutable_meta();
+    if (members_.size() == 0) {
+      meta->clear_packed();
+    } else if (members_.Fits(configs_.packed_entries(), configs_.packed_value_size())) {
+      meta->set_packed(members_.Encode());
+    } else {
+      meta->clear_packed();
+      if (meta->cid() == 0) {
+        NDB_TRY(batch_.NewCollection(kmeta_, meta));
+      }
+      for (const auto& it : members_.members()) {
+        unpacker_(&batch_, kmeta_, *meta, it.first, it.second);
+      }
+    }
+  }
+  batch_.Put(kmeta_, *vmeta_);
+  return batch_.Commit();
+}
+
 }  // namespace ndb
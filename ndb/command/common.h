@@ -14,18 +14,32 @@ namespace ndb {
 #define NDB_OPTION_CH   (1 << 3)
 #define NDB_OPTION_INCR (1 << 4)
 
+// Compare s with name case-insensitively.
+bool EqualsIgnoreCase(const Slice& s, const char* name);
+
+// Order slices in containers.
+struct SliceLess {
+  bool operator()(const Slice& a, const Slice& b) const {
+    return a.compare(b) < 0;
+  }
+};
+
 // Parse int64.
-bool ParseInt64(const std::string& s, int64_t* i);
+bool ParseInt64(const Slice& s, int64_t* i);
 
 // Parse uint64.
-bool ParseUint64(const std::string& s, uint64_t* u);
+bool ParseUint64(const Slice& s, uint64_t* u);
 
 // Parse pruning as [min|minscore|max|maxscore].
-bool ParsePruning(const std::string& s, Pruning* pruning);
+bool ParsePruning(const Slice& s, Pruning* pruning);
 
 // Parse namespace as [nsname:id|nsname_id].
 bool ParseNamespace(const Slice& s, std::string* nsname, std::string* id);
 
+// Format keys of id in both forms of ParseNamespace, e.g. to lock them.
+// Meta ids are formatted without the trailing '\0'.
+std::vector<std::string> FormatNamespace(const std::string& nsname, const Slice& id);
+
 // Parse [LIMIT offset count] from request.
 bool ParseLimit(const Request& request, size_t idx, int64_t* offset, int64_t* count);
 
@@ -44,6 +58,10 @@ bool ConvertValueToInt64(const Value& value, int64_t* int64);
 // Convert value to bulk string response.
 Response ConvertValueToBulk(const Value& value);
 
+// Append value as a bulk string to res.
+void AppendValueToBulk(const Value& value, Response* res);
+void AppendValueToBulk(const ValueView& value, Response* res);
+
 // Change s to a string >= s.
 std::string FindNextSuccessor(const std::string& s);
 
@@ -51,14 +69,77 @@ std::string FindNextSuccessor(const std::string& s);
 // WARN: Don't use this to get members of collection data types,
 // use Namespace::MultiGet() instead.
 std::vector<Result> GenericMGET(Engine* engine, const std::vector<Slice>& keys, std::vector<Value>* values);
+// Get values as views decoded in place, views refer to pins.
+std::vector<Result> GenericMGET(Engine* engine, const std::vector<Slice>& keys,
+                                std::vector<PinnableSlice>* pins, std::vector<ValueView>* views);
+
+// Members of a hash, set or zset to write. Members are packed in the meta
+// while the collection is small enough for configs, see PackedMembers,
+// otherwise they are member keys. Collections are packed only if they are
+// created with packing enabled, and are not packed again once unpacked.
+class Members {
+ public:
+  // Encode the member key of field in the layout of meta.
+  typedef std::string (*Encoder)(const Slice& kmeta, const Meta& meta, const Slice& field);
+  // Write a packed member to member keys when the collection is unpacked.
+  typedef void (*Unpacker)(NSBatch* batch, const Slice& kmeta, const Meta& meta,
+                           const Slice& field, const Slice& value);
+
+  Members(NSRef ns, const Configs& configs, const Slice& kmeta, Value* vmeta,
+          Encoder encoder, Unpacker unpacker);
+
+  // Load packed members, call it before others.
+  Result Load();
+
+  bool packed() const { return packed_; }
+
+  // Allocate a cid for a new collection stored as member keys. Packed
+  // collections are given cids when they are unpacked.
+  Result NewCollection(const Slice& kmeta, Meta* meta);
+
+  // Views refer to pins or packed members, until fields are written.
+  std::vector<Result> MultiGet(const std::vector<Slice>& fields,
+                               std::vector<PinnableSlice>* pins,
+                               std::vector<ValueView>* views);
+  // Value can be NULL to check existence.
+  Result Get(const Slice& field, Value* value);
+
+  void Put(const Slice& field, const Value& value);
+  // Put a member without value, e.g. of sets.
+  void Put(const Slice& field);
+  void Delete(const Slice& field);
+
+  // Batch of member keys, e.g. to write indexes of unpacked collections.
+  NSBatch* batch() { return &batch_; }
+
+  // Put the meta and commit. Packed members are moved to member keys
+  // if they don't fit in configs any more.
+  Result Commit();
+
+ private:
+  NSRef ns_;
+  const Configs& configs_;
+  Slice kmeta_;
+  Value* vmeta_ {NULL};
+  Encoder encoder_ {NULL};
+  Unpacker unpacker_ {NULL};
+  bool packed_ {false};
+  PackedMembers members_;
+  NSBatch batch_;
+};
+
+// Get the value of field packed in vmeta, or of its member key if vmeta
+// is not packed. Value can be NULL to check existence.
+Result GetMember(NSRef ns, const Slice& kmeta, const Value& vmeta, const Slice& field,
+                 Members::Encoder encoder, Value* value);
 
 // Namespace commands statistics.
 class NSStats {
  public:
-  void add(const std::string& nsname, const std::string& cmdname) {
+  void add(const std::string& nsname, const Slice& cmdname) {
     std::unique_lock<std::mutex> lock(lock_);
     nsstats_[nsname]["*"].fetch_add(1, std::memory_order_relaxed);
-    nsstats_[nsname][cmdname].fetch_add(1, std::memory_order_relaxed);
+    nsstats_[nsname][cmdname.ToString()].fetch_add(1, std::memory_order_relaxed);
   }
 
   Stats GetStats(const std::string& nsname = "") {
@@ -47,13 +47,22 @@ namespace ndb {
   NDB_TRY_GETNS_BYKEY(k, ns, id);                                   \
   auto kmeta = EncodeMeta(id);                                      \
   auto vmeta = NDB_TRY_GETMETA(ns, kmeta, vtype);                   \
-  auto length = vmeta.meta().length();                              \
-  auto version = vmeta.meta().version()
+  auto length = vmeta.meta().length()
+
+// Allocate a cid for a collection created by the command, so its members
+// are keyed by the cid. Batch is the NSBatch or Members the meta is written
+// with. Call it before members are encoded.
+// Response if allocation failed.
+#define NDB_COMMAND_NEW_COLLECTION(batch, kmeta, vmeta) do {        \
+    if (vmeta.meta().length() == 0) {                               \
+      NDB_TRY(batch.NewCollection(kmeta, vmeta.mutable_meta()));    \
+    }                                                               \
+  } while (0)
 
 // Log and return command error.
 #define NDB_COMMAND_ERROR(fmt, ...) ({                              \
       auto r = Result::Error("cmd=%s ns=%s id=%s " fmt,             \
-                             request.args(0).c_str(),               \
+                             request.args(0).ToString().c_str(),    \
                              nsname.c_str(),                        \
                              id.c_str(),                            \
                              ## __VA_ARGS__);                       \
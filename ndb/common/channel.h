@@ -6,11 +6,18 @@
 
 namespace ndb {
 
+// Channel wakes up consumers with an eventfd. Wakeups are coalesced,
+// the eventfd is written only if it has not been signaled since the
+// last time consumers found the channel empty.
 template <class T>
 class Channel {
  public:
+  // Tokens speed up repeated operations of the same thread.
+  typedef moodycamel::ProducerToken ProducerToken;
+  typedef moodycamel::ConsumerToken ConsumerToken;
+
   Channel(size_t maxsize) : maxsize_(maxsize) {
-    fd_ = eventfd(0, EFD_NONBLOCK | EFD_SEMAPHORE);
+    fd_ = eventfd(0, EFD_NONBLOCK);
     NDB_ASSERT(fd_ != -1);
   }
 
@@ -30,28 +37,81 @@ class Channel {
 
   size_t size() const { return queue_.size_approx(); }
 
+  // Number of eventfd writes and items sent.
+  uint64_t wakeups() const { return wakeups_; }
+  uint64_t items() const { return items_; }
+
+  ProducerToken NewProducerToken() { return ProducerToken(queue_); }
+  ConsumerToken NewConsumerToken() { return ConsumerToken(queue_); }
+
   // Caller take ownership of item.
   T* Recv() {
-    uint64_t count = 0;
-    eventfd_read(fd_, &count);
     T* item = NULL;
-    queue_.try_dequeue(item);
+    RecvBulk(&item, 1);
     return item;
   }
 
-  // Callee take ownership of item.
-  void Send(T* item) {
-    if (queue_.size_approx() < maxsize_) {
-      queue_.enqueue(item);
-      eventfd_write(fd_, 1);
+  // Caller take ownership of items, return the number of items.
+  size_t RecvBulk(T** items, size_t max, ConsumerToken* token = NULL) {
+    size_t n = Dequeue(items, max, token);
+    if (n == 0) {
+      // Clear the signal and check again, items sent after that
+      // will signal again.
+      uint64_t count = 0;
+      eventfd_read(fd_, &count);
+      signaled_.exchange(false, std::memory_order_acq_rel);
+      n = Dequeue(items, max, token);
+    }
+    return n;
+  }
+
+  // Callee take ownership of item if the channel is not full.
+  bool Send(T* item) {
+    return SendBulk(&item, 1) == 1;
+  }
+
+  // Callee take ownership of the first n items, return n.
+  // Items exceed maxsize are left to the caller.
+  size_t SendBulk(T** items, size_t count, ProducerToken* token = NULL) {
+    size_t size = queue_.size_approx();
+    size_t n = (size < maxsize_) ? std::min(count, maxsize_ - size) : 0;
+    if (n == 0) {
+      return 0;
+    }
+    if (token != NULL) {
+      queue_.enqueue_bulk(*token, items, n);
+    } else {
+      queue_.enqueue_bulk(items, n);
+    }
+    items_.fetch_add(n, std::memory_order_relaxed);
+    if (!signaled_.exchange(true, std::memory_order_acq_rel)) {
+      Notify();
+    }
+    return n;
+  }
+
+  // Wake up another consumer even if signaled, used by consumers
+  // that leave items in the channel.
+  void Notify() {
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    eventfd_write(fd_, 1);
+  }
+
+ private:
+  size_t Dequeue(T** items, size_t max, ConsumerToken* token) {
+    if (token != NULL) {
+      return queue_.try_dequeue_bulk(*token, items, max);
     } else {
-      delete item;
+      return queue_.try_dequeue_bulk(items, max);
     }
   }
 
  private:
   int fd_;
   size_t maxsize_ {4096};
+  std::atomic<bool> signaled_ {false};
+  std::atomic<uint64_t> wakeups_ {0};
+  std::atomic<uint64_t> items_ {0};
   moodycamel::ConcurrentQueue<T*> queue_;
 };
 
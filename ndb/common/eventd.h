@@ -18,16 +18,20 @@ class Eventd : public Thread {
 
   void Main() override {
     HandleCron();
-    NDB_ASSERT_OK(ioloop_.Run(cb_, milliseconds(1000)));
+    NDB_ASSERT_OK(ioloop_.Run(cb_, timeout_));
+    HandleBatch();
   }
 
  protected:
   virtual void HandleCron() {}
   virtual void HandleEvent(int fd, IOLoop::Event event) {}
+  // Called after each batch of events.
+  virtual void HandleBatch() {}
 
  protected:
   IOLoop ioloop_;
   IOLoop::Callback cb_;
+  milliseconds timeout_ {1000};
 };
 
 }  // namespace ndb
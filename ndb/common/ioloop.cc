@@ -1,23 +1,54 @@
 #include "ndb/common/ioloop.h"
 
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// Headers of Linux 6.0+ are required, for multishot receives.
+#ifdef IORING_RECV_MULTISHOT
+#define NDB_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
 namespace ndb {
 
 struct IOLoop::Rep {
+  // Data of the current kReceived callback.
+  Slice received;
+
+  virtual ~Rep() {}
+  virtual const char* name() const = 0;
+  virtual bool multishot() const { return false; }
+  virtual Result Add(int fd, Event event) = 0;
+  virtual Result Accept(int fd) {
+    return Result::Error("%s does not support multishot accept", name());
+  }
+  virtual Result Recv(int fd, Event event) {
+    return Result::Error("%s does not support multishot receive", name());
+  }
+  virtual Result Mod(int fd, Event event) = 0;
+  virtual Result Del(int fd, std::string* unread) = 0;
+  virtual Result Run(const Callback& cb, milliseconds timeout) = 0;
+};
+
+struct IOLoop::EpollRep : public IOLoop::Rep {
   int epfd {-1};
   std::vector<epoll_event> events;
 
-  Rep() {
+  EpollRep() {
     epfd = epoll_create(1024);
     NDB_ASSERT(epfd != -1);
     events.resize(1024);
   }
 
-  ~Rep() {
+  ~EpollRep() {
     if (epfd != -1) {
       close(epfd);
     }
   }
 
+  const char* name() const override { return "epoll"; }
+
   Result Ctl(int op, int fd, Event event) {
     epoll_event e = {0};
     e.data.fd = fd;
@@ -29,48 +60,658 @@ struct IOLoop::Rep {
     return Result::OK();
   }
 
-  int Wait(milliseconds timeout) {
-    return epoll_wait(epfd, &events[0], events.size(), timeout.count());
+  Result Add(int fd, Event event) override {
+    return Ctl(EPOLL_CTL_ADD, fd, event);
+  }
+
+  Result Mod(int fd, Event event) override {
+    return Ctl(EPOLL_CTL_MOD, fd, event);
+  }
+
+  Result Del(int fd, std::string* unread) override {
+    if (unread != NULL) unread->clear();
+    return Ctl(EPOLL_CTL_DEL, fd, 0);
+  }
+
+  Result Run(const Callback& cb, milliseconds timeout) override {
+    int n = epoll_wait(epfd, &events[0], events.size(), timeout.count());
+    if (n == -1) {
+      return Result::Errno("epoll_wait()");
+    }
+
+    for (int i = 0; i < n; i++) {
+      auto fd = events[i].data.fd;
+      auto e = events[i].events;
+      if ((e & EPOLLIN) || (e & EPOLLHUP)) {
+        cb(fd, kReadable);
+      } else if ((e & EPOLLOUT) || (e & EPOLLERR)) {
+        cb(fd, kWritable);
+      }
+    }
+    return Result::OK();
+  }
+};
+
+#ifdef NDB_HAVE_IO_URING
+
+// UringRep keeps the readiness model of epoll: each fd has a one-shot
+// POLL_ADD which is armed again after its callback, so events are level
+// triggered. Add/Mod/Del only queue SQEs, they are submitted together
+// with the wait in one io_uring_enter() per loop.
+//
+// Listen fds of Accept() have a multishot ACCEPT instead. Fds of Recv()
+// have a multishot RECV while watched readable, which picks buffers from
+// a ring registered with the kernel, so requests are read without any
+// syscall. The RECV is cancelled synchronously when the fd is watched
+// writable or deleted, data received by then are kept in its stash.
+struct IOLoop::UringRep : public IOLoop::Rep {
+  static const unsigned kEntries = 4096;
+  // Tags of completions to ignore.
+  static const uint64_t kTimeout = UINT64_MAX;
+  static const uint64_t kRemove = UINT64_MAX - 1;
+  // Registered buffers of multishot receives.
+  static const unsigned kBuffers = 1024;
+  static const size_t kBufferSize = 4096;
+  static const uint16_t kBufferGroup = 0;
+
+  // Requests to watch fds.
+  enum Op { kPoll, kAccept, kRecv };
+
+  struct Poll {
+    Event event {0};
+    Op op {kPoll};
+    // The request in flight.
+    uint32_t gen {0};
+    bool armed {false};
+    Op armed_op {kPoll};
+    // Data received but not passed to the callback yet.
+    std::string stash;
+  };
+
+  struct Ready {
+    int fd;
+    Event event;
+    uint32_t gen;
+    // Accepted fd or size of received data.
+    int res;
+    // Registered buffer of received data, or -1.
+    int bid;
+  };
+
+  int ring {-1};
+  unsigned sq_entries {0};
+  void* sq_ptr {MAP_FAILED};
+  size_t sq_size {0};
+  void* cq_ptr {MAP_FAILED};
+  size_t cq_size {0};
+  io_uring_sqe* sqes {(io_uring_sqe*) MAP_FAILED};
+  size_t sqes_size {0};
+  unsigned* sq_head {NULL};
+  unsigned* sq_tail {NULL};
+  unsigned* sq_mask {NULL};
+  unsigned* sq_array {NULL};
+  unsigned* cq_head {NULL};
+  unsigned* cq_tail {NULL};
+  unsigned* cq_mask {NULL};
+  io_uring_cqe* cqes {NULL};
+  unsigned pending {0};
+  uint32_t gen {0};
+  __kernel_timespec ts;
+  std::unordered_map<int, Poll> polls;
+  std::vector<Ready> readies;
+  // Index of the ready in callback.
+  size_t ready_pos {0};
+  // Fds with stashes to pass in the next loop.
+  std::vector<int> stashed;
+  bool has_multishot {false};
+  // Entries of io_uring_buf_ring, whose bufs are misplaced in C++,
+  // where the empty struct before them takes a byte.
+  io_uring_buf* br {(io_uring_buf*) MAP_FAILED};
+  size_t br_size {0};
+  uint16_t br_tail {0};
+  char* buffers {(char*) MAP_FAILED};
+  size_t buffers_size {0};
+
+  ~UringRep() {
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+    if (sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_size);
+    if (ring != -1) close(ring);
+    // Buffers are unregistered when the ring is closed.
+    if (br != MAP_FAILED) munmap(br, br_size);
+    if (buffers != MAP_FAILED) munmap(buffers, buffers_size);
+  }
+
+  const char* name() const override { return "io_uring"; }
+
+  bool multishot() const override { return has_multishot; }
+
+  Result Open() {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ring = syscall(__NR_io_uring_setup, kEntries, &p);
+    if (ring == -1) {
+      return Result::Errno("io_uring_setup()");
+    }
+
+    sq_entries = p.sq_entries;
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) {
+      sq_size = cq_size = std::max(sq_size, cq_size);
+    }
+
+    sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+      return Result::Errno("mmap()");
+    }
+    if (single) {
+      cq_ptr = sq_ptr;
+    } else {
+      cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+      if (cq_ptr == MAP_FAILED) {
+        return Result::Errno("mmap()");
+      }
+    }
+    sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    sqes = (io_uring_sqe*) mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return Result::Errno("mmap()");
+    }
+
+    auto sq = (char*) sq_ptr;
+    sq_head = (unsigned*) (sq + p.sq_off.head);
+    sq_tail = (unsigned*) (sq + p.sq_off.tail);
+    sq_mask = (unsigned*) (sq + p.sq_off.ring_mask);
+    sq_array = (unsigned*) (sq + p.sq_off.array);
+    auto cq = (char*) cq_ptr;
+    cq_head = (unsigned*) (cq + p.cq_off.head);
+    cq_tail = (unsigned*) (cq + p.cq_off.tail);
+    cq_mask = (unsigned*) (cq + p.cq_off.ring_mask);
+    cqes = (io_uring_cqe*) (cq + p.cq_off.cqes);
+
+    // Fds are polled on kernels without multishot receives.
+    has_multishot = SetupBuffers().ok();
+    return Result::OK();
+  }
+
+  // Register buffers and probe the synchronous cancel,
+  // both are supported since Linux 6.0 like multishot receives.
+  Result SetupBuffers() {
+    br_size = kBuffers * sizeof(io_uring_buf);
+    br = (io_uring_buf*) mmap(NULL, br_size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (br == MAP_FAILED) {
+      return Result::Errno("mmap()");
+    }
+    buffers_size = kBuffers * kBufferSize;
+    buffers = (char*) mmap(NULL, buffers_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED) {
+      return Result::Errno("mmap()");
+    }
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t) br;
+    reg.ring_entries = kBuffers;
+    reg.bgid = kBufferGroup;
+    if (syscall(__NR_io_uring_register, ring, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+      return Result::Errno("io_uring_register()");
+    }
+    for (unsigned i = 0; i < kBuffers; i++) {
+      Recycle(i);
+    }
+    // Nothing to cancel.
+    return Cancel(kRemove);
+  }
+
+  // Give a buffer back to the kernel.
+  void Recycle(int bid) {
+    auto buf = &br[br_tail & (kBuffers - 1)];
+    buf->addr = (uint64_t) (buffers + (size_t) bid * kBufferSize);
+    buf->len = kBufferSize;
+    buf->bid = bid;
+    br_tail++;
+    // The tail overlays resv of the first entry.
+    __atomic_store_n(&((io_uring_buf_ring*) br)->tail, br_tail, __ATOMIC_RELEASE);
+  }
+
+  static uint64_t Encode(int fd, uint32_t gen) {
+    return ((uint64_t) gen << 32) | (uint32_t) fd;
+  }
+
+  Result Enter(unsigned min_complete, unsigned flags) {
+    int n = syscall(__NR_io_uring_enter, ring, pending, min_complete, flags, NULL, 0);
+    if (n == -1) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY || errno == ETIME) {
+        return Result::OK();
+      }
+      return Result::Errno("io_uring_enter()");
+    }
+    pending -= std::min((unsigned) n, pending);
+    return Result::OK();
+  }
+
+  // Cancel the request of user_data and wait,
+  // its completions are left in the completion queue.
+  Result Cancel(uint64_t user_data) {
+    if (pending > 0) {
+      // The request may not be submitted yet.
+      NDB_TRY(Enter(0, 0));
+    }
+    io_uring_sync_cancel_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = user_data;
+    reg.fd = -1;
+    reg.timeout.tv_sec = -1;
+    reg.timeout.tv_nsec = -1;
+    if (syscall(__NR_io_uring_register, ring, IORING_REGISTER_SYNC_CANCEL, &reg, 1) == -1) {
+      if (errno != ENOENT && errno != EALREADY) {
+        return Result::Errno("io_uring_register()");
+      }
+    }
+    return Result::OK();
+  }
+
+  // Return a zeroed SQE, Push() it after filled.
+  io_uring_sqe* Next() {
+    unsigned tail = *sq_tail;
+    if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+      Enter(0, 0);
+      if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+        return NULL;
+      }
+    }
+    auto sqe = &sqes[tail & *sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+  }
+
+  void Push() {
+    unsigned tail = *sq_tail;
+    unsigned index = tail & *sq_mask;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    pending++;
+  }
+
+  // Queue the request to watch fd by its op and event.
+  Result Arm(int fd, Poll* poll) {
+    auto op = poll->op;
+    if (op == kRecv && !Readable(poll->event)) {
+      // Polled while watched writable.
+      op = kPoll;
+    }
+    auto sqe = Next();
+    if (sqe == NULL) {
+      return Result::Error("io_uring submission queue full");
+    }
+    poll->gen = ++gen;
+    poll->armed = true;
+    poll->armed_op = op;
+    sqe->fd = fd;
+    sqe->user_data = Encode(fd, poll->gen);
+    switch (op) {
+      case kPoll:
+        sqe->opcode = IORING_OP_POLL_ADD;
+        if (Readable(poll->event)) sqe->poll_events |= POLLIN;
+        if (Writable(poll->event)) sqe->poll_events |= POLLOUT;
+        break;
+      case kAccept:
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        break;
+      case kRecv:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+        if (!poll->stash.empty()) {
+          // Stashed data go before data received next.
+          stashed.push_back(fd);
+        }
+        break;
+    }
+    Push();
+    return Result::OK();
+  }
+
+  Result PollRemove(int fd, Poll* poll) {
+    auto sqe = Next();
+    if (sqe == NULL) {
+      return Result::Error("io_uring submission queue full");
+    }
+    poll->armed = false;
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = Encode(fd, poll->gen);
+    sqe->user_data = kRemove;
+    Push();
+    return Result::OK();
+  }
+
+  // Stop the request in flight of fd.
+  Result Disarm(int fd, Poll* poll) {
+    if (poll->armed_op == kPoll) {
+      return poll->armed ? PollRemove(fd, poll) : Result::OK();
+    }
+    auto user_data = Encode(fd, poll->gen);
+    if (poll->armed) {
+      NDB_TRY(Cancel(user_data));
+      poll->armed = false;
+    }
+    // Readies are left even if the request has ended in this loop.
+    Drain(poll, user_data);
+    return Result::OK();
+  }
+
+  // Take completions of a cancelled multishot request which are not passed
+  // to the callback yet, in readies after the current one or in the
+  // completion queue. Received data are moved to the stash.
+  void Drain(Poll* poll, uint64_t user_data) {
+    int fd = (int) (uint32_t) user_data;
+    uint32_t g = user_data >> 32;
+    for (size_t i = ready_pos + 1; i < readies.size(); i++) {
+      auto& ready = readies[i];
+      if (ready.fd != fd || ready.gen != g || ready.event == 0) {
+        continue;
+      }
+      if (Received(ready.event) && ready.bid >= 0) {
+        // The buffer is recycled after callbacks.
+        poll->stash.append(buffers + (size_t) ready.bid * kBufferSize, ready.res);
+      } else if (Accepted(ready.event)) {
+        close(ready.res);
+      }
+      ready.event = 0;
+    }
+
+    unsigned head = *cq_head;
+    unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      auto& cqe = cqes[head & *cq_mask];
+      if (cqe.user_data != user_data) {
+        continue;
+      }
+      if (cqe.flags & IORING_CQE_F_BUFFER) {
+        int bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        if (cqe.res > 0) {
+          poll->stash.append(buffers + (size_t) bid * kBufferSize, cqe.res);
+        }
+        Recycle(bid);
+      } else if (poll->armed_op == kAccept && cqe.res >= 0) {
+        close(cqe.res);
+      }
+      // Ignored by Run().
+      cqe.user_data = kRemove;
+    }
+  }
+
+  Result Watch(int fd, Event event, Op op) {
+    if (polls.count(fd)) {
+      return Result::Error("io_uring add fd %d: exists", fd);
+    }
+    auto& poll = polls[fd];
+    poll.event = event;
+    poll.op = op;
+    auto r = Arm(fd, &poll);
+    if (!r.ok()) {
+      polls.erase(fd);
+    }
+    return r;
+  }
+
+  Result Add(int fd, Event event) override {
+    return Watch(fd, event, kPoll);
+  }
+
+  Result Accept(int fd) override {
+    if (!has_multishot) {
+      return Rep::Accept(fd);
+    }
+    return Watch(fd, kReadable, kAccept);
+  }
+
+  Result Recv(int fd, Event event) override {
+    if (!has_multishot) {
+      return Rep::Recv(fd, event);
+    }
+    return Watch(fd, event, kRecv);
+  }
+
+  Result Mod(int fd, Event event) override {
+    auto it = polls.find(fd);
+    if (it == polls.end()) {
+      return Result::Error("io_uring mod fd %d: not found", fd);
+    }
+    auto& poll = it->second;
+    poll.event = event;
+    if (poll.armed_op == kAccept || (poll.armed_op == kRecv && Readable(event))) {
+      // Keep accepting or receiving.
+      return Result::OK();
+    }
+    if (!poll.armed && poll.armed_op == kPoll) {
+      // Armed with the new event after the callback.
+      return Result::OK();
+    }
+    NDB_TRY(Disarm(fd, &poll));
+    return Arm(fd, &poll);
+  }
+
+  Result Del(int fd, std::string* unread) override {
+    auto it = polls.find(fd);
+    if (it == polls.end()) {
+      return Result::Error("io_uring del fd %d: not found", fd);
+    }
+    NDB_TRY(Disarm(fd, &it->second));
+    if (unread != NULL) {
+      *unread = std::move(it->second.stash);
+    }
+    polls.erase(it);
+    return Result::OK();
+  }
+
+  Result Run(const Callback& cb, milliseconds timeout) override {
+    // Wait for one completion at most timeout, unless stashes are waiting.
+    unsigned wait = 0;
+    if (stashed.empty()) {
+      auto sqe = Next();
+      if (sqe != NULL) {
+        ts.tv_sec = timeout.count() / 1000;
+        ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t) &ts;
+        sqe->len = 1;
+        sqe->off = 1;
+        sqe->user_data = kTimeout;
+        Push();
+      }
+      wait = 1;
+    }
+    NDB_TRY(Enter(wait, IORING_ENTER_GETEVENTS));
+
+    // Stashes were received before completions.
+    readies.clear();
+    for (auto fd : stashed) {
+      readies.push_back({fd, kReceived, 0, 0, -1});
+    }
+    stashed.clear();
+
+    unsigned head = *cq_head;
+    unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      const auto& cqe = cqes[head & *cq_mask];
+      if (cqe.user_data == kTimeout || cqe.user_data == kRemove) {
+        continue;
+      }
+      int fd = (int) (uint32_t) cqe.user_data;
+      uint32_t g = cqe.user_data >> 32;
+      int bid = -1;
+      if (cqe.flags & IORING_CQE_F_BUFFER) {
+        bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+      }
+      auto it = polls.find(fd);
+      if (it == polls.end() || it->second.gen != g) {
+        // Removed or modified.
+        if (bid >= 0) Recycle(bid);
+        continue;
+      }
+      auto& poll = it->second;
+      if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        poll.armed = false;
+      }
+      int res = cqe.res;
+      if (poll.armed_op == kAccept) {
+        if (res >= 0) {
+          readies.push_back({fd, kAccepted, g, res, -1});
+          continue;
+        }
+      } else if (poll.armed_op == kRecv) {
+        if (bid >= 0 && res > 0) {
+          readies.push_back({fd, kReceived, g, res, bid});
+          continue;
+        }
+        if (bid >= 0) Recycle(bid);
+      }
+      if (poll.armed_op != kPoll) {
+        // EOF and errors are found by reading fd, which is
+        // polled from now on if multishot is not supported.
+        if (res == -EINVAL) poll.op = kPoll;
+        readies.push_back({fd, kReadable, g, res, -1});
+        continue;
+      }
+      if (res < 0) {
+        res = POLLERR;
+      }
+      if ((res & POLLIN) || (res & POLLHUP)) {
+        readies.push_back({fd, kReadable, g, res, -1});
+      } else if ((res & POLLOUT) || (res & POLLERR)) {
+        readies.push_back({fd, kWritable, g, res, -1});
+      } else {
+        readies.push_back({fd, 0, g, res, -1});
+      }
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+    for (ready_pos = 0; ready_pos < readies.size(); ready_pos++) {
+      const auto& ready = readies[ready_pos];
+      if (ready.event == 0) {
+        continue;
+      }
+      auto it = polls.find(ready.fd);
+      if (Received(ready.event) && ready.bid < 0) {
+        // Stash of a fd still receiving.
+        if (it == polls.end() || it->second.op != kRecv ||
+            !Readable(it->second.event) || it->second.stash.empty()) {
+          continue;
+        }
+        std::string data;
+        data.swap(it->second.stash);
+        received = data;
+        cb(ready.fd, kReceived);
+        continue;
+      }
+      if (it == polls.end() || it->second.gen != ready.gen) {
+        if (Accepted(ready.event)) close(ready.res);
+        continue;
+      }
+      if (Accepted(ready.event)) {
+        cb(ready.res, kAccepted);
+      } else if (Received(ready.event)) {
+        received = Slice(buffers + (size_t) ready.bid * kBufferSize, ready.res);
+        cb(ready.fd, kReceived);
+      } else {
+        cb(ready.fd, ready.event);
+      }
+    }
+    received = Slice();
+
+    for (const auto& ready : readies) {
+      if (ready.bid >= 0) Recycle(ready.bid);
+    }
+
+    // Arm again, submitted with the next wait.
+    for (const auto& ready : readies) {
+      auto it = polls.find(ready.fd);
+      if (it != polls.end() && !it->second.armed) {
+        NDB_TRY(Arm(ready.fd, &it->second));
+      }
+    }
+    return Result::OK();
   }
 };
 
+#endif  // NDB_HAVE_IO_URING
+
 IOLoop::IOLoop() {
-  rep_ = new Rep();
+  rep_ = new EpollRep();
 }
 
 IOLoop::~IOLoop() {
   delete rep_;
 }
 
+Result IOLoop::SetBackend(const std::string& name) {
+  if (name == "epoll") {
+    delete rep_;
+    rep_ = new EpollRep();
+    return Result::OK();
+  }
+#ifdef NDB_HAVE_IO_URING
+  if (name == "io_uring") {
+    auto rep = new UringRep();
+    auto r = rep->Open();
+    if (!r.ok()) {
+      delete rep;
+      return r;
+    }
+    delete rep_;
+    rep_ = rep;
+    return Result::OK();
+  }
+#endif
+  return Result::Error("Unsupported ioloop backend %s", name.c_str());
+}
+
+const char* IOLoop::backend() const {
+  return rep_->name();
+}
+
+bool IOLoop::multishot() const {
+  return rep_->multishot();
+}
+
 Result IOLoop::Add(int fd, Event event) {
-  return rep_->Ctl(EPOLL_CTL_ADD, fd, event);
+  return rep_->Add(fd, event);
 }
 
-Result IOLoop::Mod(int fd, Event event) {
-  return rep_->Ctl(EPOLL_CTL_MOD, fd, event);
+Result IOLoop::Accept(int fd) {
+  return rep_->Accept(fd);
 }
 
-Result IOLoop::Del(int fd) {
-  return rep_->Ctl(EPOLL_CTL_DEL, fd, 0);
+Result IOLoop::Recv(int fd, Event event) {
+  return rep_->Recv(fd, event);
 }
 
-Result IOLoop::Run(Callback cb, milliseconds timeout) {
-  int n = rep_->Wait(timeout);
-  if (n == -1) {
-    return Result::Errno("epoll_wait()");
-  }
+Slice IOLoop::received() const {
+  return rep_->received;
+}
 
-  for (int i = 0; i < n; i++) {
-    auto fd = rep_->events[i].data.fd;
-    auto events = rep_->events[i].events;
-    if ((events & EPOLLIN) || (events & EPOLLHUP)) {
-      cb(fd, kReadable);
-    } else if ((events & EPOLLOUT) || (events & EPOLLERR)) {
-      cb(fd, kWritable);
-    }
-  }
+Result IOLoop::Mod(int fd, Event event) {
+  return rep_->Mod(fd, event);
+}
+
+Result IOLoop::Del(int fd, std::string* unread) {
+  return rep_->Del(fd, unread);
+}
 
-  return Result::OK();
+Result IOLoop::Run(Callback cb, milliseconds timeout) {
+  return rep_->Run(cb, timeout);
 }
 
 }  // namespace ndb
@@ -10,9 +10,14 @@ class IOLoop {
   typedef int Event;
   static const Event kReadable = (1 << 0);
   static const Event kWritable = (1 << 1);
+  // Events of multishot accept and receive, see Accept() and Recv().
+  static const Event kAccepted = (1 << 2);
+  static const Event kReceived = (1 << 3);
 
   static bool Readable(Event event) { return event & kReadable; }
   static bool Writable(Event event) { return event & kWritable; }
+  static bool Accepted(Event event) { return event & kAccepted; }
+  static bool Received(Event event) { return event & kReceived; }
 
   typedef std::function<void (int, Event)> Callback;
 
@@ -20,16 +25,42 @@ class IOLoop {
 
   ~IOLoop();
 
+  // Backend is "epoll" (default) or "io_uring",
+  // switch it before adding any fd.
+  Result SetBackend(const std::string& name);
+
+  const char* backend() const;
+
+  // Whether Accept() and Recv() are supported, by io_uring on Linux 6.0+.
+  bool multishot() const;
+
   Result Add(int fd, Event event);
 
+  // Accept connections on a listen fd until Del(), each new fd is passed
+  // to the callback with kAccepted instead of the listen fd being readable.
+  Result Accept(int fd);
+
+  // Add fd like Add(), but while it is watched readable data are received
+  // into registered buffers, and passed to the callback with kReceived and
+  // received() instead of fd being readable. EOF and errors are passed as
+  // kReadable, so they are found by reading fd.
+  Result Recv(int fd, Event event);
+
+  // Data received of the current kReceived callback.
+  Slice received() const;
+
   Result Mod(int fd, Event event);
 
-  Result Del(int fd);
+  // Data received but not passed to the callback yet are moved to unread,
+  // they are dropped if unread is NULL.
+  Result Del(int fd, std::string* unread = NULL);
 
   Result Run(Callback cb, milliseconds timeout);
 
  private:
   struct Rep;
+  struct EpollRep;
+  struct UringRep;
   Rep* rep_ {NULL};
 };
 
@@ -27,7 +27,7 @@ Result Socket::Accept(int* connfd) {
   return Result::OK();
 }
 
-Result Socket::Listen(const std::string& address) {
+Result Socket::Listen(const std::string& address, bool reuseport) {
   std::string host, port;
   if (!ParseAddress(address, &host, &port)) {
     return Result::Error("Invalid address");
@@ -53,16 +53,19 @@ Result Socket::Listen(const std::string& address) {
     if (fd_ == -1) {
       continue;
     }
-    r = Listen(p->ai_addr, p->ai_addrlen);
+    r = Listen(p->ai_addr, p->ai_addrlen, reuseport);
     break;
   }
   freeaddrinfo(info);
   return r;
 }
 
-Result Socket::Listen(const sockaddr* addr, socklen_t addrlen) {
+Result Socket::Listen(const sockaddr* addr, socklen_t addrlen, bool reuseport) {
   SetNonBlock();
   SetReuseAddr();
+  if (reuseport) {
+    SetReusePort();
+  }
   if (bind(fd(), addr, addrlen) == -1) {
     return Result::Errno("bind()");
   }
@@ -122,6 +125,11 @@ void Socket::SetReuseAddr() {
   NDB_ASSERT(setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == 0);
 }
 
+void Socket::SetReusePort() {
+  const int on = 1;
+  NDB_ASSERT(setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == 0);
+}
+
 static std::string GetAddrName(const sockaddr_storage* addr) {
   char host[INET6_ADDRSTRLEN] = {0};
   int port = 0;
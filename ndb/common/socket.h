@@ -21,7 +21,9 @@ class Socket {
 
   Result Accept(int* connfd);
 
-  Result Listen(const std::string& address);
+  // Several sockets can listen on the same address with reuseport,
+  // and the kernel balances new connections among them.
+  Result Listen(const std::string& address, bool reuseport = false);
 
   Result Connect(const std::string& address);
 
@@ -29,12 +31,14 @@ class Socket {
 
   void SetReuseAddr();
 
+  void SetReusePort();
+
   std::string GetSockName() const;
 
   std::string GetPeerName() const;
 
  private:
-  Result Listen(const sockaddr* addr, socklen_t addrlen);
+  Result Listen(const sockaddr* addr, socklen_t addrlen, bool reuseport);
 
   Result Connect(const sockaddr* addr, socklen_t addrlen);
 
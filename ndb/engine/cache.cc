@@ -0,0 +1,104 @@
+#include "ndb/engine/cache.h"
+
+namespace ndb {
+
+// Memory of an entry besides its key and value.
+static const size_t kEntryOverhead = 64;
+
+ValueCache::ValueCache(size_t capacity, size_t num_shards)
+    : shard_capacity_(capacity / num_shards), shards_(num_shards) {
+}
+
+std::string ValueCache::Key(uint32_t cfid, const Slice& id) {
+  std::string key;
+  key.reserve(sizeof(cfid) + id.size());
+  key.append(reinterpret_cast<const char*>(&cfid), sizeof(cfid));
+  key.append(id.data(), id.size());
+  return key;
+}
+
+ValueCache::Shard* ValueCache::GetShard(const Slice& key) {
+  return &shards_[SliceHash()(key) % shards_.size()];
+}
+
+bool ValueCache::Lookup(const Slice& key, std::string* value, bool* found, uint64_t* generation) {
+  auto shard = GetShard(key);
+  std::unique_lock<std::mutex> lock(shard->lock);
+  auto it = shard->index.find(key);
+  if (it == shard->index.end()) {
+    *generation = shard->generation;
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  auto entry = it->second;
+  shard->entries.splice(shard->entries.begin(), shard->entries, entry);
+  value->assign(entry->value);
+  *found = entry->found;
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void ValueCache::Insert(const Slice& key, const Slice& value, bool found, uint64_t generation) {
+  auto shard = GetShard(key);
+  std::unique_lock<std::mutex> lock(shard->lock);
+  if (shard->generation != generation) {
+    // Writers have changed the shard, the value may be stale.
+    return;
+  }
+  Put(shard, key, value, found);
+}
+
+void ValueCache::Update(const Slice& key, const Slice& value) {
+  auto shard = GetShard(key);
+  std::unique_lock<std::mutex> lock(shard->lock);
+  shard->generation++;
+  Put(shard, key, value, true);
+}
+
+void ValueCache::Erase(const Slice& key) {
+  auto shard = GetShard(key);
+  std::unique_lock<std::mutex> lock(shard->lock);
+  shard->generation++;
+  Remove(shard, key);
+}
+
+void ValueCache::Put(Shard* shard, const Slice& key, const Slice& value, bool found) {
+  Remove(shard, key);
+  auto charge = key.size() + value.size() + kEntryOverhead;
+  if (charge > shard_capacity_) return;
+
+  // Evict the least recently used.
+  while (shard->usage + charge > shard_capacity_) {
+    const auto& entry = shard->entries.back();
+    shard->usage -= entry.key.size() + entry.value.size() + kEntryOverhead;
+    shard->index.erase(entry.key);
+    shard->entries.pop_back();
+  }
+
+  shard->entries.push_front({key.ToString(), value.ToString(), found});
+  auto entry = shard->entries.begin();
+  shard->index[entry->key] = entry;
+  shard->usage += charge;
+}
+
+void ValueCache::Remove(Shard* shard, const Slice& key) {
+  auto it = shard->index.find(key);
+  if (it == shard->index.end()) return;
+  auto entry = it->second;
+  shard->usage -= entry->key.size() + entry->value.size() + kEntryOverhead;
+  shard->index.erase(it);
+  shard->entries.erase(entry);
+}
+
+size_t ValueCache::GetUsage(size_t* entries) {
+  size_t usage = 0;
+  *entries = 0;
+  for (auto& shard : shards_) {
+    std::unique_lock<std::mutex> lock(shard.lock);
+    usage += shard.usage;
+    *entries += shard.index.size();
+  }
+  return usage;
+}
+
+}  // namespace ndb
@@ -0,0 +1,72 @@
+#ifndef NDB_ENGINE_CACHE_H_
+#define NDB_ENGINE_CACHE_H_
+
+#include "ndb/common/encode.h"
+#include "ndb/engine/common.h"
+
+namespace ndb {
+
+// Sharded LRU cache of encoded values, e.g. collection metas.
+// Readers insert what they got from db only if no writer has changed
+// the shard since they missed, so a stale value never overrides a newer one.
+class ValueCache {
+ public:
+  ValueCache(size_t capacity, size_t num_shards = 64);
+
+  // Key of an id in the namespace with column family id.
+  static std::string Key(uint32_t cfid, const Slice& id);
+
+  // Return false if missed, and the generation to insert with.
+  bool Lookup(const Slice& key, std::string* value, bool* found, uint64_t* generation);
+
+  // Insert by readers, found is false if the key does not exist.
+  void Insert(const Slice& key, const Slice& value, bool found, uint64_t generation);
+
+  // Update or erase by writers after commit.
+  void Update(const Slice& key, const Slice& value);
+  void Erase(const Slice& key);
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+  // Memory usage and number of entries.
+  size_t GetUsage(size_t* entries);
+
+ private:
+  struct Entry {
+    std::string key;
+    std::string value;
+    bool found;
+  };
+
+  struct SliceHash {
+    size_t operator()(const Slice& s) const {
+      return BKDRHash(s.data(), s.size());
+    }
+  };
+
+  struct Shard {
+    std::mutex lock;
+    uint64_t generation {0};
+    size_t usage {0};
+    // The most recently used is at the front.
+    std::list<Entry> entries;
+    std::unordered_map<Slice, std::list<Entry>::iterator, SliceHash> index;
+  };
+
+  Shard* GetShard(const Slice& key);
+
+  // Caller should hold the shard's lock.
+  void Put(Shard* shard, const Slice& key, const Slice& value, bool found);
+  void Remove(Shard* shard, const Slice& key);
+
+ private:
+  size_t shard_capacity_ {0};
+  std::vector<Shard> shards_;
+  std::atomic<uint64_t> hits_ {0};
+  std::atomic<uint64_t> misses_ {0};
+};
+
+}  // namespace ndb
+
+#endif /* NDB_ENGINE_CACHE_H_ */
@@ -0,0 +1,118 @@
+#include "ndb/engine/combiner.h"
+
+namespace ndb {
+
+// Batches are encoded as sequence(fixed64), count(fixed32) and records.
+static const size_t kBatchHeader = 12;
+
+Status WriteCombiner::Write(rocksdb::WriteBatch* batch) {
+  auto size = batch->GetDataSize();
+  if (size >= options_.max_batch_size) {
+    batches_++;
+    groups_++;
+    histogram_[0]++;
+    return db_->Write(wopts_, batch);
+  }
+
+  Writer w;
+  w.batch = batch;
+  std::unique_lock<std::mutex> lock(lock_);
+  queue_.push_back(&w);
+  queue_size_ += size;
+  if (queue_size_ >= options_.max_batch_size) {
+    // Wake up the leader waiting for more batches.
+    cond_.notify_all();
+  }
+  cond_.wait(lock, [&] { return w.done || (!writing_ && queue_.front() == &w); });
+  if (w.done) {
+    return w.status;
+  }
+
+  // Lead a group.
+  writing_ = true;
+  if (options_.max_delay_usecs > 0) {
+    cond_.wait_for(lock, std::chrono::microseconds(options_.max_delay_usecs),
+                   [&] { return queue_size_ >= options_.max_batch_size; });
+  }
+  std::vector<Writer*> group;
+  size_t group_size = 0;
+  while (!queue_.empty()) {
+    auto next = queue_.front()->batch->GetDataSize();
+    if (!group.empty() && group_size + next > options_.max_batch_size) {
+      break;
+    }
+    group.push_back(queue_.front());
+    group_size += next;
+    queue_.pop_front();
+  }
+  queue_size_ -= group_size;
+
+  lock.unlock();
+  WriteGroup(group);
+  lock.lock();
+
+  for (auto writer : group) {
+    writer->done = true;
+  }
+  writing_ = false;
+  cond_.notify_all();
+  return w.status;
+}
+
+void WriteCombiner::WriteGroup(const std::vector<Writer*>& group) {
+  batches_ += group.size();
+  groups_++;
+  size_t bucket = 0;
+  while (bucket + 1 < kNumBuckets && (2UL << bucket) <= group.size()) {
+    bucket++;
+  }
+  histogram_[bucket]++;
+
+  if (group.size() == 1) {
+    group[0]->status = db_->Write(wopts_, group[0]->batch);
+    return;
+  }
+
+  // Append records of all batches to the first one's and sum their counts,
+  // the combined batch is written atomically, so writers share the status.
+  std::string rep = group[0]->batch->Data();
+  uint32_t count = group[0]->batch->Count();
+  for (size_t i = 1; i < group.size(); i++) {
+    const auto& data = group[i]->batch->Data();
+    rep.append(data, kBatchHeader, std::string::npos);
+    count += group[i]->batch->Count();
+  }
+  for (size_t i = 0; i < sizeof(count); i++) {
+    rep[8 + i] = static_cast<char>(count >> (8 * i));
+  }
+  // Records of dropped column families are skipped instead of failing the
+  // write half-way, as if they were written right before the drop. Other
+  // errors are raised before anything is applied, so batches are written
+  // alone again to fail only bad ones.
+  rocksdb::WriteBatch combined(rep);
+  auto wopts = wopts_;
+  wopts.ignore_missing_column_families = true;
+  auto s = db_->Write(wopts, &combined);
+  if (s.ok()) {
+    for (auto writer : group) {
+      writer->status = s;
+    }
+    return;
+  }
+
+  splits_++;
+  for (auto writer : group) {
+    writer->status = db_->Write(wopts_, writer->batch);
+  }
+}
+
+std::string WriteCombiner::histogram() const {
+  std::string s;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    if (i > 0) s += ",";
+    s += std::to_string(1UL << i) + ":" + std::to_string(histogram_[i].load());
+  }
+  return s;
+}
+
+}  // namespace ndb
@@ -0,0 +1,69 @@
+#ifndef NDB_ENGINE_COMBINER_H_
+#define NDB_ENGINE_COMBINER_H_
+
+#include "ndb/engine/common.h"
+
+namespace ndb {
+
+// Combine small batches committed by concurrent commands into one write.
+// Committers queue their batches, the first one in the queue leads a group:
+// it waits a moment for more batches, writes them as one batch and then
+// completes the others. Groups are written one at a time, batches queued
+// during a write are combined into the next group. If the combined batch
+// fails, its batches are written one by one, so each gets its own status.
+class WriteCombiner {
+ public:
+  struct Options {
+    // Max microseconds a leader waits for more batches, 0 to not wait.
+    size_t max_delay_usecs {0};
+    // Max bytes of a combined batch, 0 to disable combining.
+    size_t max_batch_size {1 << 20};
+  };
+
+  WriteCombiner(rocksdb::DB* db, const rocksdb::WriteOptions& wopts,
+                const Options& options)
+      : db_(db), wopts_(wopts), options_(options) {}
+
+  // Return after batch has been written.
+  Status Write(rocksdb::WriteBatch* batch);
+
+  uint64_t batches() const { return batches_; }
+  uint64_t groups() const { return groups_; }
+  // Number of groups written batch by batch after the combined write failed.
+  uint64_t splits() const { return splits_; }
+  // Number of groups by their batches, as "1:n,2:n,4:n,...".
+  std::string histogram() const;
+
+ private:
+  struct Writer {
+    rocksdb::WriteBatch* batch {NULL};
+    Status status;
+    bool done {false};
+  };
+
+  // Write batches of writers as one batch.
+  void WriteGroup(const std::vector<Writer*>& group);
+
+ private:
+  // Groups of 1, 2-3, 4-7, ... , 128 and more batches.
+  static const size_t kNumBuckets = 8;
+
+  rocksdb::DB* db_ {NULL};
+  rocksdb::WriteOptions wopts_;
+  Options options_;
+
+  std::mutex lock_;
+  std::condition_variable cond_;
+  std::deque<Writer*> queue_;
+  size_t queue_size_ {0};
+  bool writing_ {false};
+
+  std::atomic<uint64_t> batches_ {0};
+  std::atomic<uint64_t> groups_ {0};
+  std::atomic<uint64_t> splits_ {0};
+  std::atomic<uint64_t> histogram_[kNumBuckets] {};
+};
+
+}  // namespace ndb
+
+#endif /* NDB_ENGINE_COMBINER_H_ */
@@ -10,13 +10,16 @@
 #include <rocksdb/table.h>
 #include <rocksdb/statistics.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/merge_operator.h>
+#include <rocksdb/slice_transform.h>
 #include <rocksdb/compaction_filter.h>
 #include <rocksdb/utilities/backupable_db.h>
+#include <rocksdb/utilities/stackable_db.h>
 
 namespace ndb {
 
-using rocksdb::Slice;
 using rocksdb::Status;
+using rocksdb::PinnableSlice;
 
 inline Result ProtobufError() {
   return Result::Error("Protobuf error.");
@@ -6,6 +6,15 @@ static void DeleteMeta(const Slice& id, void* meta) {
   delete reinterpret_cast<CompactionMeta*>(meta);
 }
 
+CompactionMetaCache::CompactionMetaCache(size_t size) {
+  // Entries are charged 1, keep enough of them in each shard.
+  int bits = 0;
+  while (bits < kMaxShardBits && (size >> (bits + 1)) >= kMinShardSize) {
+    bits++;
+  }
+  cache_ = rocksdb::NewLRUCache(size, bits);
+}
+
 bool CompactionMetaCache::Get(const Slice& id, CompactionMeta* meta) {
   auto handle = cache_->Lookup(id);
   if (handle == NULL) return false;
@@ -15,83 +24,219 @@ bool CompactionMetaCache::Get(const Slice& id, CompactionMeta* meta) {
 }
 
 void CompactionMetaCache::Put(const Slice& id, const CompactionMeta& meta) {
-  cache_->Release(cache_->Insert(id, new CompactionMeta(meta), 1, DeleteMeta));
+  cache_->Insert(id, new CompactionMeta(meta), 1, DeleteMeta);
 }
 
 void CompactionMetaCache::Delete(const Slice& id) {
   cache_->Erase(id);
 }
 
+void CompactionMetaCache::AddCounters(uint64_t hits, uint64_t misses, uint64_t memo_hits) {
+  hits_.fetch_add(hits, std::memory_order_relaxed);
+  misses_.fetch_add(misses, std::memory_order_relaxed);
+  memo_hits_.fetch_add(memo_hits, std::memory_order_relaxed);
+}
+
+CompactionFilter::~CompactionFilter() {
+  cache_->AddCounters(hits_, misses_, memo_hits_);
+}
+
+
+CompactionFilter::Decision
+CompactionFilter::FilterV2(int level,
+                           const Slice& id,
+                           ValueType value_type,
+                           const Slice& existing_value,
+                           std::string* new_value,
+                           std::string* skip_until) const {
+  if (value_type != ValueType::kValue) {
+    // Merge operands are filtered after they are merged.
+    return Decision::kKeep;
+  }
+
+  // Members are judged by keys only, values are decoded for migration.
+  if (!IsSimpleKey(id) && !IsMetaKey(id)) {
+    if (FilterMember(id, skip_until)) return Decision::kRemoveAndSkipUntil;
+    if (!ValueView::IsLegacy(existing_value)) return Decision::kKeep;
+  }
 
-bool CompactionFilter::Filter(int level,
-                              const Slice& id,
-                              const Slice& existing_value,
-                              std::string* new_value,
-                              bool* value_changed) const {
   // Parse value.
-  Value value;
-  if (!value.ParseFromArray(existing_value.data(), existing_value.size())) {
-    return true;
+  ValueView value;
+  if (!value.Decode(existing_value).ok()) {
+    return Decision::kRemove;
   }
 
-  Slice tmp = id;
-  std::string kmeta;
-  if (!DecodeMeta(&tmp, &kmeta)) {
+  if (IsSimpleKey(id)) {
     // Simple types.
-    return value.IsDeleted();
+    if (value.IsDeleted()) return Decision::kRemove;
+  } else if (IsMetaKey(id) && value.has_meta()) {
+    // Collection types.
+    if (FilterMeta(id, value)) return Decision::kRemove;
   }
 
-  // Collection types.
-  if (value.has_meta()) {
-    return FilterMeta(kmeta, value);
+  // Migrate legacy values to the compact format.
+  if (value.legacy()) {
+    *new_value = value.Encode();
+    return Decision::kChangeValue;
   }
-  return FilterMember(id);
+  return Decision::kKeep;
 }
 
 Result CompactionFilter::GetMeta(const Slice& kmeta, CompactionMeta* meta) const {
-  if (cache_->Get(kmeta, meta)) return Result::OK();
+  if (!memo_kmeta_.empty() && kmeta == memo_kmeta_) {
+    memo_hits_++;
+    *meta = memo_meta_;
+    return memo_found_ ? Result::OK() : Result::NotFound();
+  }
+
+  // Verdicts of cids are only memorized, cached metas are refreshed by
+  // metas in compactions, which are far from members keyed by cids.
+  uint64_t cid = 0;
+  auto tmp = kmeta;
+  bool by_cid = DecodeCollectionKey(&tmp, &cid);
+  auto key = ValueCache::Key(ns_->GetID(), kmeta);
+  if (!by_cid && cache_->Get(key, meta)) {
+    hits_++;
+    memo_kmeta_.assign(kmeta.data(), kmeta.size());
+    memo_found_ = true;
+    memo_meta_ = *meta;
+    return Result::OK();
+  }
+
+  misses_++;
   Value vmeta;
-  NDB_TRY(ns_->Get(kmeta, &vmeta));
-  if (!vmeta.has_meta()) return Result::NotFound();
-  meta->deleted = vmeta.IsDeleted();
-  meta->version = vmeta.meta().version();
-  cache_->Put(kmeta, *meta);
-  return Result::OK();
+  Result r;
+  if (by_cid) {
+    // The cid is live if its collection key maps to a meta of the cid.
+    Value ckey;
+    r = ns_->Get(kmeta, &ckey);
+    if (r.ok()) {
+      r = ckey.has_bytes() ? ns_->Get(ckey.bytes(), &vmeta) : Result::NotFound();
+    }
+    if (r.ok() && (!vmeta.has_meta() || vmeta.meta().cid() != cid)) {
+      r = Result::NotFound();
+    }
+  } else {
+    r = ns_->Get(kmeta, &vmeta);
+  }
+  if (r.ok() && !vmeta.has_meta()) r = Result::NotFound();
+  if (!r.ok() && !r.IsNotFound()) return r;
+  memo_kmeta_.assign(kmeta.data(), kmeta.size());
+  memo_found_ = r.ok();
+  memo_meta_ = CompactionMeta();
+  if (r.ok()) {
+    meta->deleted = vmeta.IsDeleted();
+    meta->version = vmeta.meta().version();
+    meta->cid = vmeta.meta().cid();
+    memo_meta_ = *meta;
+    if (!by_cid) cache_->Put(key, *meta);
+  }
+  return r;
 }
 
-bool CompactionFilter::FilterMeta(const Slice& kmeta, const Value& vmeta) const {
-  auto begin = EncodePrefix(kmeta, vmeta.meta().version(), 0, 0);
-  auto it = ns_->RangeGet(begin);
-  it->Seek();
-  if (it->Valid()) {
-    if (it->id().size() > kmeta.size() &&
-        memcmp(it->id().data(), kmeta.data(), kmeta.size()) == 0) {
-      cache_->Put(kmeta, {vmeta.IsDeleted(), vmeta.meta().version()});
+void CompactionFilter::PutMeta(const Slice& kmeta, const CompactionMeta& meta) const {
+  memo_kmeta_.assign(kmeta.data(), kmeta.size());
+  memo_found_ = true;
+  memo_meta_ = meta;
+  cache_->Put(ValueCache::Key(ns_->GetID(), kmeta), meta);
+}
+
+void CompactionFilter::DeleteMeta(const Slice& kmeta) const {
+  if (kmeta == memo_kmeta_) memo_kmeta_.clear();
+  cache_->Delete(ValueCache::Key(ns_->GetID(), kmeta));
+}
+
+bool CompactionFilter::FilterMeta(const Slice& kmeta, const ValueView& vmeta) const {
+  CompactionMeta meta(vmeta.IsDeleted(), vmeta.meta_version(), vmeta.meta_cid());
+  // Packed collections have no members but the meta.
+  if (vmeta.meta_has_packed() && !meta.deleted) {
+    PutMeta(kmeta, meta);
+    return false;
+  }
+
+  if (it_ == NULL || it_seeks_ >= kMaxIteratorSeeks) {
+    it_ = ns_->NewIterator();
+    it_seeks_ = 0;
+  }
+  it_seeks_++;
+  // Members of a cid follow its collection key, which is skipped.
+  std::string prefix;
+  if (meta.cid != 0) {
+    prefix = EncodeCollectionKey(meta.cid);
+    it_->Seek(prefix + '\0');
+  } else {
+    prefix = kmeta.ToString();
+    it_->Seek(EncodePrefix(kmeta, meta.version, 0, 0));
+  }
+  if (!it_->status().ok()) {
+    it_.reset();
+    return false;
+  }
+  if (it_->Valid()) {
+    if (it_->key().size() > prefix.size() && it_->key().starts_with(prefix)) {
+      PutMeta(kmeta, meta);
       return false;
     }
   }
-  cache_->Delete(kmeta);
+  DeleteMeta(kmeta);
   return true;
 }
 
-bool CompactionFilter::FilterMember(const Slice& id) const {
-  Slice tmp = id;
-  std::string kmeta;
-  uint64_t version = 0;
-  uint8_t type = 0, subtype = 0;
-  if (!DecodePrefix(&tmp, &kmeta, &version, &type, &subtype)) {
+bool CompactionFilter::FilterMember(const Slice& id, std::string* skip_until) const {
+  // Decode kmeta and version in place.
+  Slice prefix;
+  if (!ExtractPrefix(id, &prefix)) {
     return false;
   }
+  uint64_t cid = 0;
+  auto ckey = prefix;
+  if (DecodeCollectionKey(&ckey, &cid)) {
+    return FilterCollection(prefix, cid, skip_until);
+  }
+  auto pos = static_cast<const char*>(memchr(id.data(), '\0', id.size()));
+  Slice kmeta(id.data(), pos + 1 - id.data());
+  Slice tmp(pos + 1, prefix.size() - kmeta.size());
+  uint64_t version = 0;
+  DecodeVarint64(&tmp, &version);
 
   CompactionMeta meta;
   auto r = GetMeta(kmeta, &meta);
-  if (r.IsNotFound()) return true;
-  if (r.ok()) {
-    if (version < meta.version || (version == meta.version && meta.deleted)) {
-      return true;
+  if (!r.IsNotFound()) {
+    if (!r.ok()) return false;
+    // Collections are given cids when created, after all versions
+    // keyed by kmeta have been dropped.
+    if (meta.cid == 0 &&
+        (version > meta.version || (version == meta.version && !meta.deleted))) {
+      return false;
     }
   }
-  return false;
+
+  // The whole version is dead, skip to the next version. Varints are prefix
+  // free and end with a byte below 0x80, so the successor of the prefix
+  // bounds all members of this version.
+  skip_until->assign(prefix.data(), prefix.size());
+  skip_until->back()++;
+  return true;
+}
+
+bool CompactionFilter::FilterCollection(const Slice& ckey, uint64_t cid,
+                                        std::string* skip_until) const {
+  // The collection key of cid 0 holds the ceiling of reserved cids,
+  // the max cid is never allocated.
+  if (cid == 0 || cid >= kMaxCollectionID) {
+    return false;
+  }
+  CompactionMeta meta;
+  auto r = GetMeta(ckey, &meta);
+  if (!r.IsNotFound()) {
+    if (!r.ok()) return false;
+    // The cid is live if its meta is neither deleted nor expired.
+    if (meta.cid == cid && !meta.deleted) return false;
+  }
+  // Cids are never reused, the collection key and members of a dead cid
+  // are skipped to the next cid.
+  *skip_until = EncodeCollectionKey(cid + 1);
+  return true;
 }
 
 }  // namespace ndb
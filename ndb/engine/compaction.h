@@ -8,19 +8,21 @@ namespace ndb {
 struct CompactionMeta {
   bool     deleted;
   uint64_t version;
-  CompactionMeta(bool d = false, uint64_t v = 0)
-      : deleted(d), version(v) {
+  uint64_t cid;
+  CompactionMeta(bool d = false, uint64_t v = 0, uint64_t c = 0)
+      : deleted(d), version(v), cid(c) {
   }
   CompactionMeta(const CompactionMeta& meta)
-      : deleted(meta.deleted), version(meta.version) {
+      : deleted(meta.deleted), version(meta.version), cid(meta.cid) {
   }
 };
 
+// Metas of collections shared by compactions of all namespaces, keyed by
+// column family ids and kmetas. The LRU cache is sharded, so parallel
+// compactions rarely contend for one lock.
 class CompactionMetaCache {
  public:
-  CompactionMetaCache(size_t size) {
-    cache_ = rocksdb::NewLRUCache(size);
-  }
+  CompactionMetaCache(size_t size);
 
   bool Get(const Slice& id, CompactionMeta* meta);
 
@@ -28,40 +30,79 @@ class CompactionMetaCache {
 
   void Delete(const Slice& id);
 
+  // Counters are added by filters when they finish.
+  void AddCounters(uint64_t hits, uint64_t misses, uint64_t memo_hits);
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+  uint64_t memo_hits() const { return memo_hits_; }
+
  private:
+  static const int kMaxShardBits = 6;
+  static const size_t kMinShardSize = 1024;
+
   std::shared_ptr<rocksdb::Cache> cache_;
+  std::atomic<uint64_t> hits_ {0};
+  std::atomic<uint64_t> misses_ {0};
+  std::atomic<uint64_t> memo_hits_ {0};
 };
 
+// A filter is used by one compaction at a time, members of a collection
+// arrive consecutively after its meta, so the last meta is memorized.
 class CompactionFilter : public rocksdb::CompactionFilter {
  public:
   CompactionFilter(NSRef ns, std::shared_ptr<CompactionMetaCache> cache)
       : ns_(ns), cache_(cache) {}
 
-  bool Filter(int level,
-              const Slice& id,
-              const Slice& existing_value,
-              std::string* new_value,
-              bool* value_changed) const override;
+  ~CompactionFilter();
+
+  // Members of a dead collection version or cid are removed with the rest
+  // of the version or cid skipped, instead of being judged one by one.
+  Decision FilterV2(int level,
+                    const Slice& id,
+                    ValueType value_type,
+                    const Slice& existing_value,
+                    std::string* new_value,
+                    std::string* skip_until) const override;
 
   const char* Name() const override { return "NDBCompactionFilter"; }
 
  private:
+  // Get the meta of kmeta, or of the live cid of a collection key,
+  // return NotFound if the cid is dead.
   Result GetMeta(const Slice& kmeta, CompactionMeta* vmeta) const;
+  void PutMeta(const Slice& kmeta, const CompactionMeta& vmeta) const;
+  void DeleteMeta(const Slice& kmeta) const;
 
-  bool FilterMeta(const Slice& kmeta, const Value& vmeta) const;
-  bool FilterMember(const Slice& id) const;
+  bool FilterMeta(const Slice& kmeta, const ValueView& vmeta) const;
+  bool FilterMember(const Slice& id, std::string* skip_until) const;
+  bool FilterCollection(const Slice& ckey, uint64_t cid, std::string* skip_until) const;
 
  private:
+  // Iterators pin the data they see, renew it after some seeks.
+  static const size_t kMaxIteratorSeeks = 1024;
+
   NSRef ns_;
   std::shared_ptr<CompactionMetaCache> cache_;
+
+  // The last meta looked up, found or not.
+  mutable std::string memo_kmeta_;
+  mutable bool memo_found_ {false};
+  mutable CompactionMeta memo_meta_;
+
+  mutable std::unique_ptr<rocksdb::Iterator> it_;
+  mutable size_t it_seeks_ {0};
+
+  mutable uint64_t hits_ {0};
+  mutable uint64_t misses_ {0};
+  mutable uint64_t memo_hits_ {0};
 };
 
 class CompactionFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-  CompactionFilterFactory(Engine* engine, const std::string& nsname, size_t cache_size)
-      : engine_(engine), nsname_(nsname) {
-    cache_.reset(new CompactionMetaCache(cache_size));
-  }
+  CompactionFilterFactory(Engine* engine, const std::string& nsname,
+                          std::shared_ptr<CompactionMetaCache> cache)
+      : engine_(engine), nsname_(nsname), cache_(cache) {}
 
   std::unique_ptr<rocksdb::CompactionFilter>
   CreateCompactionFilter(const rocksdb::CompactionFilter::Context& context) override {
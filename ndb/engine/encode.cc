@@ -18,6 +18,15 @@ bool DecodeMeta(Slice* dst, std::string* kmeta) {
   return false;
 }
 
+bool IsMetaKey(const Slice& key) {
+  auto pos = memchr(key.data(), '\0', key.size());
+  return pos != NULL && pos == key.data() + key.size() - 1;
+}
+
+bool IsSimpleKey(const Slice& key) {
+  return memchr(key.data(), '\0', key.size()) == NULL;
+}
+
 void EncodeInt64(std::string* dst, int64_t i) {
   uint64_t u = i ^ (1ULL << 63);
   EncodeUint64(dst, u);
@@ -111,10 +120,104 @@ bool DecodePrefix(Slice* dst, std::string* kmeta, uint64_t* version, uint8_t* ty
 }
 
 bool RemovePrefix(Slice* dst) {
+  uint64_t cid = 0;
+  auto tmp = *dst;
+  if (DecodeCollectionKey(&tmp, &cid)) {
+    if (tmp.size() == 0) return false;
+    tmp.remove_prefix(1);
+    *dst = tmp;
+    return true;
+  }
   std::string kmeta;
   uint64_t version;
   uint8_t type, subtype;
   return DecodePrefix(dst, &kmeta, &version, &type, &subtype);
 }
 
+std::string EncodeCollectionKey(uint64_t cid) {
+  NDB_ASSERT(cid <= kMaxCollectionID);
+  std::string dst(kCollectionKeySize, '\0');
+  for (size_t i = kCollectionKeySize - 1; i > 0; i--) {
+    dst[i] = 0x80 | (cid & 0x7f);
+    cid >>= 7;
+  }
+  return dst;
+}
+
+bool DecodeCollectionKey(Slice* dst, uint64_t* cid) {
+  if (dst->size() < kCollectionKeySize || (*dst)[0] != '\0') {
+    return false;
+  }
+  uint64_t v = 0;
+  for (size_t i = 1; i < kCollectionKeySize; i++) {
+    uint8_t byte = (*dst)[i];
+    if (!(byte & 0x80)) return false;
+    v = (v << 7) | (byte & 0x7f);
+  }
+  *cid = v;
+  dst->remove_prefix(kCollectionKeySize);
+  return true;
+}
+
+std::string EncodePrefix(const Slice& kmeta, const pb::Meta& meta, uint8_t type, uint8_t subtype) {
+  if (meta.cid() == 0) {
+    return EncodePrefix(kmeta, meta.version(), type, subtype);
+  }
+  std::string dst = EncodeCollectionKey(meta.cid());
+  NDB_ASSERT(type < (1 << 5) && subtype < (1 << 3));
+  dst.push_back(type << 3 | subtype);
+  return dst;
+}
+
+std::string EncodeExpireKey(uint64_t expire, const Slice& nsname, const Slice& id) {
+  std::string key;
+  key.reserve(sizeof(expire) + 5 + nsname.size() + id.size());
+  EncodeUint64(&key, expire);
+  EncodeVarint64(&key, nsname.size());
+  key.append(nsname.data(), nsname.size());
+  key.append(id.data(), id.size());
+  return key;
+}
+
+bool DecodeExpireKey(Slice* dst, uint64_t* expire, Slice* nsname) {
+  uint64_t size = 0;
+  if (!DecodeUint64(dst, expire) || !DecodeVarint64(dst, &size) || dst->size() < size) {
+    return false;
+  }
+  *nsname = Slice(dst->data(), size);
+  dst->remove_prefix(size);
+  return true;
+}
+
+bool ExtractPrefix(const Slice& key, Slice* prefix) {
+  // The type byte is excluded, so that ranges ending at the successor
+  // of a type prefix are still in one prefix.
+  uint64_t cid = 0;
+  auto tmp = key;
+  if (DecodeCollectionKey(&tmp, &cid)) {
+    *prefix = Slice(key.data(), kCollectionKeySize);
+    return true;
+  }
+  auto begin = key.data();
+  auto end = key.data() + key.size();
+  auto pos = static_cast<const char*>(memchr(begin, '\0', key.size()));
+  if (pos == NULL) return false;
+  uint64_t version = 0;
+  pos = GetVarint64(pos + 1, end, &version);
+  if (pos == NULL) return false;
+  *prefix = Slice(begin, pos - begin);
+  return true;
+}
+
+Slice PrefixExtractor::Transform(const Slice& key) const {
+  Slice prefix;
+  NDB_ASSERT(ExtractPrefix(key, &prefix));
+  return prefix;
+}
+
+bool PrefixExtractor::InDomain(const Slice& key) const {
+  Slice prefix;
+  return ExtractPrefix(key, &prefix);
+}
+
 }  // namespace ndb
@@ -7,6 +7,10 @@ namespace ndb {
 
 Slice EncodeMeta(const std::string& id);
 bool DecodeMeta(Slice* dst, std::string* kmeta);
+// Meta keys are ids with one trailing '\0'.
+bool IsMetaKey(const Slice& key);
+// Keys of simple types have no '\0'.
+bool IsSimpleKey(const Slice& key);
 
 void EncodeInt64(std::string* dst, int64_t i);
 bool DecodeInt64(Slice* dst, int64_t* i);
@@ -14,10 +18,51 @@ bool DecodeInt64(Slice* dst, int64_t* i);
 void EncodeUint64(std::string* dst, uint64_t u);
 bool DecodeUint64(Slice* dst, uint64_t* u);
 
+void EncodeVarint64(std::string* dst, uint64_t v);
+bool DecodeVarint64(Slice* dst, uint64_t* v);
+
 std::string EncodePrefix(const Slice& kmeta, uint64_t version, uint8_t type, uint8_t subtype);
 bool DecodePrefix(Slice* dst, std::string* kmeta, uint64_t* version, uint8_t* type, uint8_t* subtype);
+// Remove the prefix of both member layouts.
 bool RemovePrefix(Slice* dst);
 
+// Collections with a collection id (cid) key their members by the cid
+// instead of kmeta and version, so long ids are not repeated in members:
+//   '\0' [8 bytes of cid] (type << 3 | subtype) suffix
+// Cids are encoded 7 bits per byte with the high bit set, in big-endian,
+// so they sort in order. They don't collide with members of the empty id
+// whose versions are below 2^56, as their varints end with a byte below
+// 0x80 within 8 bytes. Versions are bumped by one per recreation and never
+// get that large in practice, but higher ones are not guarded against.
+// The collection key itself maps the cid to its kmeta.
+static const size_t kCollectionKeySize = 9;
+static const uint64_t kMaxCollectionID = (1ULL << 56) - 1;
+std::string EncodeCollectionKey(uint64_t cid);
+bool DecodeCollectionKey(Slice* dst, uint64_t* cid);
+
+// Encode the member prefix of meta in the layout of meta.
+std::string EncodePrefix(const Slice& kmeta, const pb::Meta& meta, uint8_t type, uint8_t subtype);
+
+// Keys of the expire index are ordered by expire, then namespace name and id.
+// Names are used instead of column family ids, which differ between dbs.
+std::string EncodeExpireKey(uint64_t expire, const Slice& nsname, const Slice& id);
+bool DecodeExpireKey(Slice* dst, uint64_t* expire, Slice* nsname);
+
+// Extract kmeta and version, or the collection key of a collection
+// member as its prefix.
+bool ExtractPrefix(const Slice& key, Slice* prefix);
+
+// Members of a collection share one prefix, so seeks into a collection
+// can skip files without it by prefix bloom filters.
+class PrefixExtractor : public rocksdb::SliceTransform {
+ public:
+  const char* Name() const override { return "ndb.PrefixExtractor"; }
+
+  Slice Transform(const Slice& key) const override;
+
+  bool InDomain(const Slice& key) const override;
+};
+
 }  // namespace ndb
 
 #endif /* NDB_ENGINE_ENCODE_H_ */
@@ -1,10 +1,25 @@
 #include "ndb/engine/engine.h"
 #include "ndb/engine/compaction.h"
+#include "ndb/engine/merge.h"
 
 namespace ndb {
 
 using namespace rocksdb;
 
+// Hidden column family of the expire index, it is not a namespace.
+static const std::string kExpireIndex = "__expire__";
+
+static CompressionType ToCompressionType(Compression compression) {
+  switch (compression) {
+    case pb::NONE:   return kNoCompression;
+    case pb::SNAPPY: return kSnappyCompression;
+    case pb::ZLIB:   return kZlibCompression;
+    case pb::LZ4:    return kLZ4Compression;
+    case pb::ZSTD:   return kZSTD;
+  }
+  return kNoCompression;
+}
+
 Engine::Engine(const Options& options) : options_(options) {
   dbopts_.create_if_missing = true;
   dbopts_.max_open_files = options.max_open_files;
@@ -16,6 +31,15 @@ Engine::Engine(const Options& options) : options_(options) {
   dbopts_.db_write_buffer_size = options.memtable_size;
   dbopts_.statistics = rocksdb::CreateDBStatistics();
   dbopts_.IncreaseParallelism(options.background_threads);
+  dbopts_.enable_pipelined_write = options.pipelined_write;
+  dbopts_.unordered_write = options.unordered_write;
+  dbopts_.two_write_queues = options.two_write_queues;
+  wopts_.sync = options.sync_mode == "always";
+
+  if (options.meta_cache_size > 0) {
+    meta_cache_.reset(new ValueCache(options.meta_cache_size));
+  }
+  compaction_cache_.reset(new CompactionMetaCache(options.compaction_cache_size));
 
   tbopts_.filter_policy.reset(NewBloomFilterPolicy(10));
   tbopts_.block_cache = NewLRUCache(options.block_cache_size);
@@ -24,6 +48,10 @@ Engine::Engine(const Options& options) : options_(options) {
 
   cfopts_.OptimizeLevelStyleCompaction(options.memtable_size);
   cfopts_.table_factory.reset(NewBlockBasedTableFactory(tbopts_));
+  // Bloom filters and memtable bloom contain prefixes of collection members too.
+  cfopts_.prefix_extractor.reset(new PrefixExtractor());
+  cfopts_.memtable_prefix_bloom_size_ratio = 0.1;
+  cfopts_.merge_operator.reset(new MergeOperator());
   // TODO: Consider the following options.
   // cfopts.inplace_update_support
   // cfopts.inplace_update_num_locks
@@ -31,11 +59,19 @@ Engine::Engine(const Options& options) : options_(options) {
 
 Engine::~Engine() {
   for (auto& ns : namespaces_) { ns.second.reset(); }
+  delete syncer_;
+  delete expire_;
+  delete combiner_;
   delete backup_;
   delete db_;
 }
 
 Result Engine::Open() {
+  const auto& mode = options_.sync_mode;
+  if (mode != "none" && mode != "always" && mode != "periodic") {
+    return Result::Error("Invalid sync mode: %s", mode.c_str());
+  }
+
   std::vector<std::string> cfnames;
   auto s = rocksdb::Env::Default()->FileExists(options_.dbname + "/" + "CURRENT");
   if (s.ok()) {
@@ -45,11 +81,14 @@ Result Engine::Open() {
     cfnames.push_back("default");
   }
 
+  std::map<std::string, Configs> configs;
+  if (s.ok()) {
+    NDB_TRY(LoadConfigs(cfnames, &configs));
+  }
+
   std::vector<ColumnFamilyDescriptor> cfds;
   for (auto name : cfnames) {
-    cfopts_.compaction_filter_factory.reset(
-        new CompactionFilterFactory(this, name, options_.compaction_cache_size));
-    cfds.emplace_back(name, cfopts_);
+    cfds.emplace_back(name, NewCFOptions(name, configs[name]));
   }
 
   std::vector<rocksdb::ColumnFamilyHandle*> handles;
@@ -58,17 +97,122 @@ Result Engine::Open() {
 
   backup_ = new Backup(db_);
 
+  WriteCombiner::Options combiner;
+  combiner.max_batch_size = options_.write_combine_size;
+  combiner.max_delay_usecs = options_.write_combine_usecs;
+  combiner_ = new WriteCombiner(db_, wopts_, combiner);
+  syncer_ = new WALSyncer(db_, dbopts_.statistics,
+                          mode == "periodic" ? options_.sync_interval_msecs : 0);
+
+  // Init the expire index. It is created at open before any namespace,
+  // so fresh masters and slaves give it the same column family id, which
+  // replicated batches refer to.
+  for (auto it = handles.begin(); it != handles.end(); it++) {
+    if ((*it)->GetName() == kExpireIndex) {
+      expire_ = *it;
+      handles.erase(it);
+      break;
+    }
+  }
+  if (expire_ == NULL) {
+    s = db_->CreateColumnFamily(NewCFOptions(kExpireIndex, Configs()), kExpireIndex, &expire_);
+    if (!s.ok()) return StatusToResult(s);
+  }
+
   // Init namespaces.
   std::unique_lock<std::mutex> lock(lock_);
   for (auto handle: handles) {
-    NSRef ns(new Namespace(db_, handle));
-    NDB_TRY(ns->LoadConfigs());
+    NSRef ns(new Namespace(db_, handle, meta_cache_, expire_, combiner_));
+    ns->wopts_ = wopts_;
+    // Set up durability and the value cache as PutConfigs() does.
+    const auto& nsconfigs = configs[handle->GetName()];
+    NDB_TRY(ns->ApplyConfigs(nsconfigs));
+    ns->configs_ = nsconfigs;
     namespaces_[handle->GetName()] = ns;
   }
 
   return Result::OK();
 }
 
+Result Engine::LoadConfigs(const std::vector<std::string>& nsnames,
+                           std::map<std::string, Configs>* configs) {
+  // Configs are saved in the namespaces themselves,
+  // so we open the db read-only to load them first.
+  std::vector<ColumnFamilyDescriptor> cfds;
+  for (const auto& name : nsnames) {
+    cfds.emplace_back(name, cfopts_);
+  }
+
+  DB* db = NULL;
+  std::vector<ColumnFamilyHandle*> handles;
+  auto s = DB::OpenForReadOnly(dbopts_, options_.dbname, cfds, &handles, &db);
+  if (!s.ok()) return StatusToResult(s);
+  std::unique_ptr<DB> auto_free(db);
+
+  std::vector<std::unique_ptr<Namespace>> nss;
+  for (auto handle : handles) {
+    nss.emplace_back(new Namespace(db, handle));
+  }
+  for (const auto& ns : nss) {
+    NDB_TRY(ns->ReadConfigs(&(*configs)[ns->GetName()]));
+  }
+  return Result::OK();
+}
+
+ColumnFamilyOptions Engine::NewCFOptions(const std::string& nsname,
+                                         const Configs& configs) {
+  if (nsname == kExpireIndex) {
+    // The expire index is small and only scanned in order.
+    ColumnFamilyOptions cfopts;
+    cfopts.table_factory = cfopts_.table_factory;
+    return cfopts;
+  }
+
+  auto cfopts = cfopts_;
+  auto tbopts = tbopts_;
+
+  if (configs.has_memtable_size()) {
+    cfopts.OptimizeLevelStyleCompaction(configs.memtable_size());
+  }
+
+  if (configs.has_block_size()) {
+    tbopts.block_size = configs.block_size();
+  }
+  if (configs.has_bloom_bits()) {
+    if (configs.bloom_bits() > 0) {
+      tbopts.filter_policy.reset(NewBloomFilterPolicy(configs.bloom_bits()));
+    } else {
+      tbopts.filter_policy.reset();
+    }
+  }
+  if (configs.data_block_hash_index()) {
+    tbopts.data_block_index_type = BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  }
+  if (configs.has_cache_priority()) {
+    // Index and filter blocks compete with data blocks in the block cache,
+    // high priority ones are evicted last and pinned in level 0.
+    auto high = configs.cache_priority() == pb::HIGH;
+    tbopts.cache_index_and_filter_blocks = true;
+    tbopts.cache_index_and_filter_blocks_with_high_priority = high;
+    tbopts.pin_l0_filter_and_index_blocks_in_cache = high;
+  }
+
+  if (configs.compression_size() > 0) {
+    // Set after OptimizeLevelStyleCompaction(), which resets it.
+    // The last compression applies to the rest levels.
+    cfopts.compression_per_level.clear();
+    for (auto compression : configs.compression()) {
+      cfopts.compression_per_level.push_back(
+          ToCompressionType(static_cast<Compression>(compression)));
+    }
+  }
+
+  cfopts.table_factory.reset(NewBlockBasedTableFactory(tbopts));
+  cfopts.compaction_filter_factory.reset(
+      new CompactionFilterFactory(this, nsname, compaction_cache_));
+  return cfopts;
+}
+
 std::vector<std::string> Engine::ListNamespaces() {
   std::unique_lock<std::mutex> lock(lock_);
   std::vector<std::string> names;
@@ -87,18 +231,19 @@ NSRef Engine::GetNamespace(const std::string& nsname) {
   return it->second;
 }
 
-Result Engine::NewNamespace(const std::string& nsname) {
+Result Engine::NewNamespace(const std::string& nsname, const Configs& configs) {
   std::unique_lock<std::mutex> lock(lock_);
   auto it = namespaces_.find(nsname);
-  if (it != namespaces_.end()) {
+  if (it != namespaces_.end() || nsname == kExpireIndex) {
     return Result::Error("namespace:%s has exist", nsname.c_str());
   }
   ColumnFamilyHandle* handle = NULL;
-  cfopts_.compaction_filter_factory.reset(
-      new CompactionFilterFactory(this, nsname, options_.compaction_cache_size));
-  auto s = db_->CreateColumnFamily(cfopts_, nsname, &handle);
+  auto cfopts = NewCFOptions(nsname, configs);
+  auto s = db_->CreateColumnFamily(cfopts, nsname, &handle);
   if (s.ok()) {
-    namespaces_[handle->GetName()].reset(new Namespace(db_, handle));
+    NSRef ns(new Namespace(db_, handle, meta_cache_, expire_, combiner_));
+    ns->wopts_ = wopts_;
+    namespaces_[handle->GetName()] = ns;
   }
   return StatusToResult(s);
 }
@@ -119,14 +264,21 @@ Result Engine::DropNamespace(const std::string& nsname) {
 std::vector<Result> Engine::MultiGet(const std::vector<NSRef>& namespaces,
                                      const std::vector<Slice>& ids,
                                      std::vector<Value>* values) {
+  if (values == NULL) {
+    // Existence checks only need views.
+    std::vector<PinnableSlice> pins;
+    std::vector<ValueView> views;
+    return MultiGet(namespaces, ids, &pins, &views);
+  }
+
   auto size = ids.size();
-  std::vector<std::string> vs;
   std::vector<Value> tmpvals(size);
   std::vector<Result> results(size);
-  std::vector<ColumnFamilyHandle*> handles;
-  for (auto ns : namespaces) handles.push_back(ns->handle_);
 
-  auto ss = db_->MultiGet(ropts_, handles, ids, &vs);
+  std::vector<PinnableSlice> vs;
+  std::vector<Namespace*> nss;
+  for (auto& ns : namespaces) nss.push_back(ns.get());
+  auto ss = Namespace::MultiGetValues(db_, ropts_, nss, ids, &vs);
   for (size_t i = 0; i < size; i++) {
     auto& v = tmpvals[i];
     auto& r = results[i];
@@ -136,12 +288,109 @@ std::vector<Result> Engine::MultiGet(const std::vector<NSRef>& namespaces,
     }
   }
 
-  if (values != NULL) {
-    values->swap(tmpvals);
+  values->swap(tmpvals);
+  return results;
+}
+
+std::vector<Result> Engine::MultiGet(const std::vector<NSRef>& namespaces,
+                                     const std::vector<Slice>& ids,
+                                     std::vector<PinnableSlice>* pins,
+                                     std::vector<ValueView>* views) {
+  auto size = ids.size();
+  std::vector<Result> results(size);
+
+  std::vector<Namespace*> nss;
+  for (auto& ns : namespaces) nss.push_back(ns.get());
+  auto ss = Namespace::MultiGetValues(db_, ropts_, nss, ids, pins);
+  views->assign(size, ValueView());
+  for (size_t i = 0; i < size; i++) {
+    auto& r = results[i];
+    r = StatusToResult(ss[i]);
+    if (r.ok()) {
+      r = (*views)[i].DecodeLive((*pins)[i]);
+    }
   }
   return results;
 }
 
+// Erase values written by a batch from caches of namespaces.
+class CacheEraser : public WriteBatch::Handler {
+ public:
+  CacheEraser(const std::map<uint32_t, NSRef>& namespaces)
+      : namespaces_(namespaces) {}
+
+  Status PutCF(uint32_t cfid, const Slice& key, const Slice& value) override {
+    return Erase(cfid, key);
+  }
+
+  Status DeleteCF(uint32_t cfid, const Slice& key) override {
+    return Erase(cfid, key);
+  }
+
+  Status SingleDeleteCF(uint32_t cfid, const Slice& key) override {
+    return Erase(cfid, key);
+  }
+
+  Status MergeCF(uint32_t cfid, const Slice& key, const Slice& value) override {
+    return Erase(cfid, key);
+  }
+
+  Status DeleteRangeCF(uint32_t cfid, const Slice& begin, const Slice& end) override {
+    return Status::OK();
+  }
+
+  void LogData(const Slice& blob) override {}
+
+ private:
+  Status Erase(uint32_t cfid, const Slice& id) {
+    auto it = namespaces_.find(cfid);
+    if (it == namespaces_.end()) {
+      return Status::OK();
+    }
+    std::string key;
+    auto cache = it->second->GetCache(id, &key);
+    if (cache != NULL) {
+      cache->Erase(key);
+    }
+    return Status::OK();
+  }
+
+ private:
+  const std::map<uint32_t, NSRef>& namespaces_;
+};
+
+Result Engine::Write(WriteBatch* batch) {
+  auto s = db_->Write(wopts_, batch);
+  if (!s.ok()) return StatusToResult(s);
+
+  std::map<uint32_t, NSRef> namespaces;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    for (const auto& it : namespaces_) {
+      namespaces[it.second->handle_->GetID()] = it.second;
+    }
+  }
+  CacheEraser eraser(namespaces);
+  s = batch->Iterate(&eraser);
+  return StatusToResult(s);
+}
+
+Result Engine::SkipSequences(uint64_t count) {
+  // Each delete takes a sequence. The empty key is never an expire key.
+  const uint64_t kMaxBatchCount = 10000;
+  while (count > 0) {
+    WriteBatch batch;
+    auto n = std::min(count, kMaxBatchCount);
+    for (uint64_t i = 0; i < n; i++) {
+      batch.Delete(expire_, Slice());
+    }
+    auto s = db_->Write(wopts_, &batch);
+    if (!s.ok()) return StatusToResult(s);
+    count -= n;
+  }
+  return Result::OK();
+}
+
 Stats Engine::GetStats() const {
   Stats stats;
   stats.insert("dbname", db_->GetName());
@@ -165,6 +414,42 @@ Stats Engine::GetStats() const {
   db_->GetAggregatedIntProperty("rocksdb.num-running-compactions", &value);
   stats.insert("num_running_compactions", value);
 
+  db_->GetIntProperty(expire_, "rocksdb.estimate-num-keys", &value);
+  stats.insert("expire_index_keys", value);
+
+  if (meta_cache_ != NULL) {
+    size_t entries = 0;
+    auto usage = meta_cache_->GetUsage(&entries);
+    stats.insert("meta_cache_hits", meta_cache_->hits());
+    stats.insert("meta_cache_misses", meta_cache_->misses());
+    stats.insert("meta_cache_usage", usage);
+    stats.insert("meta_cache_entries", entries);
+  }
+
+  stats.insert("compaction_cache_hits", compaction_cache_->hits());
+  stats.insert("compaction_cache_misses", compaction_cache_->misses());
+  stats.insert("compaction_memo_hits", compaction_cache_->memo_hits());
+
+  auto merge = static_cast<const MergeOperator*>(cfopts_.merge_operator.get());
+  stats.insert("merge_dropped_operands", merge->dropped());
+
+  stats.insert("write_combine_batches", combiner_->batches());
+  stats.insert("write_combine_groups", combiner_->groups());
+  stats.insert("write_combine_splits", combiner_->splits());
+  stats.insert("write_combine_histogram", combiner_->histogram());
+
+  stats.insert("sync_mode", options_.sync_mode);
+  stats.insert("wal_synced", dbopts_.statistics->getTickerCount(WAL_FILE_SYNCED));
+  stats.insert("wal_sync_rate", syncer_->sync_rate());
+  stats.insert("wal_sync_errors", syncer_->errors());
+
+  auto statistics = dbopts_.statistics;
+  stats.insert("bloom_filter_useful", statistics->getTickerCount(BLOOM_FILTER_USEFUL));
+  stats.insert("bloom_filter_prefix_checked",
+               statistics->getTickerCount(BLOOM_FILTER_PREFIX_CHECKED));
+  stats.insert("bloom_filter_prefix_useful",
+               statistics->getTickerCount(BLOOM_FILTER_PREFIX_USEFUL));
+
   return stats;
 }
 
@@ -4,9 +4,13 @@
 #include "ndb/engine/backup.h"
 #include "ndb/engine/encode.h"
 #include "ndb/engine/namespace.h"
+#include "ndb/engine/packed.h"
+#include "ndb/engine/syncer.h"
 
 namespace ndb {
 
+class CompactionMetaCache;
+
 class Engine {
  public:
   struct Options {
@@ -16,7 +20,22 @@ class Engine {
     size_t WAL_size_limit {1 << 30};
     size_t memtable_size {1 << 30};
     size_t block_cache_size {1 << 30};
+    // Metas cached by compaction filters of all namespaces.
     size_t compaction_cache_size {1 << 20};
+    // Cache of collection metas, 0 to disable.
+    size_t meta_cache_size {64 << 20};
+    // Combine writes of commands in up to the size and microseconds,
+    // 0 size to disable.
+    size_t write_combine_size {1 << 20};
+    int write_combine_usecs {0};
+    // Sync the WAL: none, always on every write, or periodic every
+    // sync_interval_msecs in the background.
+    std::string sync_mode {"none"};
+    int sync_interval_msecs {1000};
+    // Write paths of RocksDB.
+    bool pipelined_write {false};
+    bool unordered_write {false};
+    bool two_write_queues {false};
     int background_threads {4};
   };
 
@@ -30,7 +49,9 @@ class Engine {
 
   NSRef GetNamespace(const std::string& nsname);
 
-  Result NewNamespace(const std::string& nsname);
+  // Configs only tailor the column family options of the namespace,
+  // they are not saved.
+  Result NewNamespace(const std::string& nsname, const Configs& configs = Configs());
 
   Result DropNamespace(const std::string& nsname);
 
@@ -44,6 +65,25 @@ class Engine {
     std::vector<Slice> tmpids {ids.begin(), ids.end()};
     return MultiGet(namespaces, tmpids, values);
   }
+  // Get values as views decoded in place, views refer to pins.
+  std::vector<Result> MultiGet(const std::vector<NSRef>& namespaces,
+                               const std::vector<Slice>& ids,
+                               std::vector<PinnableSlice>* pins,
+                               std::vector<ValueView>* views);
+  std::vector<Result> MultiGet(const std::vector<NSRef>& namespaces,
+                               const std::vector<std::string>& ids,
+                               std::vector<PinnableSlice>* pins,
+                               std::vector<ValueView>* views) {
+    std::vector<Slice> tmpids {ids.begin(), ids.end()};
+    return MultiGet(namespaces, tmpids, pins, views);
+  }
+
+  // Write a raw batch, e.g. from replication.
+  Result Write(rocksdb::WriteBatch* batch);
+
+  // Take count sequences without writing any data, e.g. to skip sequences
+  // of a master's writes without WAL.
+  Result SkipSequences(uint64_t count);
 
   Stats GetStats() const;
 
@@ -51,6 +91,9 @@ class Engine {
 
   rocksdb::DB* GetRocksDB() { return db_; }
 
+  // Index of keys ordered by expire, see Namespace::Expire().
+  rocksdb::ColumnFamilyHandle* GetExpireIndex() { return expire_; }
+
   std::unique_ptr<WALIterator> NewWALIterator() {
     return std::unique_ptr<WALIterator>(new WALIterator(db_));
   }
@@ -58,6 +101,14 @@ class Engine {
  private:
   friend class Batch;
 
+  // Load configs of namespaces before opening them with tailored options.
+  Result LoadConfigs(const std::vector<std::string>& nsnames,
+                     std::map<std::string, Configs>* configs);
+
+  // Column family options tailored to the namespace's configs.
+  rocksdb::ColumnFamilyOptions NewCFOptions(const std::string& nsname,
+                                            const Configs& configs);
+
   Options options_;
   std::mutex lock_;
   std::string dbname_;
@@ -68,6 +119,11 @@ class Engine {
   rocksdb::BlockBasedTableOptions tbopts_;
   rocksdb::DB* db_ {NULL};
   Backup* backup_ {NULL};
+  rocksdb::ColumnFamilyHandle* expire_ {NULL};
+  WriteCombiner* combiner_ {NULL};
+  WALSyncer* syncer_ {NULL};
+  std::shared_ptr<ValueCache> meta_cache_;
+  std::shared_ptr<CompactionMetaCache> compaction_cache_;
   std::map<std::string, NSRef> namespaces_;
 };
 
@@ -76,27 +132,57 @@ class Batch {
   Batch(Engine* engine) : engine_(engine) {}
 
   void Put(NSRef ns, const Slice& id, const Value& value) {
-    batch_.Put(ns->handle_, id, value.Encode());
+    Add(ns.get());
+    auto v = value.Encode();
+    batch_.Put(ns->handle_, id, v);
+    updates_.Put(ns.get(), id, v);
+    if (value.has_expire()) {
+      ns->IndexExpire(&batch_, id, value.expire());
+    }
   }
 
   void Put(NSRef ns, const Slice& id, const Slice& value = Slice()) {
+    Add(ns.get());
     batch_.Put(ns->handle_, id, value);
+    updates_.Delete(ns.get(), id);
   }
 
   void Delete(NSRef ns, const Slice& id) {
+    Add(ns.get());
     batch_.Delete(ns->handle_, id);
+    updates_.Delete(ns.get(), id);
   }
 
+  // Written with the strictest durability of namespaces in the batch.
   Result Commit() {
-    auto s = engine_->db_->Write(engine_->wopts_, &batch_);
+    auto s = strictest_ != NULL ? strictest_->Write(&batch_)
+                                : engine_->combiner_->Write(&batch_);
+    if (s.ok()) updates_.Apply();
     return StatusToResult(s);
   }
 
   size_t GetDataSize() const { return batch_.GetDataSize(); }
 
+ private:
+  void Add(Namespace* ns) {
+    if (strictest_ == NULL || Strictness(ns) > Strictness(strictest_)) {
+      strictest_ = ns;
+    }
+  }
+
+  static int Strictness(const Namespace* ns) {
+    switch (ns->durability_.load()) {
+      case pb::NOWAL: return 0;
+      case pb::SYNC:  return 2;
+      default:        return 1;
+    }
+  }
+
  private:
   Engine* engine_ {NULL};
   rocksdb::WriteBatch batch_;
+  CacheUpdates updates_;
+  Namespace* strictest_ {NULL};
 };
 
 }  // namespace ndb
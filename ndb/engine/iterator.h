@@ -49,6 +49,14 @@ class WALIterator {
     return it_->GetBatch();
   }
 
+  // Whether WAL files since sequence are kept, i.e. batches after it are
+  // missing only if they were written without WAL.
+  bool Kept(uint64_t sequence) const {
+    rocksdb::VectorLogPtr files;
+    auto s = db_->GetSortedWalFiles(files);
+    return s.ok() && !files.empty() && files.front()->StartSequence() <= sequence;
+  }
+
  private:
   Status status_;
   rocksdb::DB* db_ {NULL};
@@ -57,11 +65,34 @@ class WALIterator {
 
 class RangeIterator {
  public:
-  // Callee take ownership of iterator.
-  RangeIterator(rocksdb::Iterator* it) : it_(it) {}
+  RangeIterator(const Slice begin,
+                const Slice end,
+                size_t offset,
+                size_t limit)
+      : begin_(begin),
+        end_(end),
+        offset_(offset),
+        limit_(limit) {}
 
   virtual ~RangeIterator() { delete it_; }
 
+  // Create the underlying iterator bounded by [begin, end].
+  void Open(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle,
+            rocksdb::ReadOptions ropts) {
+    if (begin_.size() != 0) {
+      lower_bound_ = begin_;
+      ropts.iterate_lower_bound = &lower_bound_;
+    }
+    if (end_.size() != 0) {
+      // The smallest key after end.
+      upper_.assign(end_.data(), end_.size());
+      upper_.push_back('\0');
+      upper_bound_ = upper_;
+      ropts.iterate_upper_bound = &upper_bound_;
+    }
+    it_ = db->NewIterator(ropts, handle);
+  }
+
   virtual void Seek() = 0;
 
   virtual void Next() = 0;
@@ -77,20 +108,21 @@ class RangeIterator {
  protected:
   bool valid_ = {true};
   rocksdb::Iterator* it_ {NULL};
+  Slice begin_;
+  Slice end_;
+  size_t offset_ {0};
+  size_t limit_ {0};
+  size_t count_ {0};
+
+ private:
+  std::string upper_;
+  Slice lower_bound_;
+  Slice upper_bound_;
 };
 
 class ForwardIterator : public RangeIterator {
  public:
-  ForwardIterator(rocksdb::Iterator* it,
-                  const Slice begin,
-                  const Slice end,
-                  size_t offset,
-                  size_t limit)
-      : RangeIterator(it),
-        begin_(begin),
-        end_(end),
-        offset_(offset),
-        limit_(limit) {}
+  using RangeIterator::RangeIterator;
 
   void Seek() {
     // Seek
@@ -102,7 +134,6 @@ class ForwardIterator : public RangeIterator {
     // Skip offset
     for (; it_->Valid() && offset_ != 0; it_->Next(), offset_--);
     count_ = 1;
-    CheckRange();
   }
 
   void Next() {
@@ -113,57 +144,23 @@ class ForwardIterator : public RangeIterator {
       return;
     }
     it_->Next();
-    CheckRange();
-  }
-
- private:
-  void CheckRange() {
-    if (it_->Valid()) {
-      if (end_.size() != 0 && it_->key().compare(end_) > 0) {
-        valid_ = false;
-      }
-    }
   }
-
- private:
-  Slice begin_;
-  Slice end_;
-  size_t offset_ {0};
-  size_t limit_ {0};
-  size_t count_ {0};
 };
 
 class BackwardIterator : public RangeIterator {
  public:
-  BackwardIterator(rocksdb::Iterator* it,
-                   const Slice begin,
-                   const Slice end,
-                   size_t offset,
-                   size_t limit)
-      : RangeIterator(it),
-        begin_(begin),
-        end_(end),
-        offset_(offset),
-        limit_(limit) {}
+  using RangeIterator::RangeIterator;
 
   void Seek() {
     // Seek
     if (end_.size() == 0) {
       it_->SeekToLast();
     } else {
-      it_->Seek(end_);
-      if (it_->Valid()) {
-        if (it_->key().compare(end_) > 0) {
-          it_->Prev();
-        }
-      } else {
-        it_->SeekToLast();
-      }
+      it_->SeekForPrev(end_);
     }
     // Skip offset
     for (; it_->Valid() && offset_ != 0; it_->Prev(), offset_--);
     count_ = 1;
-    CheckRange();
   }
 
   void Next() {
@@ -174,24 +171,7 @@ class BackwardIterator : public RangeIterator {
       return;
     }
     it_->Prev();
-    CheckRange();
   }
-
- private:
-  void CheckRange() {
-    if (it_->Valid()) {
-      if (begin_.size() != 0 && it_->key().compare(begin_) < 0) {
-        valid_ = false;
-      }
-    }
-  }
-
- private:
-  Slice begin_;
-  Slice end_;
-  size_t offset_ {0};
-  size_t limit_ {0};
-  size_t count_ {0};
 };
 
 }  // namespace ndb
@@ -0,0 +1,66 @@
+#include "ndb/engine/merge.h"
+
+namespace ndb {
+
+static bool AddInt64(int64_t* origin, int64_t increment) {
+  if ((*origin < 0 && increment < 0 && increment < (INT64_MIN - *origin)) ||
+      (*origin > 0 && increment > 0 && increment > (INT64_MAX - *origin))) {
+    return false;
+  }
+  *origin += increment;
+  return true;
+}
+
+static bool ValueToInt64(const Value& value, int64_t* int64) {
+  if (value.has_int64()) {
+    *int64 = value.int64();
+    return true;
+  }
+  if (!value.has_bytes()) {
+    return false;
+  }
+  const auto& bytes = value.bytes();
+  if (bytes.empty() || isspace(bytes[0])) {
+    return false;
+  }
+  errno = 0;
+  char* end = NULL;
+  *int64 = strtoll(bytes.c_str(), &end, 10);
+  return errno == 0 && *end == '\0';
+}
+
+bool MergeOperator::FullMergeV2(const MergeOperationInput& merge_in,
+                                MergeOperationOutput* merge_out) const {
+  Value value;
+  int64_t origin = 0;
+  if (merge_in.existing_value != NULL) {
+    auto r = value.Decode(*merge_in.existing_value);
+    if (r.IsNotFound()) {
+      // Deleted or expired values start from 0.
+      value.Clear();
+    } else if (!r.ok() || !ValueToInt64(value, &origin)) {
+      dropped_.fetch_add(merge_in.operand_list.size(), std::memory_order_relaxed);
+      merge_out->existing_operand = *merge_in.existing_value;
+      return true;
+    }
+  }
+
+  for (const auto& operand : merge_in.operand_list) {
+    ValueView view;
+    if (!view.Decode(operand).ok() || !view.has_int64() ||
+        !AddInt64(&origin, view.int64())) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    // Keep the existing expire like Value::SetConfigs().
+    if (!value.has_expire() && view.has_expire()) {
+      value.set_expire(view.expire());
+    }
+  }
+
+  value.set_int64(origin);
+  merge_out->new_value = value.Encode();
+  return true;
+}
+
+}  // namespace ndb
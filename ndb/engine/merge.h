@@ -0,0 +1,30 @@
+#ifndef NDB_ENGINE_MERGE_H_
+#define NDB_ENGINE_MERGE_H_
+
+#include "ndb/engine/value.h"
+
+namespace ndb {
+
+// Merge int64 increments into values, so counters are updated by blind merges.
+// Operands are encoded values of increments with optional expires.
+// Operands are dropped if the existing value is not an integer or the sum
+// overflows, the same as increments rejected by INCRBY. Operands are not
+// merged partially, since whether one overflows depends on the value before.
+class MergeOperator : public rocksdb::MergeOperator {
+ public:
+  const char* Name() const override { return "ndb.MergeOperator"; }
+
+  bool FullMergeV2(const MergeOperationInput& merge_in,
+                   MergeOperationOutput* merge_out) const override;
+
+  // Operands dropped, counted each time they are merged by reads,
+  // flushes or compactions.
+  uint64_t dropped() const { return dropped_; }
+
+ private:
+  mutable std::atomic<uint64_t> dropped_ {0};
+};
+
+}  // namespace ndb
+
+#endif /* NDB_ENGINE_MERGE_H_ */
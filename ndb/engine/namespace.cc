@@ -10,46 +10,334 @@ Result Namespace::PutConfigs(const Configs& configs) {
     return ProtobufError();
   }
   auto s = db_->Put(wopts_, handle_, "namespace.__configs__", v);
-  if (s.ok()) {
-    configs_ = configs;
-  }
-  return StatusToResult(s);
+  if (!s.ok()) return StatusToResult(s);
+  NDB_TRY(ApplyConfigs(configs));
+  configs_ = configs;
+  return Result::OK();
 }
 
 Result Namespace::LoadConfigs() {
+  Configs configs;
+  NDB_TRY(ReadConfigs(&configs));
+  NDB_TRY(ApplyConfigs(configs));
+  configs_ = configs;
+  return Result::OK();
+}
+
+Result Namespace::ReadConfigs(Configs* configs) const {
   std::string v;
   auto s = db_->Get(ropts_, handle_, "namespace.__configs__", &v);
   if (s.IsNotFound()) {
     return Result::OK();
   }
   if (s.ok()) {
-    if (!configs_.ParseFromString(v)) {
+    if (!configs->ParseFromString(v)) {
       return ProtobufError();
     }
   }
   return StatusToResult(s);
 }
 
+Result Namespace::ApplyConfigs(const Configs& configs) {
+  durability_ = configs.has_durability() ? configs.durability() : pb::NORMAL;
+
+  if (configs.value_cache_size() != configs_.value_cache_size()) {
+    std::shared_ptr<ValueCache> cache;
+    if (configs.value_cache_size() > 0) {
+      cache.reset(new ValueCache(configs.value_cache_size()));
+    }
+    std::atomic_store(&value_cache_, cache);
+  }
+
+  // Other column family options are applied when the namespace is opened.
+  if (!configs.has_memtable_size() ||
+      configs.memtable_size() == configs_.memtable_size()) {
+    return Result::OK();
+  }
+  // Keep consistent with OptimizeLevelStyleCompaction().
+  auto size = configs.memtable_size();
+  std::unordered_map<std::string, std::string> options {
+    {"write_buffer_size", std::to_string(size / 4)},
+    {"target_file_size_base", std::to_string(size / 8)},
+    {"max_bytes_for_level_base", std::to_string(size)},
+  };
+  auto s = db_->SetOptions(handle_, options);
+  return StatusToResult(s);
+}
+
 Result Namespace::Put(const Slice& id, const Value& value) {
-  auto s = db_->Put(wopts_, handle_, id, value.Encode());
+  CacheUpdates updates;
+  auto v = value.Encode();
+  updates.Put(this, id, v);
+  WriteBatch batch;
+  batch.Put(handle_, id, v);
+  if (value.has_expire()) {
+    IndexExpire(&batch, id, value.expire());
+  }
+  auto s = Write(&batch);
+  if (s.ok()) updates.Apply();
   return StatusToResult(s);
 }
 
 Result Namespace::Delete(const Slice& id) {
-  auto s = db_->Delete(wopts_, handle_, id);
+  CacheUpdates updates;
+  updates.Delete(this, id);
+  WriteBatch batch;
+  batch.Delete(handle_, id);
+  auto s = Write(&batch);
+  if (s.ok()) updates.Apply();
   return StatusToResult(s);
 }
 
-Result Namespace::Get(const Slice& id, Value* value) {
+Result Namespace::Merge(const Slice& id, const Value& value) {
+  CacheUpdates updates;
+  updates.Delete(this, id);
+  WriteBatch batch;
+  Value operand = value;
+  std::string indexed;
+  if (value.has_expire()) {
+    // Index keys are kept until their expires pass, so an expire already
+    // indexed by a recent merge of id is not indexed again.
+    auto expire = (value.expire() + kMergeExpireUnit - 1) / kMergeExpireUnit * kMergeExpireUnit;
+    operand.set_expire(expire);
+    indexed.assign(reinterpret_cast<const char*>(&expire), sizeof(expire));
+    std::string cached;
+    bool found = false;
+    uint64_t generation = 0;
+    if (merge_expires_.Lookup(id, &cached, &found, &generation) && cached == indexed) {
+      indexed.clear();
+    } else {
+      IndexExpire(&batch, id, expire);
+    }
+  }
+  batch.Merge(handle_, id, operand.Encode());
+  auto s = Write(&batch);
+  if (s.ok()) {
+    updates.Apply();
+    if (!indexed.empty()) merge_expires_.Update(id, indexed);
+  }
+  return StatusToResult(s);
+}
+
+Status Namespace::Write(WriteBatch* batch) {
+  // Only batches of the engine's durability are combined.
+  if (combiner_ != NULL && durability_ == pb::NORMAL) {
+    return combiner_->Write(batch);
+  }
+  return db_->Write(GetWriteOptions(), batch);
+}
+
+WriteOptions Namespace::GetWriteOptions() const {
+  auto wopts = wopts_;
+  switch (durability_.load()) {
+    case pb::SYNC:
+      wopts.sync = true;
+      break;
+    case pb::NOWAL:
+      wopts.sync = false;
+      wopts.disableWAL = true;
+      break;
+  }
+  return wopts;
+}
+
+Result Namespace::Expire(const Slice& id, uint64_t* version, uint64_t* cid) {
   std::string v;
   auto s = db_->Get(ropts_, handle_, id, &v);
+  if (!s.ok()) return StatusToResult(s);
+
+  ValueView view;
+  NDB_TRY(view.Decode(v));
+  // Deleted metas are left to the compaction filter.
+  if (!view.has_expire() || view.expire() >= getmstime() ||
+      (view.has_meta() && view.meta_deleted())) {
+    return Result::NotFound();
+  }
+
+  CacheUpdates updates;
+  if (view.has_meta()) {
+    // Keep the version and cid, so members of the old collection are filtered.
+    *version = view.meta_version();
+    *cid = view.meta_cid();
+    Value value;
+    auto meta = value.mutable_meta();
+    meta->set_type(view.meta_type());
+    meta->set_version(view.meta_version());
+    if (*cid != 0) meta->set_cid(*cid);
+    meta->set_deleted(true);
+    v = value.Encode();
+    updates.Put(this, id, v);
+    s = db_->Put(GetWriteOptions(), handle_, id, v);
+  } else {
+    updates.Delete(this, id);
+    s = db_->Delete(GetWriteOptions(), handle_, id);
+  }
+  if (!s.ok()) return StatusToResult(s);
+  updates.Apply();
+  expired_keys_++;
+  return Result::OK();
+}
+
+Result Namespace::DeleteVersion(const Slice& kmeta, uint64_t version, uint64_t cid) {
+  Status s;
+  if (cid != 0) {
+    // Cids are dense, the next cid bounds all members of the cid.
+    s = db_->DeleteRange(GetWriteOptions(), handle_,
+                         EncodeCollectionKey(cid), EncodeCollectionKey(cid + 1));
+    return StatusToResult(s);
+  }
+
+  std::string v;
+  s = db_->Get(ropts_, handle_, kmeta, &v);
+  if (!s.ok() && !s.IsNotFound()) return StatusToResult(s);
+
+  ValueView view;
+  if (s.ok()) NDB_TRY(view.Decode(v));
+  bool dropped = s.IsNotFound() || view.IsDeleted();
+  if (!dropped && view.meta_version() <= version) {
+    return Result::OK();
+  }
+  std::string begin, end;
+  if (dropped && kmeta.size() > 1) {
+    // All keys with kmeta as a prefix except the meta itself. Not for the
+    // empty id, whose keys share the leading '\0' with collection keys.
+    begin = kmeta.ToString() + '\0';
+    end = kmeta.ToString();
+    end.back() = '\1';
+  } else {
+    // Varints are prefix free, keys with the prefix are of the version.
+    begin = kmeta.ToString();
+    EncodeVarint64(&begin, version);
+    end = begin;
+    end.back()++;
+  }
+  s = db_->DeleteRange(GetWriteOptions(), handle_, begin, end);
+  return StatusToResult(s);
+}
+
+Result Namespace::NewCollectionID(uint64_t* cid) {
+  std::unique_lock<std::mutex> lock(cid_lock_);
+  if (next_cid_ >= cid_ceiling_) {
+    // Reserve a block after the persisted ceiling, which may have been
+    // raised by others, e.g. the master before this replica is promoted.
+    // The collection key of cid 0, which is never allocated, holds it.
+    auto key = EncodeCollectionKey(0);
+    Value value;
+    auto r = Get(key, &value);
+    if (!r.ok() && !r.IsNotFound()) return r;
+    uint64_t next = std::max<uint64_t>(next_cid_, 1);
+    if (r.ok() && value.has_int64()) {
+      next = std::max<uint64_t>(next, value.int64());
+    }
+    if (next + kCollectionIDBlock > kMaxCollectionID) {
+      return Result::Error("Collection ids are exhausted.");
+    }
+    // The ceiling goes through the WAL whatever the durability is,
+    // so cids are never reused after crashes.
+    auto s = db_->Put(wopts_, handle_, key,
+                      Value::FromInt64(next + kCollectionIDBlock).Encode());
+    if (!s.ok()) return StatusToResult(s);
+    next_cid_ = next;
+    cid_ceiling_ = next + kCollectionIDBlock;
+  }
+  *cid = next_cid_++;
+  return Result::OK();
+}
+
+void Namespace::IndexExpire(WriteBatch* batch, const Slice& id, uint64_t expire) {
+  if (expire_ != NULL) {
+    batch->Put(expire_, EncodeExpireKey(expire, handle_->GetName(), id), Slice());
+  }
+}
+
+Status Namespace::GetValue(const Slice& id, PinnableSlice* value) {
+  Status s;
+  CacheFill fill;
+  if (LookupCache(id, value, &s, &fill)) {
+    return s;
+  }
+  s = db_->Get(ropts_, handle_, id, value);
+  fill.Insert(s, *value);
+  return s;
+}
+
+bool Namespace::LookupCache(const Slice& id, PinnableSlice* value, Status* s, CacheFill* fill) const {
+  fill->cache = GetCache(id, &fill->key);
+  if (fill->cache == NULL) {
+    return false;
+  }
+  bool found = false;
+  if (!fill->cache->Lookup(fill->key, value->GetSelf(), &found, &fill->generation)) {
+    return false;
+  }
+  value->PinSelf();
+  *s = found ? Status::OK() : Status::NotFound();
+  fill->cache.reset();
+  return true;
+}
+
+std::shared_ptr<ValueCache> Namespace::GetCache(const Slice& id, std::string* key) const {
+  std::shared_ptr<ValueCache> cache;
+  if (IsSimpleKey(id)) {
+    cache = std::atomic_load(&value_cache_);
+  } else if (IsMetaKey(id)) {
+    cache = meta_cache_;
+  }
+  if (cache != NULL) {
+    *key = ValueCache::Key(handle_->GetID(), id);
+  }
+  return cache;
+}
+
+std::vector<Status> Namespace::MultiGetValues(DB* db, const ReadOptions& ropts,
+                                              const std::vector<Namespace*>& namespaces,
+                                              const std::vector<Slice>& ids,
+                                              std::vector<PinnableSlice>* values) {
+  auto size = ids.size();
+  std::vector<Status> ss(size);
+  std::vector<PinnableSlice> vs(size);
+  std::vector<CacheFill> fills(size);
+  std::vector<size_t> misses;
+  std::vector<Slice> missids;
+  std::vector<ColumnFamilyHandle*> handles;
+  for (size_t i = 0; i < size; i++) {
+    auto ns = namespaces[i];
+    if (!ns->LookupCache(ids[i], &vs[i], &ss[i], &fills[i])) {
+      misses.push_back(i);
+      missids.push_back(ids[i]);
+      handles.push_back(ns->handle_);
+    }
+  }
+
+  if (!misses.empty()) {
+    // Batched lookups probe blooms and indexes of keys in the same
+    // files together, and pin values instead of copying them.
+    auto n = misses.size();
+    std::vector<PinnableSlice> missvs(n);
+    std::vector<Status> missss(n);
+    db->MultiGet(ropts, n, handles.data(), missids.data(), missvs.data(), missss.data());
+    for (size_t i = 0; i < n; i++) {
+      auto m = misses[i];
+      ss[m] = missss[i];
+      vs[m] = std::move(missvs[i]);
+      fills[m].Insert(ss[m], vs[m]);
+    }
+  }
+
+  values->swap(vs);
+  return ss;
+}
+
+Result Namespace::Get(const Slice& id, Value* value) {
+  PinnableSlice v;
+  auto s = GetValue(id, &v);
   if (s.ok()) {
     if (value != NULL) {
       return value->Decode(v);
     } else {
       // We need to decode the value to know if it is expired or deleted.
-      Value tmp;
-      return tmp.Decode(v);
+      ValueView view;
+      return view.DecodeLive(v);
     }
   }
   return StatusToResult(s);
@@ -58,18 +346,22 @@ Result Namespace::Get(const Slice& id, Value* value) {
 std::vector<Result> Namespace::MultiGet(const std::vector<Slice>& ids,
                                         std::vector<Value>* values) {
   auto size = ids.size();
-  std::vector<std::string> vs;
-  std::vector<Value> tmpvals(size);
+  std::vector<PinnableSlice> vs;
+  std::vector<Value> tmpvals(values != NULL ? size : 0);
   std::vector<Result> results(size);
-  std::vector<ColumnFamilyHandle*> handles(size, handle_);
+  std::vector<Namespace*> namespaces(size, this);
 
-  auto ss = db_->MultiGet(ropts_, handles, ids, &vs);
+  auto ss = MultiGetValues(db_, ropts_, namespaces, ids, &vs);
   for (size_t i = 0; i < size; i++) {
-    auto& v = tmpvals[i];
     auto& r = results[i];
     r = StatusToResult(ss[i]);
-    if (r.ok()) {
-      r = v.Decode(vs[i]);
+    if (!r.ok()) continue;
+    if (values != NULL) {
+      r = tmpvals[i].Decode(vs[i]);
+    } else {
+      // Existence checks only need views.
+      ValueView view;
+      r = view.DecodeLive(vs[i]);
     }
   }
 
@@ -79,21 +371,52 @@ std::vector<Result> Namespace::MultiGet(const std::vector<Slice>& ids,
   return results;
 }
 
+std::vector<Result> Namespace::MultiGet(const std::vector<Slice>& ids,
+                                        std::vector<PinnableSlice>* pins,
+                                        std::vector<ValueView>* views) {
+  auto size = ids.size();
+  std::vector<Result> results(size);
+  std::vector<Namespace*> namespaces(size, this);
+
+  auto ss = MultiGetValues(db_, ropts_, namespaces, ids, pins);
+  views->assign(size, ValueView());
+  for (size_t i = 0; i < size; i++) {
+    auto& r = results[i];
+    r = StatusToResult(ss[i]);
+    if (r.ok()) {
+      r = (*views)[i].DecodeLive((*pins)[i]);
+    }
+  }
+  return results;
+}
+
 std::unique_ptr<RangeIterator> Namespace::RangeGet(const Slice& begin,
                                                    const Slice& end,
                                                    size_t offset,
                                                    size_t count,
                                                    bool reverse) {
   std::unique_ptr<RangeIterator> it;
-  auto dbit = db_->NewIterator(ropts_, handle_);
   if (!reverse) {
-    it.reset(new ForwardIterator(dbit, begin, end, offset, count));
+    it.reset(new ForwardIterator(begin, end, offset, count));
   } else {
-    it.reset(new BackwardIterator(dbit, begin, end, offset, count));
+    it.reset(new BackwardIterator(begin, end, offset, count));
   }
+
+  // Seek by prefix only if the range is in one collection,
+  // otherwise the iterator may skip keys with other prefixes.
+  auto ropts = ropts_;
+  Slice prefix;
+  ropts.total_order_seek = !(ExtractPrefix(begin, &prefix) && end.starts_with(prefix));
+  it->Open(db_, handle_, ropts);
   return it;
 }
 
+std::unique_ptr<rocksdb::Iterator> Namespace::NewIterator() {
+  auto ropts = ropts_;
+  ropts.total_order_seek = true;
+  return std::unique_ptr<rocksdb::Iterator>(db_->NewIterator(ropts, handle_));
+}
+
 Result Namespace::CompactRange(const Slice& begin, const Slice& end) {
   auto btmp = begin.size() == 0 ? NULL : &begin;
   auto etmp = end.size() == 0 ? NULL : &end;
@@ -101,6 +424,46 @@ Result Namespace::CompactRange(const Slice& begin, const Slice& end) {
   return StatusToResult(s);
 }
 
+void CacheUpdates::Put(Namespace* ns, const Slice& id, const Slice& value) {
+  // Metas are written through, simple values are invalidated, so only hot
+  // ones are cached.
+  Add(ns, id, value, !IsMetaKey(id));
+}
+
+void CacheUpdates::Delete(Namespace* ns, const Slice& id) {
+  Add(ns, id, Slice(), true);
+}
+
+void CacheUpdates::Add(Namespace* ns, const Slice& id, const Slice& value, bool deleted) {
+  if (!IsSimpleKey(id) && !IsMetaKey(id)) return;
+  std::string key;
+  auto cache = ns->GetCache(id, &key);
+  updates_.push_back({ns, id.ToString(), cache,
+                      deleted ? std::string() : value.ToString(), deleted});
+}
+
+void CacheUpdates::Apply(ValueCache* cache, const Update& update) {
+  if (cache == NULL) return;
+  auto key = ValueCache::Key(update.ns->handle_->GetID(), update.id);
+  if (update.deleted) {
+    cache->Erase(key);
+  } else {
+    cache->Update(key, update.value);
+  }
+}
+
+void CacheUpdates::Apply() {
+  for (const auto& update : updates_) {
+    // The value cache may be replaced during the write, and readers of the
+    // new one may have missed before the write, so update both.
+    std::string key;
+    auto cache = update.ns->GetCache(update.id, &key);
+    Apply(update.cache.get(), update);
+    if (cache != update.cache) Apply(cache.get(), update);
+  }
+  updates_.clear();
+}
+
 Stats Namespace::GetStats() const {
   Stats stats;
 
@@ -129,6 +492,19 @@ Stats Namespace::GetStats() const {
   db_->GetIntProperty(handle_, "rocksdb.num-running-compactions", &value);
   stats.insert("num_running_compactions", value);
 
+  stats.insert("expired_keys", expired_keys_.load());
+  stats.insert("durability", DurabilityName(static_cast<Durability>(durability_.load())));
+
+  auto cache = std::atomic_load(&value_cache_);
+  if (cache != NULL) {
+    size_t entries = 0;
+    auto usage = cache->GetUsage(&entries);
+    stats.insert("value_cache_hits", cache->hits());
+    stats.insert("value_cache_misses", cache->misses());
+    stats.insert("value_cache_usage", usage);
+    stats.insert("value_cache_entries", entries);
+  }
+
   return stats;
 }
 
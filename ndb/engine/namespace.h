@@ -1,7 +1,10 @@
 #ifndef NDB_ENGINE_NAMESPACE_H_
 #define NDB_ENGINE_NAMESPACE_H_
 
+#include "ndb/engine/cache.h"
+#include "ndb/engine/combiner.h"
 #include "ndb/engine/common.h"
+#include "ndb/engine/encode.h"
 #include "ndb/engine/iterator.h"
 #include "ndb/engine/value.h"
 
@@ -10,13 +13,22 @@ namespace ndb {
 class Namespace {
  public:
   // Callee take ownership of handle.
-  Namespace(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle)
-      : db_(db), handle_(handle) {}
+  // Metas are cached in meta_cache if it is not NULL.
+  // Keys with expires are indexed in expire if it is not NULL.
+  // Writes are combined with others by combiner if it is not NULL.
+  Namespace(rocksdb::DB* db, rocksdb::ColumnFamilyHandle* handle,
+            std::shared_ptr<ValueCache> meta_cache = NULL,
+            rocksdb::ColumnFamilyHandle* expire = NULL,
+            WriteCombiner* combiner = NULL)
+      : db_(db), handle_(handle), meta_cache_(meta_cache),
+        expire_(expire), combiner_(combiner) {}
 
   ~Namespace() { delete handle_; }
 
   const std::string GetName() const { return handle_->GetName(); }
 
+  uint32_t GetID() const { return handle_->GetID(); }
+
   const Configs& GetConfigs() const { return configs_; }
 
   Result PutConfigs(const Configs& configs);
@@ -27,8 +39,30 @@ class Namespace {
 
   Result Delete(const Slice& id);
 
+  // Merge an increment in value, see MergeOperator. Only the expire of
+  // the merge creating the value is kept, so merges of an id index their
+  // expires rounded up to kMergeExpireUnit milliseconds, once per unit.
+  Result Merge(const Slice& id, const Value& value);
+  static const uint64_t kMergeExpireUnit = 1000;
+
   Result Get(const Slice& id, Value* value);
 
+  // Remove id if it has expired, called by the expirer with id locked.
+  // Collection metas are marked deleted like DEL, version and cid are set
+  // to those of the expired collection.
+  // Return NotFound if id does not exist or has not expired.
+  Result Expire(const Slice& id, uint64_t* version, uint64_t* cid);
+
+  // Delete members of a dropped collection version with range deletions,
+  // called with the collection locked. Members of all versions are deleted
+  // if the collection has not been created again. Members of a collection
+  // with a cid are deleted by the cid, which is never reused.
+  Result DeleteVersion(const Slice& kmeta, uint64_t version, uint64_t cid);
+
+  // Allocate a cid for a new collection, ids are reserved in blocks and
+  // never reused, even after restarts.
+  Result NewCollectionID(uint64_t* cid);
+
   std::vector<Result> MultiGet(const std::vector<Slice>& ids,
                                std::vector<Value>* values);
   std::vector<Result> MultiGet(const std::vector<std::string>& ids,
@@ -36,16 +70,79 @@ class Namespace {
     return MultiGet(std::vector<Slice>{ids.begin(), ids.end()}, values);
   }
 
+  // Get values as views decoded in place, views refer to pins.
+  std::vector<Result> MultiGet(const std::vector<Slice>& ids,
+                               std::vector<PinnableSlice>* pins,
+                               std::vector<ValueView>* views);
+  std::vector<Result> MultiGet(const std::vector<std::string>& ids,
+                               std::vector<PinnableSlice>* pins,
+                               std::vector<ValueView>* views) {
+    return MultiGet(std::vector<Slice>{ids.begin(), ids.end()}, pins, views);
+  }
+
   std::unique_ptr<RangeIterator> RangeGet(const Slice& begin = Slice(),
                                           const Slice& end = Slice(),
                                           size_t offset = 0,
                                           size_t limit = 0,
                                           bool reverse = false);
 
+  // Unbounded iterator in total order, which can seek anywhere.
+  std::unique_ptr<rocksdb::Iterator> NewIterator();
+
   Result CompactRange(const Slice& begin = Slice(), const Slice& end = Slice());
 
   Stats GetStats() const;
 
+ private:
+  friend class CacheUpdates;
+  friend class CacheEraser;
+
+  Result ReadConfigs(Configs* configs) const;
+
+  // Write batches of commands through the combiner.
+  Status Write(rocksdb::WriteBatch* batch);
+
+  rocksdb::WriteOptions GetWriteOptions() const;
+
+  Status GetValue(const Slice& id, PinnableSlice* value);
+
+  // Fill a cache with the value got from db after a miss.
+  struct CacheFill {
+    std::shared_ptr<ValueCache> cache;
+    std::string key;
+    uint64_t generation {0};
+
+    void Insert(const Status& s, const Slice& value) {
+      if (cache != NULL && (s.ok() || s.IsNotFound())) {
+        cache->Insert(key, s.ok() ? value : Slice(), s.ok(), generation);
+      }
+    }
+  };
+
+  // Return true if hit, otherwise fill is set to insert the value.
+  bool LookupCache(const Slice& id, PinnableSlice* value, Status* s, CacheFill* fill) const;
+
+  // Get values of ids in namespaces, only ids missed in caches are got from
+  // db in one batch. Values are pinned in the block cache or memtables.
+  static std::vector<Status> MultiGetValues(rocksdb::DB* db,
+                                            const rocksdb::ReadOptions& ropts,
+                                            const std::vector<Namespace*>& namespaces,
+                                            const std::vector<Slice>& ids,
+                                            std::vector<PinnableSlice>* values);
+
+  // Cache of id and its key in the cache, or NULL if id is not cached.
+  // Metas are in the meta cache, simple values are in the value cache.
+  std::shared_ptr<ValueCache> GetCache(const Slice& id, std::string* key) const;
+
+  // Apply configs which take effect without reopening the namespace.
+  Result ApplyConfigs(const Configs& configs);
+
+  // Index id in the expire index in batch.
+  void IndexExpire(rocksdb::WriteBatch* batch, const Slice& id, uint64_t expire);
+
+  // Cids reserved at a time.
+  static const uint64_t kCollectionIDBlock = 1 << 16;
+
  private:
   friend class Engine;
   friend class Batch;
@@ -53,31 +150,89 @@ class Namespace {
 
   Configs configs_;
   rocksdb::ReadOptions ropts_;
+  // Write options of the engine, tailored by durability of configs.
   rocksdb::WriteOptions wopts_;
+  std::atomic<int> durability_ {pb::NORMAL};
   rocksdb::DB* db_ {NULL};
   rocksdb::ColumnFamilyHandle* handle_ {NULL};
+  std::shared_ptr<ValueCache> meta_cache_;
+  // Replaced when configs change, use std::atomic_load().
+  std::shared_ptr<ValueCache> value_cache_;
+  rocksdb::ColumnFamilyHandle* expire_ {NULL};
+  WriteCombiner* combiner_ {NULL};
+  std::atomic<uint64_t> expired_keys_ {0};
+  // Expires indexed by recent merges of ids.
+  ValueCache merge_expires_ {1 << 20};
+  // Cids in [next_cid_, cid_ceiling_) are reserved.
+  std::mutex cid_lock_;
+  uint64_t next_cid_ {0};
+  uint64_t cid_ceiling_ {0};
 };
 
 typedef std::shared_ptr<Namespace> NSRef;
 
+// Values written in a batch, they are applied to caches after commit.
+class CacheUpdates {
+ public:
+  void Put(Namespace* ns, const Slice& id, const Slice& value);
+
+  void Delete(Namespace* ns, const Slice& id);
+
+  void Apply();
+
+ private:
+  void Add(Namespace* ns, const Slice& id, const Slice& value, bool deleted);
+
+  struct Update {
+    Namespace* ns;
+    std::string id;
+    // Cache when the update was added, or NULL.
+    std::shared_ptr<ValueCache> cache;
+    std::string value;
+    bool deleted;
+  };
+
+  static void Apply(ValueCache* cache, const Update& update);
+
+  std::vector<Update> updates_;
+};
+
 class NSBatch {
  public:
   NSBatch(NSRef ns) : ns_(ns) {}
 
   void Put(const Slice& id, const Value& value) {
-    batch_.Put(ns_->handle_, id, value.Encode());
+    auto v = value.Encode();
+    batch_.Put(ns_->handle_, id, v);
+    updates_.Put(ns_.get(), id, v);
+    if (value.has_expire()) {
+      ns_->IndexExpire(&batch_, id, value.expire());
+    }
   }
 
   void Put(const Slice& id, const Slice& value = Slice()) {
     batch_.Put(ns_->handle_, id, value);
+    updates_.Delete(ns_.get(), id);
   }
 
   void Delete(const Slice& id) {
     batch_.Delete(ns_->handle_, id);
+    updates_.Delete(ns_.get(), id);
+  }
+
+  // Allocate a cid for a new collection of kmeta. Its collection key is
+  // written in the batch, so it is committed with the meta.
+  Result NewCollection(const Slice& kmeta, Meta* meta) {
+    uint64_t cid = 0;
+    NDB_TRY(ns_->NewCollectionID(&cid));
+    meta->set_cid(cid);
+    Put(EncodeCollectionKey(cid), Value::FromBytes(kmeta));
+    return Result::OK();
   }
 
   Result Commit() {
-    auto s = ns_->db_->Write(ns_->wopts_, &batch_);
+    auto s = ns_->Write(&batch_);
+    if (s.ok()) updates_.Apply();
     return StatusToResult(s);
   }
 
@@ -86,6 +241,7 @@ class NSBatch {
  private:
   NSRef ns_;
   rocksdb::WriteBatch batch_;
+  CacheUpdates updates_;
 };
 
 }  // namespace ndb
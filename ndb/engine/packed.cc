@@ -0,0 +1,105 @@
+#include "ndb/engine/packed.h"
+#include "ndb/engine/encode.h"
+
+namespace ndb {
+
+inline Result PackedError() {
+  return Result::Error("Invalid packed members.");
+}
+
+static bool DecodeBytes(Slice* in, Slice* bytes) {
+  uint64_t size = 0;
+  if (!DecodeVarint64(in, &size) || in->size() < size) {
+    return false;
+  }
+  *bytes = Slice(in->data(), size);
+  in->remove_prefix(size);
+  return true;
+}
+
+static void EncodeBytes(std::string* s, const Slice& bytes) {
+  EncodeVarint64(s, bytes.size());
+  s->append(bytes.data(), bytes.size());
+}
+
+bool PackedMembers::Next(Slice* in, Slice* field, Slice* value) {
+  return DecodeBytes(in, field) && DecodeBytes(in, value);
+}
+
+Result PackedMembers::Find(const Slice& s, const Slice& field, Slice* value) {
+  Slice in = s, f, v;
+  while (in.size() > 0) {
+    if (!Next(&in, &f, &v)) {
+      return PackedError();
+    }
+    int c = f.compare(field);
+    if (c == 0) {
+      *value = v;
+      return Result::OK();
+    }
+    if (c > 0) {
+      // Fields are sorted.
+      break;
+    }
+  }
+  return Result::NotFound();
+}
+
+Result PackedMembers::Decode(const Slice& s) {
+  members_.clear();
+  Slice in = s, field, value;
+  while (in.size() > 0) {
+    if (!Next(&in, &field, &value)) {
+      return PackedError();
+    }
+    // Members are sorted, so each one is appended at the end.
+    members_.emplace_hint(members_.end(), field.ToString(), value.ToString());
+  }
+  return Result::OK();
+}
+
+std::string PackedMembers::Encode() const {
+  size_t size = 0;
+  for (const auto& it : members_) {
+    size += 2 * 5 + it.first.size() + it.second.size();
+  }
+  std::string s;
+  s.reserve(size);
+  for (const auto& it : members_) {
+    EncodeBytes(&s, it.first);
+    EncodeBytes(&s, it.second);
+  }
+  return s;
+}
+
+const std::string* PackedMembers::Get(const Slice& field) const {
+  auto it = members_.find(field.ToString());
+  if (it == members_.end()) {
+    return NULL;
+  }
+  return &it->second;
+}
+
+bool PackedMembers::Put(const Slice& field, const Slice& value) {
+  auto it = members_.insert({field.ToString(), std::string()});
+  it.first->second.assign(value.data(), value.size());
+  return it.second;
+}
+
+bool PackedMembers::Delete(const Slice& field) {
+  return members_.erase(field.ToString()) > 0;
+}
+
+bool PackedMembers::Fits(size_t max_entries, size_t max_size) const {
+  if (members_.size() > max_entries) {
+    return false;
+  }
+  for (const auto& it : members_) {
+    if (it.first.size() > max_size || it.second.size() > max_size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace ndb
@@ -0,0 +1,51 @@
+#ifndef NDB_ENGINE_PACKED_H_
+#define NDB_ENGINE_PACKED_H_
+
+#include "ndb/engine/common.h"
+
+namespace ndb {
+
+// Members of a small hash, set or zset packed in its meta value, like the
+// ziplist of Redis, so the whole collection is read or written as one key.
+// Members are encoded in the order of fields as:
+//   [varint field size] field [varint value size] value
+// Values are encoded the same as values of member keys, so members are
+// moved to member keys as they are once the collection grows too large.
+class PackedMembers {
+ public:
+  // Decode members encoded by Encode().
+  Result Decode(const Slice& s);
+
+  std::string Encode() const;
+
+  // Decode the next member of encoded members in place.
+  // Return false if in is corrupted, members end when in is empty.
+  static bool Next(Slice* in, Slice* field, Slice* value);
+
+  // Find field in encoded members in place, return NotFound if not found.
+  static Result Find(const Slice& s, const Slice& field, Slice* value);
+
+  size_t size() const { return members_.size(); }
+
+  // Return NULL if field does not exist.
+  const std::string* Get(const Slice& field) const;
+
+  // Return true if field is added, false if it is updated.
+  bool Put(const Slice& field, const Slice& value);
+
+  // Return true if field is deleted.
+  bool Delete(const Slice& field);
+
+  // Whether there are at most max_entries members and
+  // fields and values are at most max_size bytes.
+  bool Fits(size_t max_entries, size_t max_size) const;
+
+  const std::map<std::string, std::string>& members() const { return members_; }
+
+ private:
+  std::map<std::string, std::string> members_;
+};
+
+}  // namespace ndb
+
+#endif /* NDB_ENGINE_PACKED_H_ */
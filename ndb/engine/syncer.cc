@@ -0,0 +1,48 @@
+#include "ndb/engine/syncer.h"
+
+namespace ndb {
+
+WALSyncer::WALSyncer(rocksdb::DB* db, std::shared_ptr<rocksdb::Statistics> statistics,
+                     int interval_msecs)
+    : db_(db), statistics_(statistics), interval_msecs_(interval_msecs) {
+  thread_ = std::thread([this] { Run(); });
+}
+
+WALSyncer::~WALSyncer() {
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+  thread_.join();
+}
+
+void WALSyncer::Run() {
+  auto interval = std::chrono::milliseconds(interval_msecs_ > 0 ? interval_msecs_ : 1000);
+  auto last_time = std::chrono::steady_clock::now();
+  auto last_synced = statistics_->getTickerCount(rocksdb::WAL_FILE_SYNCED);
+
+  std::unique_lock<std::mutex> lock(lock_);
+  while (!cond_.wait_for(lock, interval, [this] { return stopped_; })) {
+    if (interval_msecs_ > 0) {
+      auto s = db_->SyncWAL();
+      if (s.ok()) {
+        syncs_++;
+      } else {
+        errors_++;
+      }
+    }
+
+    // Sample the rate about every second.
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_time);
+    if (elapsed.count() >= 1000) {
+      auto synced = statistics_->getTickerCount(rocksdb::WAL_FILE_SYNCED);
+      sync_rate_ = (synced - last_synced) * 1000 / elapsed.count();
+      last_synced = synced;
+      last_time = now;
+    }
+  }
+}
+
+}  // namespace ndb
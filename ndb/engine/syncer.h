@@ -0,0 +1,41 @@
+#ifndef NDB_ENGINE_SYNCER_H_
+#define NDB_ENGINE_SYNCER_H_
+
+#include "ndb/engine/common.h"
+
+namespace ndb {
+
+// Sync the WAL periodically, so writes without sync are durable within
+// an interval, and measure the rate of WAL syncs from all write paths.
+class WALSyncer {
+ public:
+  // Sync every interval, or only measure the rate if interval is 0.
+  WALSyncer(rocksdb::DB* db, std::shared_ptr<rocksdb::Statistics> statistics,
+            int interval_msecs);
+
+  ~WALSyncer();
+
+  uint64_t syncs() const { return syncs_; }
+  uint64_t errors() const { return errors_; }
+  // WAL syncs per second in the last second.
+  uint64_t sync_rate() const { return sync_rate_; }
+
+ private:
+  void Run();
+
+ private:
+  rocksdb::DB* db_ {NULL};
+  std::shared_ptr<rocksdb::Statistics> statistics_;
+  int interval_msecs_ {0};
+  std::mutex lock_;
+  std::condition_variable cond_;
+  bool stopped_ {false};
+  std::thread thread_;
+  std::atomic<uint64_t> syncs_ {0};
+  std::atomic<uint64_t> errors_ {0};
+  std::atomic<uint64_t> sync_rate_ {0};
+};
+
+}  // namespace ndb
+
+#endif /* NDB_ENGINE_SYNCER_H_ */
@@ -14,16 +14,112 @@ Value Value::FromBytes(const Slice& b) {
   return value;
 }
 
+// Tag of the compact format.
+static const uint8_t kFormatV1   = 0xc0;
+static const uint8_t kFormatMask = 0xf0;
+static const uint8_t kHasExpire  = 0x08;
+static const uint8_t kKindMask   = 0x07;
+
+// Type, flags, version, length, maxlen, minindex and maxindex.
+static const size_t kMetaSize = 2 + 5 * sizeof(uint64_t);
+
+inline Result ValueError() {
+  return Result::Error("Invalid value.");
+}
+
+static void EncodeTag(std::string* s, uint8_t kind, bool has_expire, uint64_t expire) {
+  s->push_back(kFormatV1 | (has_expire ? kHasExpire : 0) | kind);
+  if (has_expire) EncodeVarint64(s, expire);
+}
+
+static void EncodeMeta(std::string* s, uint8_t type, uint8_t flags,
+                       uint64_t version, uint64_t length, uint64_t maxlen,
+                       uint64_t minindex, uint64_t maxindex, uint64_t cid,
+                       const Slice& packed) {
+  s->push_back(type);
+  s->push_back(flags);
+  EncodeUint64(s, version);
+  EncodeUint64(s, length);
+  EncodeUint64(s, maxlen);
+  EncodeUint64(s, minindex);
+  EncodeUint64(s, maxindex);
+  if (cid != 0) EncodeUint64(s, cid);
+  // Packed members follow the fixed part.
+  s->append(packed.data(), packed.size());
+}
+
 std::string Value::Encode() const {
   std::string s;
-  NDB_ASSERT(SerializeToString(&s));
+  switch (value_case()) {
+    case kInt64: {
+      EncodeTag(&s, ValueView::kInt64, has_expire(), expire());
+      EncodeUint64(&s, int64());
+      break;
+    }
+    case kBytes: {
+      s.reserve(1 + 10 + bytes().size());
+      EncodeTag(&s, ValueView::kBytes, has_expire(), expire());
+      s.append(bytes());
+      break;
+    }
+    case kMeta: {
+      s.reserve(1 + 10 + kMetaSize + 8 + meta().packed().size());
+      EncodeTag(&s, ValueView::kMeta, has_expire(), expire());
+      uint8_t flags = 0;
+      if (meta().deleted()) flags |= ValueView::kDeleted;
+      if (meta().has_maxlen()) flags |= ValueView::kHasMaxlen;
+      if (meta().has_pruning()) flags |= ValueView::kHasPruning;
+      if (meta().pruning() == Pruning::MAX) flags |= ValueView::kPruningMax;
+      if (meta().has_packed()) flags |= ValueView::kPacked;
+      if (meta().cid() != 0) flags |= ValueView::kHasCID;
+      EncodeMeta(&s, meta().type(), flags, meta().version(), meta().length(),
+                 meta().maxlen(), meta().minindex(), meta().maxindex(),
+                 meta().cid(), meta().packed());
+      break;
+    }
+    case VALUE_NOT_SET: {
+      EncodeTag(&s, ValueView::kNone, has_expire(), expire());
+      break;
+    }
+  }
   return s;
 }
 
 Result Value::Decode(const Slice& s) {
-  if (!ParseFromArray(s.data(), s.size())) {
-    return ProtobufError();
+  Clear();
+  if (ValueView::IsLegacy(s)) {
+    if (!ParseFromArray(s.data(), s.size())) {
+      return ProtobufError();
+    }
+  } else {
+    ValueView view;
+    NDB_TRY(view.Decode(s));
+    if (view.has_expire()) {
+      set_expire(view.expire());
+    }
+    if (view.has_int64()) {
+      set_int64(view.int64());
+    } else if (view.has_bytes()) {
+      set_bytes(view.bytes().data(), view.bytes().size());
+    } else if (view.has_meta()) {
+      auto meta = mutable_meta();
+      meta->set_type(view.meta_type());
+      if (view.flags_ & ValueView::kDeleted) meta->set_deleted(true);
+      meta->set_version(view.version_);
+      meta->set_length(view.length_);
+      if (view.flags_ & ValueView::kHasMaxlen) meta->set_maxlen(view.maxlen_);
+      if (view.flags_ & ValueView::kHasPruning) {
+        meta->set_pruning(view.flags_ & ValueView::kPruningMax ? Pruning::MAX : Pruning::MIN);
+      }
+      meta->set_minindex(view.minindex_);
+      meta->set_maxindex(view.maxindex_);
+      if (view.flags_ & ValueView::kHasCID) meta->set_cid(view.cid_);
+      if (view.flags_ & ValueView::kPacked) {
+        meta->set_packed(view.packed_.data(), view.packed_.size());
+      }
+    }
   }
+
   if (IsDeleted()) {
     if (has_meta()) {
       auto version = meta().version();
@@ -82,6 +178,248 @@ bool Value::ExceedMaxlen(uint64_t* start, uint64_t* stop) {
   return true;
 }
 
+bool ValueView::IsLegacy(const Slice& s) {
+  // Empty values are the same in both formats.
+  return s.size() > 0 && (static_cast<uint8_t>(s[0]) & kFormatMask) != kFormatV1;
+}
+
+Result ValueView::Decode(const Slice& s) {
+  *this = ValueView();
+  if (s.size() == 0) {
+    return Result::OK();
+  }
+  if (IsLegacy(s)) {
+    return DecodeLegacy(s);
+  }
+  uint8_t tag = s[0];
+
+  Slice in(s.data() + 1, s.size() - 1);
+  if (tag & kHasExpire) {
+    if (!DecodeVarint64(&in, &expire_)) return ValueError();
+    has_expire_ = true;
+  }
+
+  uint64_t u = 0;
+  switch (tag & kKindMask) {
+    case kNone:
+      if (in.size() != 0) return ValueError();
+      kind_ = kNone;
+      break;
+    case kInt64:
+      if (!DecodeUint64(&in, &u) || in.size() != 0) return ValueError();
+      int64_ = u;
+      kind_ = kInt64;
+      break;
+    case kBytes:
+      bytes_ = in;
+      kind_ = kBytes;
+      break;
+    case kMeta:
+      if (in.size() < kMetaSize) return ValueError();
+      type_ = in[0];
+      flags_ = in[1];
+      in.remove_prefix(2);
+      DecodeUint64(&in, &version_);
+      DecodeUint64(&in, &length_);
+      DecodeUint64(&in, &maxlen_);
+      DecodeUint64(&in, &minindex_);
+      DecodeUint64(&in, &maxindex_);
+      if ((flags_ & kHasCID) && !DecodeUint64(&in, &cid_)) {
+        return ValueError();
+      }
+      if (flags_ & kPacked) {
+        packed_ = in;
+      } else if (in.size() != 0) {
+        return ValueError();
+      }
+      kind_ = kMeta;
+      break;
+    default:
+      return ValueError();
+  }
+  return Result::OK();
+}
+
+std::string ValueView::Encode() const {
+  std::string s;
+  switch (kind_) {
+    case kInt64:
+      EncodeTag(&s, kInt64, has_expire_, expire_);
+      EncodeUint64(&s, int64_);
+      break;
+    case kBytes:
+      s.reserve(1 + 10 + bytes_.size());
+      EncodeTag(&s, kBytes, has_expire_, expire_);
+      s.append(bytes_.data(), bytes_.size());
+      break;
+    case kMeta:
+      s.reserve(1 + 10 + kMetaSize + 8 + packed_.size());
+      EncodeTag(&s, kMeta, has_expire_, expire_);
+      EncodeMeta(&s, type_, flags_, version_, length_, maxlen_, minindex_, maxindex_,
+                 cid_, packed_);
+      break;
+    default:
+      EncodeTag(&s, kNone, has_expire_, expire_);
+      break;
+  }
+  return s;
+}
+
+// Wire types of the protobuf encoding.
+enum WireType : uint8_t {
+  kVarint = 0,
+  kFixed64 = 1,
+  kLengthDelimited = 2,
+  kFixed32 = 5,
+};
+
+// Decode the next field as a varint or a slice, other fields are skipped.
+static bool DecodeField(Slice* in, uint32_t* field, uint8_t* wire,
+                        uint64_t* u, Slice* b) {
+  uint64_t key = 0;
+  if (!DecodeVarint64(in, &key) || (key >> 3) == 0 || (key >> 3) > UINT32_MAX) {
+    return false;
+  }
+  *field = key >> 3;
+  *wire = key & 0x7;
+  switch (*wire) {
+    case kVarint:
+      return DecodeVarint64(in, u);
+    case kFixed64:
+    case kFixed32: {
+      size_t n = *wire == kFixed64 ? 8 : 4;
+      if (in->size() < n) return false;
+      in->remove_prefix(n);
+      return true;
+    }
+    case kLengthDelimited: {
+      uint64_t n = 0;
+      if (!DecodeVarint64(in, &n) || in->size() < n) return false;
+      *b = Slice(in->data(), n);
+      in->remove_prefix(n);
+      return true;
+    }
+    default:
+      // Groups are not used.
+      return false;
+  }
+}
+
+Result ValueView::DecodeLegacy(const Slice& s) {
+  // Scan fields of pb::Value, the last one of a field or a oneof wins and
+  // embedded metas are merged, as protobuf does.
+  Slice in = s;
+  while (in.size() > 0) {
+    uint32_t field = 0;
+    uint8_t wire = 0;
+    uint64_t u = 0;
+    Slice b;
+    if (!DecodeField(&in, &field, &wire, &u, &b)) {
+      return ProtobufError();
+    }
+    if (field == pb::Value::kInt64FieldNumber && wire == kVarint) {
+      kind_ = kInt64;
+      int64_ = u;
+    } else if (field == pb::Value::kBytesFieldNumber && wire == kLengthDelimited) {
+      kind_ = kBytes;
+      bytes_ = b;
+    } else if (field == pb::Value::kMetaFieldNumber && wire == kLengthDelimited) {
+      if (kind_ != kMeta) {
+        kind_ = kMeta;
+        type_ = flags_ = 0;
+        version_ = length_ = maxlen_ = minindex_ = maxindex_ = cid_ = 0;
+        packed_.clear();
+      }
+      NDB_TRY(DecodeLegacyMeta(b));
+    } else if (field == pb::Value::kExpireFieldNumber && wire == kVarint) {
+      has_expire_ = true;
+      expire_ = u;
+    }
+  }
+  // Type is required.
+  if (kind_ == kMeta && type_ == 0) {
+    return ProtobufError();
+  }
+  legacy_ = true;
+  return Result::OK();
+}
+
+Result ValueView::DecodeLegacyMeta(const Slice& s) {
+  Slice in = s;
+  while (in.size() > 0) {
+    uint32_t field = 0;
+    uint8_t wire = 0;
+    uint64_t u = 0;
+    Slice b;
+    if (!DecodeField(&in, &field, &wire, &u, &b)) {
+      return ProtobufError();
+    }
+    if (field == Meta::kPackedFieldNumber && wire == kLengthDelimited) {
+      packed_ = b;
+      flags_ |= kPacked;
+      continue;
+    }
+    if (wire != kVarint) {
+      continue;
+    }
+    switch (field) {
+      case Meta::kTypeFieldNumber:
+        // Unknown enum values are ignored.
+        if (Meta::Type_IsValid(u)) type_ = u;
+        break;
+      case Meta::kDeletedFieldNumber:
+        flags_ = u != 0 ? (flags_ | kDeleted) : (flags_ & ~kDeleted);
+        break;
+      case Meta::kVersionFieldNumber:
+        version_ = u;
+        break;
+      case Meta::kMaxlenFieldNumber:
+        maxlen_ = u;
+        flags_ |= kHasMaxlen;
+        break;
+      case Meta::kLengthFieldNumber:
+        length_ = u;
+        break;
+      case Meta::kPruningFieldNumber:
+        if (pb::Pruning_IsValid(u)) {
+          flags_ |= kHasPruning;
+          flags_ = u == Pruning::MAX ? (flags_ | kPruningMax) : (flags_ & ~kPruningMax);
+        }
+        break;
+      case Meta::kMinindexFieldNumber:
+        minindex_ = u;
+        break;
+      case Meta::kMaxindexFieldNumber:
+        maxindex_ = u;
+        break;
+      case Meta::kCidFieldNumber:
+        cid_ = u;
+        flags_ = u != 0 ? (flags_ | kHasCID) : (flags_ & ~kHasCID);
+        break;
+    }
+  }
+  return Result::OK();
+}
+
+Result ValueView::DecodeLive(const Slice& s) {
+  NDB_TRY(Decode(s));
+  if (IsDeleted()) {
+    return Result::NotFound();
+  }
+  return Result::OK();
+}
+
+bool ValueView::IsDeleted() const {
+  // Deleted or expired.
+  if (has_meta() && meta_deleted()) {
+    return true;
+  }
+  if (has_expire() && expire() < getmstime()) {
+    return true;
+  }
+  return false;
+}
+
 const char* TypeName(const Value& value) {
   if (value.IsDeleted()) {
     return "none";
@@ -105,4 +443,74 @@ const char* PruningName(Pruning pruning) {
   return pruning == Pruning::MIN ? "min" : "max";
 }
 
+static const struct {
+  Compression compression;
+  const char* name;
+} kCompressions[] = {
+  {pb::NONE,   "none"},
+  {pb::SNAPPY, "snappy"},
+  {pb::ZLIB,   "zlib"},
+  {pb::LZ4,    "lz4"},
+  {pb::ZSTD,   "zstd"},
+};
+
+const char* CompressionName(Compression compression) {
+  for (const auto& it : kCompressions) {
+    if (it.compression == compression) return it.name;
+  }
+  return "unknown";
+}
+
+const char* CachePriorityName(CachePriority priority) {
+  return priority == pb::HIGH ? "high" : "low";
+}
+
+static const struct {
+  Durability durability;
+  const char* name;
+} kDurabilities[] = {
+  {pb::NORMAL, "normal"},
+  {pb::SYNC,   "sync"},
+  {pb::NOWAL,  "nowal"},
+};
+
+const char* DurabilityName(Durability durability) {
+  for (const auto& it : kDurabilities) {
+    if (it.durability == durability) return it.name;
+  }
+  return "unknown";
+}
+
+bool ParseCompression(const char* s, Compression* compression) {
+  for (const auto& it : kCompressions) {
+    if (strcasecmp(s, it.name) == 0) {
+      *compression = it.compression;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ParseCachePriority(const char* s, CachePriority* priority) {
+  if (strcasecmp(s, "low") == 0) {
+    *priority = pb::LOW;
+    return true;
+  }
+  if (strcasecmp(s, "high") == 0) {
+    *priority = pb::HIGH;
+    return true;
+  }
+  return false;
+}
+
+bool ParseDurability(const char* s, Durability* durability) {
+  for (const auto& it : kDurabilities) {
+    if (strcasecmp(s, it.name) == 0) {
+      *durability = it.durability;
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace ndb
@@ -1,17 +1,26 @@
+#ifndef NDB_ENGINE_VALUE_H_
+#define NDB_ENGINE_VALUE_H_
+
 #include "ndb/engine/common.h"
+#include "ndb/engine/encode.h"
 
 namespace ndb {
 
 using pb::Meta;
 using pb::Pruning;
 using pb::Configs;
+using pb::Compression;
+using pb::CachePriority;
+using pb::Durability;
 
 class Value : public pb::Value {
  public:
   static Value FromInt64(int64_t i);
   static Value FromBytes(const Slice& b);
 
+  // Encode in the compact format, see ValueView.
   std::string Encode() const;
+  // Decode both the compact format and the legacy protobuf format.
   Result Decode(const Slice& s);
 
   bool IsDeleted() const;
@@ -22,7 +31,96 @@ class Value : public pb::Value {
   bool ExceedMaxlen(uint64_t* start, uint64_t* stop);
 };
 
+// A value decoded in place without allocation, it refers to the encoded data.
+// The compact format is:
+//   tag [varint expire] [fixed int64 | raw bytes | fixed meta [cid] [packed]]
+// The high nibble of tag is the format version and never collides with
+// the first byte of a legacy protobuf value, whose fields are scanned from
+// the wire format instead of being parsed by protobuf.
+class ValueView {
+ public:
+  // Whether s is in the legacy protobuf format.
+  static bool IsLegacy(const Slice& s);
+
+  Result Decode(const Slice& s);
+  // Decode and return NotFound if deleted or expired like Value::Decode().
+  Result DecodeLive(const Slice& s);
+
+  // Encode in the compact format, the same as Value::Encode().
+  std::string Encode() const;
+
+  bool IsDeleted() const;
+
+  bool has_expire() const { return has_expire_; }
+  uint64_t expire() const { return expire_; }
+
+  bool has_int64() const { return kind_ == kInt64; }
+  int64_t int64() const { return int64_; }
+
+  bool has_bytes() const { return kind_ == kBytes; }
+  Slice bytes() const { return bytes_; }
+
+  bool has_meta() const { return kind_ == kMeta; }
+  Meta::Type meta_type() const { return static_cast<Meta::Type>(type_); }
+  bool meta_deleted() const { return flags_ & kDeleted; }
+  uint64_t meta_version() const { return version_; }
+  uint64_t meta_length() const { return length_; }
+  bool meta_has_packed() const { return flags_ & kPacked; }
+  Slice meta_packed() const { return packed_; }
+  uint64_t meta_cid() const { return cid_; }
+
+  // Legacy value which needs migration.
+  bool legacy() const { return legacy_; }
+
+ private:
+  friend class Value;
+
+  Result DecodeLegacy(const Slice& s);
+  Result DecodeLegacyMeta(const Slice& s);
+
+  enum Kind : uint8_t { kNone = 0, kInt64 = 1, kBytes = 2, kMeta = 3 };
+  enum Flags : uint8_t {
+    kDeleted    = 1 << 0,
+    kHasMaxlen  = 1 << 1,
+    kHasPruning = 1 << 2,
+    kPruningMax = 1 << 3,
+    kPacked     = 1 << 4,
+    kHasCID     = 1 << 5,
+  };
+
+  Kind kind_ {kNone};
+  bool has_expire_ {false};
+  uint64_t expire_ {0};
+  int64_t int64_ {0};
+  Slice bytes_;
+  // Meta fields.
+  uint8_t type_ {0};
+  uint8_t flags_ {0};
+  uint64_t version_ {0};
+  uint64_t length_ {0};
+  uint64_t maxlen_ {0};
+  uint64_t minindex_ {0};
+  uint64_t maxindex_ {0};
+  uint64_t cid_ {0};
+  Slice packed_;
+  bool legacy_ {false};
+};
+
 const char* TypeName(const Value& value);
 const char* PruningName(Pruning pruning);
+const char* CompressionName(Compression compression);
+const char* CachePriorityName(CachePriority priority);
+const char* DurabilityName(Durability durability);
+
+// Parse compression as [none|snappy|zlib|lz4|zstd].
+bool ParseCompression(const char* s, Compression* compression);
+
+// Parse cache priority as [low|high].
+bool ParseCachePriority(const char* s, CachePriority* priority);
+
+// Parse durability as [normal|sync|nowal].
+bool ParseDurability(const char* s, Durability* durability);
 
 }  // namespace ndb
+
+#endif /* NDB_ENGINE_VALUE_H_ */
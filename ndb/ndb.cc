@@ -28,11 +28,15 @@ NDB::NDB(int argc, char* argv[]) {
   server = new Server(options.server);
   command = new Command(options.command, engine);
   replica = new Replica(options.replica, engine);
+  lazyfree = new LazyFree(options.lazyfree, &hashlock);
+  expirer = new Expirer(options.expirer, engine, &hashlock, lazyfree);
 }
 
 NDB::~NDB() {
   // Stop server first.
   delete server;
+  delete expirer;
+  delete lazyfree;
   delete replica;
   delete command;
   delete engine;
@@ -44,7 +48,15 @@ Result NDB::Run() {
   NDB_TRY(engine->Open());
   NDB_TRY(command->Run());
   NDB_TRY(replica->Run());
-  return server->Run([this](Client* c) { return command->ProcessClient(c); });
+  // Slaves delete expired keys and free collections by replicating from master.
+  if (options.replica.address.size() == 0) {
+    NDB_TRY(lazyfree->Run());
+    NDB_TRY(expirer->Run());
+  }
+  return server->Run([this](Client* c) { return command->ProcessClient(c); },
+                     [this](const Request& r, uint64_t* hash) {
+                       return command->HashRequest(r, hash);
+                     });
 }
 
 // Update namespaces.
@@ -63,7 +75,7 @@ static bool UpdateNamespaces() {
     if (ndb->engine->GetNamespace(it.first) != NULL) {
       continue;
     }
-    auto r = ndb->engine->NewNamespace(it.first);
+    auto r = ndb->engine->NewNamespace(it.first, it.second);
     if (!r.ok()) {
       NDB_LOG_ERROR("*CENTER* New namespace [%s]: %s", it.first.c_str(), r.message());
       continue;
@@ -104,9 +116,7 @@ static void UpdateNSConfigs() {
       continue;
     }
     auto configs = ns->GetConfigs();
-    if (configs.expire() == it.second.expire() &&
-        configs.maxlen() == it.second.maxlen() &&
-        configs.pruning() == it.second.pruning()) {
+    if (configs.SerializeAsString() == it.second.SerializeAsString()) {
       // Nothing to update.
       continue;
     }
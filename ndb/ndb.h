@@ -14,6 +14,8 @@ struct NDB {
   Engine* engine {NULL};
   Command* command {NULL};
   Replica* replica {NULL};
+  Expirer* expirer {NULL};
+  LazyFree* lazyfree {NULL};
 
   NDB(int argc, char* argv[]);
   ~NDB();
@@ -23,18 +23,36 @@ Options::Options() {
   CONFIG(engine.memtable_size, kSize);
   CONFIG(engine.block_cache_size, kSize);
   CONFIG(engine.compaction_cache_size, kSize);
+  CONFIG(engine.meta_cache_size, kSize);
+  CONFIG(engine.write_combine_size, kSize);
+  CONFIG(engine.write_combine_usecs, kInt);
+  CONFIG(engine.sync_mode, kString);
+  CONFIG(engine.sync_interval_msecs, kInt);
+  CONFIG(engine.pipelined_write, kBool);
+  CONFIG(engine.unordered_write, kBool);
+  CONFIG(engine.two_write_queues, kBool);
   CONFIG(engine.background_threads, kInt);
 
   CONFIG(server.address, kString);
+  CONFIG(server.num_reactors, kInt);
+  CONFIG(server.ioloop, kString);
   CONFIG(server.num_workers, kInt);
   CONFIG(server.max_clients, kInt);
   CONFIG(server.timeout_secs, kInt);
   CONFIG(server.buffer_size, kSize);
+  CONFIG(server.block_size, kSize);
   CONFIG(server.channel_size, kSize);
+  CONFIG(server.overload_policy, kString);
+  CONFIG(server.dispatch_mode, kString);
 
   CONFIG(replica.address, kString);
   CONFIG(replica.replicate_limit, kSize);
 
+  CONFIG(expirer.expire_rate, kSize);
+  CONFIG(expirer.batch_size, kSize);
+
+  CONFIG(lazyfree.max_pending, kSize);
+
   CONFIG(command.access_mode, kString);
   CONFIG(command.max_arguments, kInt);
   CONFIG(command.slowlogs_maxlen, kInt);
@@ -6,6 +6,8 @@
 #include "ndb/server/server.h"
 #include "ndb/engine/engine.h"
 #include "ndb/engine/hashlock.h"
+#include "ndb/thread/lazyfree.h"
+#include "ndb/thread/expirer.h"
 #include "ndb/thread/replica.h"
 #include "ndb/command/command.h"
 
@@ -19,6 +21,8 @@ struct Options {
   Engine::Options engine;
   Server::Options server;
   Replica::Options replica;
+  Expirer::Options expirer;
+  LazyFree::Options lazyfree;
   Command::Options command;
 
   Options();
@@ -5,86 +5,237 @@
 
 namespace ndb {
 
-class RecvBuf {
+// Chunk of memory shared by the receive buffer and requests,
+// arguments of requests are slices into the chunk.
+class Chunk {
  public:
-  ~RecvBuf() { free(data_); }
+  Chunk(size_t capacity) : data_((char*) malloc(capacity)), capacity_(capacity) {}
+
+  ~Chunk() { free(data_); }
+
+  char* data() const { return data_; }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  char* data_ {NULL};
+  size_t capacity_ {0};
+};
+
+typedef std::shared_ptr<Chunk> ChunkRef;
+
+// BlockPool recycles fixed-size chunks, a chunk returns to the pool
+// when the last request refers to it is destroyed, maybe in another thread.
+class BlockPool : public std::enable_shared_from_this<BlockPool> {
+ public:
+  BlockPool(size_t block_size = 64 << 10, size_t max_free = 1024)
+      : block_size_(block_size), max_free_(max_free) {
+  }
+
+  ~BlockPool() {
+    for (auto block : free_) { delete block; }
+  }
+
+  size_t block_size() const { return block_size_; }
 
-  const char* data() const { return data_; }
+  // Number of blocks in use.
+  size_t used() const { return used_; }
 
-  size_t size() const { return size_; }
+  // Number of blocks kept for reuse.
+  size_t unused() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+  }
 
-  Result Recv(int fd, size_t size) {
-    if (size > capp_ - size_) {
-      capp_ = size_ + size;
-      data_ = (char*) realloc(data_, capp_);
+  // Chunks larger than the block size are not pooled.
+  ChunkRef Get(size_t size) {
+    if (size > block_size_) {
+      return std::make_shared<Chunk>(size);
     }
-    while (size != 0) {
-      ssize_t n = read(fd, data_ + size_, size);
-      if (n < 0) {
-        if (errno == EAGAIN) {
-          return Result::OK();
-        } else {
-          return Result::Errno("read()");
-        }
+    Chunk* block = NULL;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_.empty()) {
+        block = free_.back();
+        free_.pop_back();
       }
-      if (n == 0) {
-        return Result::Error("closed.");
+    }
+    if (block == NULL) {
+      block = new Chunk(block_size_);
+    }
+    used_++;
+    // The pool lives until all of its blocks are returned.
+    auto pool = shared_from_this();
+    return ChunkRef(block, [pool](Chunk* block) { pool->Put(block); });
+  }
+
+ private:
+  void Put(Chunk* block) {
+    used_--;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (free_.size() < max_free_) {
+        free_.push_back(block);
+        return;
+      }
+    }
+    delete block;
+  }
+
+ private:
+  size_t block_size_;
+  size_t max_free_;
+  std::atomic<size_t> used_ {0};
+  mutable std::mutex mutex_;
+  std::vector<Chunk*> free_;
+};
+
+// RecvBuf reads into blocks from the pool. Data is never moved or
+// overwritten, when the block is full the unparsed tail (at most one
+// element of a request) is copied to the next block once.
+class RecvBuf {
+ public:
+  void set_pool(const std::shared_ptr<BlockPool>& pool) { pool_ = pool; }
+
+  const char* data() const { return chunk_->data() + begin_; }
+
+  size_t size() const { return end_ - begin_; }
+
+  const ChunkRef& chunk() const { return chunk_; }
+
+  // Read once into the current block, *n is 0 if nothing to read.
+  // The unparsed element needs at least need bytes if known.
+  Result Recv(int fd, size_t need, size_t* n) {
+    *n = 0;
+    Reserve(need);
+    ssize_t nread = read(fd, chunk_->data() + end_, chunk_->capacity() - end_);
+    if (nread < 0) {
+      if (errno == EAGAIN) {
+        return Result::OK();
+      } else {
+        return Result::Errno("read()");
       }
-      size -= n;
-      size_ += n;
     }
+    if (nread == 0) {
+      return Result::Error("closed.");
+    }
+    end_ += nread;
+    *n = nread;
     return Result::OK();
   }
 
+  // Copy data received elsewhere into the current block, like Recv(),
+  // return the number of bytes copied.
+  size_t Append(const Slice& data, size_t need) {
+    Reserve(need);
+    size_t n = std::min(data.size(), chunk_->capacity() - end_);
+    memcpy(chunk_->data() + end_, data.data(), n);
+    end_ += n;
+    return n;
+  }
+
   void Skip(size_t pos) {
-    if (pos >= size_) {
-      size_ = 0;
+    begin_ = std::min(begin_ + pos, end_);
+    if (begin_ == end_) {
+      // Release the block, idle clients hold no memory.
+      chunk_.reset();
+      begin_ = end_ = 0;
+    }
+  }
+
+ private:
+  // Make room after the unparsed data.
+  void Reserve(size_t need) {
+    if (!pool_) {
+      pool_ = std::make_shared<BlockPool>();
+    }
+    if (chunk_ && end_ < chunk_->capacity()) {
       return;
     }
-    memmove(data_, data_ + pos, size_ - pos);
-    size_ -= pos;
+    size_t remain = size();
+    size_t capacity = pool_->block_size();
+    if (need > remain) {
+      capacity = std::max(capacity, need);
+    } else {
+      // Unknown size, an inline request or a header line.
+      capacity = std::max(capacity, remain * 2);
+    }
+    auto chunk = pool_->Get(capacity);
+    if (remain > 0) {
+      memcpy(chunk->data(), data(), remain);
+    }
+    chunk_ = chunk;
+    begin_ = 0;
+    end_ = remain;
   }
 
  private:
-  char* data_ {NULL};
-  size_t size_ {0};
-  size_t capp_ {0};
+  std::shared_ptr<BlockPool> pool_;
+  ChunkRef chunk_;
+  size_t begin_ {0};
+  size_t end_ {0};
 };
 
+// SendBuf gathers buffers and writes them with one writev(),
+// a partially written buffer is resumed from offset() next time.
 class SendBuf {
  public:
-  const char* data() const { return data_; }
+  static const size_t kMaxBuffers = IOV_MAX;
+
+  size_t offset() const { return offset_; }
 
-  size_t size() const { return size_; }
+  size_t count() const { return iov_.size(); }
 
-  Result Send(int fd, size_t size) {
-    if (size > size_) {
-      size = size_;
+  void Clear() { iov_.clear(); }
+
+  void Append(const char* data, size_t size) {
+    if (iov_.empty()) {
+      data += offset_;
+      size -= offset_;
+    }
+    iov_.push_back({(void*) data, size});
+  }
+
+  // Set the number of buffers written completely to *nbufs.
+  Result Send(int fd, size_t* nbufs) {
+    *nbufs = 0;
+    if (iov_.empty()) {
+      return Result::OK();
     }
-    while (size != 0) {
-      ssize_t n = write(fd, data_, size);
-      if (n == -1) {
-        if (errno == EAGAIN) {
-          return Result::OK();
-        } else {
-          return Result::Errno("write()");
-        }
+    ssize_t n = writev(fd, &iov_[0], iov_.size());
+    if (n == -1) {
+      if (errno == EAGAIN) {
+        return Result::OK();
+      } else {
+        return Result::Errno("writev()");
       }
-      size -= n;
-      data_ += n;
-      size_ -= n;
     }
+    calls_++;
+    bytes_ += n;
+
+    size_t i = 0;
+    size_t remain = n;
+    while (i < iov_.size() && remain >= iov_[i].iov_len) {
+      remain -= iov_[i].iov_len;
+      i++;
+    }
+    offset_ = (i == 0) ? offset_ + remain : remain;
+    *nbufs = i;
     return Result::OK();
   }
 
-  void Attach(const char* data, size_t size) {
-    data_ = data;
-    size_ = size;
+  // Take and reset counters of writev().
+  void TakeStats(uint64_t* calls, uint64_t* bytes) {
+    *calls = calls_;
+    *bytes = bytes_;
+    calls_ = bytes_ = 0;
   }
 
  private:
-  const char* data_ {NULL};
-  size_t size_ {0};
+  size_t offset_ {0};
+  uint64_t calls_ {0};
+  uint64_t bytes_ {0};
+  std::vector<iovec> iov_;
 };
 
 }  // namespace ndb
@@ -12,10 +12,12 @@ bool Client::HasTimeout() const {
   return (gettime() - active_time_) >= timeout_;
 }
 
-Result Client::HandleEvent(IOLoop::Event event) {
+Result Client::HandleEvent(IOLoop::Event event, const Slice& data) {
   active_time_ = gettime();
   if (IOLoop::Readable(event)) {
     return RecvRequest();
+  } else if (IOLoop::Received(event)) {
+    return RecvRequest(data);
   } else if (IOLoop::Writable(event)) {
     return SendResponse();
   }
@@ -23,14 +25,40 @@ Result Client::HandleEvent(IOLoop::Event event) {
 }
 
 Result Client::RecvRequest() {
-  NDB_TRY(rbuf_.Recv(fd(), 1024 * 1024));
-  if (rbuf_.size() > bufsize_) {
-    return Result::Error("Read buffer limit exceed %zu", bufsize_);
+  // Read and parse block by block, at most 1M per event.
+  size_t total = 0;
+  while (total < 1024 * 1024) {
+    size_t n = 0;
+    NDB_TRY(rbuf_.Recv(fd(), builder_.Needed(), &n));
+    if (n == 0) {
+      break;
+    }
+    total += n;
+    if (rbuf_.size() > bufsize_) {
+      return Result::Error("Read buffer limit exceed %zu", bufsize_);
+    }
+    NDB_TRY(ParseRequests());
+  }
+  return Result::OK();
+}
+
+Result Client::RecvRequest(const Slice& data) {
+  // Copy and parse block by block.
+  Slice in = data;
+  while (in.size() > 0) {
+    in.remove_prefix(rbuf_.Append(in, builder_.Needed()));
+    if (rbuf_.size() > bufsize_) {
+      return Result::Error("Read buffer limit exceed %zu", bufsize_);
+    }
+    NDB_TRY(ParseRequests());
   }
+  return Result::OK();
+}
 
+Result Client::ParseRequests() {
   size_t pos = 0;
   while (pos < rbuf_.size()) {
-    ssize_t n = builder_.Parse(rbuf_.data() + pos, rbuf_.size() - pos);
+    ssize_t n = builder_.Parse(rbuf_.data() + pos, rbuf_.size() - pos, rbuf_.chunk());
     if (n < 0) {
       return Result::Error("Invalid request: %zd", n);
     }
@@ -50,17 +78,24 @@ Result Client::RecvRequest() {
 }
 
 Result Client::SendResponse() {
-  if (sbuf_.size() == 0) {
-    if (!HasResponse()) {
-      return Result::OK();
+  while (HasResponse()) {
+    sbuf_.Clear();
+    for (const auto& response : responses_) {
+      if (sbuf_.count() == SendBuf::kMaxBuffers) {
+        break;
+      }
+      sbuf_.Append(response.data(), response.size());
     }
-    const auto& response = GetResponse();
-    sbuf_.Attach(response.data(), response.size());
-  }
 
-  NDB_TRY(sbuf_.Send(fd(), sbuf_.size()));
-  if (sbuf_.size() == 0) {
-    PopResponse();
+    size_t nbufs = 0;
+    NDB_TRY(sbuf_.Send(fd(), &nbufs));
+    for (size_t i = 0; i < nbufs; i++) {
+      PopResponse();
+    }
+    if (nbufs < sbuf_.count()) {
+      // Socket buffer is full.
+      break;
+    }
   }
   return Result::OK();
 }
@@ -19,24 +19,43 @@ class Client : public Socket {
 
   void set_timeout(seconds timeout) { timeout_ = timeout.count(); }
 
+  // Receive buffers are taken from the pool of the reactor.
+  void set_pool(const std::shared_ptr<BlockPool>& pool) { rbuf_.set_pool(pool); }
+
+  // The reactor this client belongs to.
+  int reactor() const { return reactor_; }
+  void set_reactor(int reactor) { reactor_ = reactor; }
+
   bool HasTimeout() const;
 
-  Result HandleEvent(IOLoop::Event event);
+  // Data are received by the ioloop with kReceived.
+  Result HandleEvent(IOLoop::Event event, const Slice& data = Slice());
 
   // Request
   const Request& GetRequest() const { return requests_.front(); }
   bool HasRequest() const { return requests_.size() > 0; };
-  void PopRequest() { requests_.pop(); }
-  void PutRequest(Request&& request) { requests_.push(std::move(request)); }
+  void PopRequest() { requests_.pop_front(); if (quota_ > 0) quota_--; }
+  void PutRequest(Request&& request) { requests_.push_back(std::move(request)); }
+  const std::deque<Request>& requests() const { return requests_; }
+
+  // Number of requests a worker may process before the client goes
+  // back to the reactor, the rest are dispatched again.
+  void set_quota(size_t quota) { quota_ = quota; }
+  bool HasQuota() const { return quota_ > 0 && HasRequest(); }
 
   // Response
   const Response& GetResponse() const { return responses_.front(); }
   bool HasResponse() const { return responses_.size() > 0; };
-  void PopResponse() { responses_.pop(); }
-  void PutResponse(Response&& response) { responses_.push(std::move(response)); }
+  void PopResponse() { responses_.pop_front(); }
+  void PutResponse(Response&& response) { responses_.push_back(std::move(response)); }
+
+  // Take and reset counters of writes.
+  void TakeSendStats(uint64_t* calls, uint64_t* bytes) { sbuf_.TakeStats(calls, bytes); }
 
  private:
   Result RecvRequest();
+  Result RecvRequest(const Slice& data);
+  Result ParseRequests();
   Result SendResponse();
 
  private:
@@ -44,11 +63,13 @@ class Client : public Socket {
   size_t bufsize_ {16 << 20};
   uint64_t timeout_ {60};
   uint64_t active_time_;
+  int reactor_ {0};
   RecvBuf rbuf_;
   SendBuf sbuf_;
   RequestBuilder builder_;
-  std::queue<Request> requests_;
-  std::queue<Response> responses_;
+  size_t quota_ {SIZE_MAX};
+  std::deque<Request> requests_;
+  std::deque<Response> responses_;
 };
 
 }  // namespace ndb
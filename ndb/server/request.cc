@@ -34,10 +34,12 @@ void RequestBuilder::Reset() {
   argc_ = -1;
   argz_ = -1;
   args_.clear();
+  chunks_.clear();
+  chunk_.reset();
   finished_ = false;
 }
 
-ssize_t RequestBuilder::Parse(const char* input, size_t size) {
+ssize_t RequestBuilder::Parse(const char* input, size_t size, const ChunkRef& chunk) {
   if (size == 0) return 0;
   if (type_ == kUnknown) {
     if (input[0] != '*') {
@@ -46,10 +48,15 @@ ssize_t RequestBuilder::Parse(const char* input, size_t size) {
       type_ = kMultiBulk;
     }
   }
+  chunk_ = chunk;
+  ssize_t n = 0;
   if (type_ == kInline) {
-    return ParseInline(input, size);
+    n = ParseInline(input, size);
+  } else {
+    n = ParseMultiBulk(input, size);
   }
-  return ParseMultiBulk(input, size);
+  chunk_.reset();
+  return n;
 }
 
 ssize_t RequestBuilder::ParseInline(const char* input, size_t size) {
@@ -74,7 +81,7 @@ ssize_t RequestBuilder::ParseInline(const char* input, size_t size) {
       }
     }
 
-    args_.push_back(std::string(pos, space - pos));
+    AddArgument(pos, space - pos);
     pos = space + 1;
   }
 
@@ -146,7 +153,7 @@ ssize_t RequestBuilder::ParseMultiBulk(const char* input, size_t size) {
       return -7;
     }
 
-    args_.push_back(std::string(pos, argz_));
+    AddArgument(pos, argz_);
     argz_ = -1;
 
     pos = newline + 2;
@@ -156,8 +163,20 @@ ssize_t RequestBuilder::ParseMultiBulk(const char* input, size_t size) {
   return pos - input;
 }
 
+void RequestBuilder::AddArgument(const char* data, size_t size) {
+  args_.push_back(Slice(data, size));
+  if (chunk_ && (chunks_.empty() || chunks_.back() != chunk_)) {
+    chunks_.push_back(chunk_);
+  }
+}
+
 Request RequestBuilder::Finish() {
-  return Request(std::move(args_));
+  // Transform command to UPPERCASE in place.
+  if (args_.size() > 0) {
+    auto cmd = const_cast<char*>(args_[0].data());
+    std::transform(cmd, cmd + args_[0].size(), cmd, toupper);
+  }
+  return Request(std::move(args_), std::move(chunks_));
 }
 
 }  // namespace ndb
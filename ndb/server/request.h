@@ -2,51 +2,60 @@
 #define NDB_SERVER_REQUEST_H_
 
 #include "ndb/common/common.h"
+#include "ndb/server/buffer.h"
 
 namespace ndb {
 
+// Arguments are slices into chunks of the receive buffer,
+// which are kept alive by the request.
 class Request {
  public:
-  typedef std::vector<std::string> Arguments;
+  typedef std::vector<Slice> Arguments;
 
-  Request(Arguments&& args) : args_(std::move(args)) {
-    // Transform command to UPPERCASE.
-    if (args_.size() > 0) {
-      args_[0] = stoupper(args_[0]);
-    }
+  // Arguments without chunks must outlive the request.
+  Request(Arguments&& args,
+          std::vector<ChunkRef>&& chunks = std::vector<ChunkRef>())
+      : args_(std::move(args)), chunks_(std::move(chunks)) {
   }
 
   size_t argc() const { return args_.size(); }
 
   const Arguments& args() const { return args_; }
 
-  const std::string& args(int i) const { return args_[i]; }
+  const Slice& args(int i) const { return args_[i]; }
 
   std::string join() const {
     std::string line;
     for (size_t i = 0; i < argc(); i++) {
-      line += args(i) + " ";
+      line.append(args(i).data(), args(i).size());
+      line.append(" ");
     }
     return line;
   }
 
  private:
   Arguments args_;
+  std::vector<ChunkRef> chunks_;
 };
 
 class RequestBuilder {
  public:
   void Reset();
 
-  ssize_t Parse(const char* input, size_t size);
+  // Arguments are slices into input, chunk keeps input alive.
+  ssize_t Parse(const char* input, size_t size, const ChunkRef& chunk = ChunkRef());
 
   Request Finish();
 
   bool IsFinished() const { return finished_; }
 
+  // Bytes of the element being parsed, 0 if unknown.
+  size_t Needed() const { return argz_ < 0 ? 0 : argz_ + 2; }
+
  private:
   ssize_t ParseInline(const char* input, size_t size);
   ssize_t ParseMultiBulk(const char* input, size_t size);
+  void AddArgument(const char* data, size_t size);
 
  private:
   enum Type { kUnknown, kInline, kMultiBulk };
@@ -54,6 +63,8 @@ class RequestBuilder {
   ssize_t argc_ {-1};
   ssize_t argz_ {-1};
   Request::Arguments args_;
+  std::vector<ChunkRef> chunks_;
+  ChunkRef chunk_;
   bool finished_ {false};
 };
 
@@ -2,15 +2,64 @@
 
 namespace ndb {
 
-const char* kResponseOK   = "+OK\r\n";
-const char* kResponsePONG = "+PONG\r\n";
-const char* kResponseNULL = "$-1\r\n";
+// Shared constant responses.
+static const std::string kResponseOK("+OK\r\n");
+static const std::string kResponsePONG("+PONG\r\n");
+static const std::string kResponseNULL("$-1\r\n");
+static const std::string kResponseZero(":0\r\n");
+static const std::string kResponseOne(":1\r\n");
+static const std::string kResponseEmpty("*0\r\n");
+static const std::string kResponseWrongType("-ERR Wrong type.\r\n");
+static const std::string kResponseOutofRange("-ERR Out of range.\r\n");
+static const std::string kResponseInvalidOption("-ERR Invalid option.\r\n");
+static const std::string kResponseInvalidCommand("-ERR Invalid command.\r\n");
+static const std::string kResponseInvalidArgument("-ERR Invalid argument.\r\n");
+static const std::string kResponseInvalidNamespace("-ERR Invalid namespace.\r\n");
+static const std::string kResponsePermissionDenied("-ERR Permission denied.\r\n");
+static const std::string kResponseBusy("-BUSY Server is busy, try again later.\r\n");
+
+static const char kDigits[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Format i backwards from end, return the beginning.
+static char* FormatInt(int64_t i, char* end) {
+  uint64_t v = i < 0 ? 0 - (uint64_t) i : (uint64_t) i;
+  char* p = end;
+  while (v >= 100) {
+    auto d = (v % 100) * 2;
+    v /= 100;
+    *--p = kDigits[d+1];
+    *--p = kDigits[d];
+  }
+  if (v >= 10) {
+    auto d = v * 2;
+    *--p = kDigits[d+1];
+    *--p = kDigits[d];
+  } else {
+    *--p = '0' + v;
+  }
+  if (i < 0) {
+    *--p = '-';
+  }
+  return p;
+}
+
+static size_t CountDigits(int64_t i) {
+  uint64_t v = i < 0 ? 0 - (uint64_t) i : (uint64_t) i;
+  size_t n = (i < 0) ? 2 : 1;
+  for (; v >= 10; v /= 10) n++;
+  return n;
+}
 
 Response::Response(const Result& r) {
   if (r.ok()) {
-    s_ = kResponseOK;
+    shared_ = &kResponseOK;
   } else if (r.IsNotFound()) {
-    s_ = kResponseNULL;
+    shared_ = &kResponseNULL;
   } else {
     s_ = "-ERR " + std::string(r.message()) + "\r\n";
   }
@@ -18,10 +67,10 @@ Response::Response(const Result& r) {
 
 // Simple Strings
 Response Response::OK() {
-  return Response(kResponseOK);
+  return Response(&kResponseOK);
 }
 Response Response::PONG() {
-  return Response(kResponsePONG);
+  return Response(&kResponsePONG);
 }
 Response Response::Simple(const std::string& s) {
   return Response("+" + s + "\r\n");
@@ -29,29 +78,34 @@ Response Response::Simple(const std::string& s) {
 
 // Errors
 Response Response::WrongType() {
-  return Response("-ERR Wrong type.\r\n");
+  return Response(&kResponseWrongType);
 }
 Response Response::OutofRange() {
-  return Response("-ERR Out of range.\r\n");
+  return Response(&kResponseOutofRange);
 }
 Response Response::InvalidOption() {
-  return Response("-ERR Invalid option.\r\n");
+  return Response(&kResponseInvalidOption);
 }
 Response Response::InvalidCommand() {
-  return Response("-ERR Invalid command.\r\n");
+  return Response(&kResponseInvalidCommand);
 }
 Response Response::InvalidArgument() {
-  return Response("-ERR Invalid argument.\r\n");
+  return Response(&kResponseInvalidArgument);
 }
 Response Response::InvalidNamespace() {
-  return Response("-ERR Invalid namespace.\r\n");
+  return Response(&kResponseInvalidNamespace);
 }
 Response Response::PermissionDenied() {
-  return Response("-ERR Permission denied.\r\n");
+  return Response(&kResponsePermissionDenied);
+}
+Response Response::Busy() {
+  return Response(&kResponseBusy);
 }
 
 // Integers
 Response Response::Int(int64_t i) {
+  if (i == 0) return Response(&kResponseZero);
+  if (i == 1) return Response(&kResponseOne);
   Response r;
   r.AppendInt(i);
   return r;
@@ -59,16 +113,14 @@ Response Response::Int(int64_t i) {
 
 // Bulk Strings
 Response Response::Null() {
-  Response r;
-  r.AppendNull();
-  return r;
+  return Response(&kResponseNULL);
 }
 Response Response::Bulk(int64_t i) {
   Response r;
   r.AppendBulk(i);
   return r;
 }
-Response Response::Bulk(const std::string& bulk) {
+Response Response::Bulk(const Slice& bulk) {
   Response r;
   r.AppendBulk(bulk);
   return r;
@@ -81,6 +133,7 @@ Response Response::Bulk(const char* data, size_t size) {
 
 // Bulk Arrays
 Response Response::Size(size_t size) {
+  if (size == 0) return Response(&kResponseEmpty);
   Response r;
   r.AppendSize(size);
   return r;
@@ -91,53 +144,106 @@ Response Response::Bulks(const std::vector<std::string>& bulks) {
   return r;
 }
 
+// Encoded sizes
+size_t Response::SizeOfInt(int64_t i) {
+  return 1 + CountDigits(i) + 2;
+}
+size_t Response::SizeOfBulk(int64_t i) {
+  return SizeOfBulk(NULL, CountDigits(i));
+}
+size_t Response::SizeOfBulk(const char* data, size_t size) {
+  return 1 + CountDigits(size) + 2 + size + 2;
+}
+size_t Response::SizeOfSize(size_t size) {
+  return 1 + CountDigits(size) + 2;
+}
+
+void Response::Reserve(size_t size) {
+  Unshare();
+  s_.reserve(size);
+}
+
+void Response::ReserveMore(size_t mark, size_t count) {
+  // Estimates of large elements are capped, the rest grows as appended.
+  static const size_t kMaxReserveMore = 4 << 20;
+  if (size() > mark) {
+    auto element = size() - mark;
+    auto more = count < kMaxReserveMore / element ? element * count : kMaxReserveMore;
+    Reserve(size() + more);
+  }
+}
+
 bool Response::IsOK() const {
-  return s_ == kResponseOK;
+  return size() == kResponseOK.size() &&
+      memcmp(data(), kResponseOK.data(), size()) == 0;
 }
 bool Response::IsNull() const {
-  return s_ == kResponseNULL;
+  return size() == kResponseNULL.size() &&
+      memcmp(data(), kResponseNULL.data(), size()) == 0;
 }
 
 void Response::Append(const Response& res) {
+  Unshare();
   s_.append(res.data(), res.size());
 }
 
 // Integers
 void Response::AppendInt(int64_t i) {
-  s_.append(":");
-  s_.append(std::to_string(i));
-  s_.append("\r\n");
+  AppendHeader(':', i);
 }
 
 // Bulk Strings
 void Response::AppendNull() {
+  Unshare();
   s_.append(kResponseNULL);
 }
 void Response::AppendBulk(int64_t i) {
-  AppendBulk(std::to_string(i));
+  char buf[32];
+  auto end = buf + sizeof(buf);
+  auto begin = FormatInt(i, end);
+  AppendBulk(begin, end - begin);
 }
-void Response::AppendBulk(const std::string& bulk) {
+void Response::AppendBulk(const Slice& bulk) {
   AppendBulk(bulk.data(), bulk.size());
 }
 void Response::AppendBulk(const char* data, size_t size) {
-  s_.append("$");
-  s_.append(std::to_string(size));
-  s_.append("\r\n");
+  AppendHeader('$', size);
   s_.append(data, size);
-  s_.append("\r\n");
+  s_.append("\r\n", 2);
 }
 
 // Bulk Arrays
 void Response::AppendSize(size_t size) {
-  s_.append("*");
-  s_.append(std::to_string(size));
-  s_.append("\r\n");
+  AppendHeader('*', size);
 }
 void Response::AppendBulks(const std::vector<std::string>& bulks) {
+  size_t total = size() + SizeOfSize(bulks.size());
+  for (const auto& bulk : bulks) {
+    total += SizeOfBulk(bulk.data(), bulk.size());
+  }
+  Reserve(total);
   AppendSize(bulks.size());
   for (const auto& bulk : bulks) {
     AppendBulk(bulk);
   }
 }
 
+void Response::Unshare() {
+  if (shared_ != NULL) {
+    s_ = *shared_;
+    shared_ = NULL;
+  }
+}
+
+void Response::AppendHeader(char prefix, int64_t i) {
+  Unshare();
+  char buf[32];
+  auto end = buf + sizeof(buf);
+  end[-2] = '\r';
+  end[-1] = '\n';
+  auto begin = FormatInt(i, end - 2);
+  *--begin = prefix;
+  s_.append(begin, end - begin);
+}
+
 }  // namespace ndb
@@ -5,6 +5,7 @@
 
 namespace ndb {
 
+// Constant responses share immutable buffers, others own their data.
 class Response {
  public:
   // Simple Strings
@@ -20,6 +21,7 @@ class Response {
   static Response InvalidArgument();
   static Response InvalidNamespace();
   static Response PermissionDenied();
+  static Response Busy();
 
   // Integers
   static Response Int(int64_t i);
@@ -27,22 +29,34 @@ class Response {
   // Bulk Strings
   static Response Null();
   static Response Bulk(int64_t i);
-  static Response Bulk(const std::string& bulk);
+  static Response Bulk(const Slice& bulk);
   static Response Bulk(const char* data, size_t size);
 
   // Bulk Arrays
   static Response Size(size_t size);
   static Response Bulks(const std::vector<std::string>& bulks);
 
+  // Encoded sizes, used to reserve room for replies.
+  static size_t SizeOfInt(int64_t i);
+  static size_t SizeOfBulk(int64_t i);
+  static size_t SizeOfBulk(const char* data, size_t size);
+  static size_t SizeOfSize(size_t size);
+
   Response() {}
 
   Response(const Result& r);
 
   explicit Response(const std::string& s) : s_(s) {}
 
-  const char* data() const { return s_.data(); }
+  const char* data() const { return shared_ ? shared_->data() : s_.data(); }
+
+  size_t size() const { return shared_ ? shared_->size() : s_.size(); }
 
-  size_t size() const { return s_.size(); }
+  void Reserve(size_t size);
+
+  // Reserve room for count more elements as large as the data after mark,
+  // up to a few MB.
+  void ReserveMore(size_t mark, size_t count);
 
   bool IsOK() const;
   bool IsNull() const;
@@ -56,7 +70,7 @@ class Response {
   // Bulk Strings
   void AppendNull();
   void AppendBulk(int64_t i);
-  void AppendBulk(const std::string& bulk);
+  void AppendBulk(const Slice& bulk);
   void AppendBulk(const char* data, size_t size);
 
   // Bulk Arrays
@@ -64,6 +78,16 @@ class Response {
   void AppendBulks(const std::vector<std::string>& bulks);
 
  private:
+  explicit Response(const std::string* shared) : shared_(shared) {}
+
+  // Copy the shared buffer before appending.
+  void Unshare();
+
+  // Append prefix, integer and CRLF.
+  void AppendHeader(char prefix, int64_t i);
+
+ private:
+  const std::string* shared_ {NULL};
   std::string s_;
 };
 
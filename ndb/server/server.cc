@@ -2,36 +2,141 @@
 
 namespace ndb {
 
-Server::Server(const Options& options)
-    : options_(options), uptime_(time(NULL)) {
+class Server::Reactor : public Eventd {
+ public:
+  Reactor(Server* server, int id);
+
+  ~Reactor();
+
+  Result Run();
+
+  Channel<Client>* output() const { return output_; }
+
+  size_t connections() const { return connections_; }
+
+  uint64_t send_calls() const { return send_calls_; }
+
+  uint64_t send_bytes() const { return send_bytes_; }
+
+  uint64_t rejected_max_clients() const { return rejected_max_clients_; }
+
+  uint64_t rejected_paused() const { return rejected_paused_; }
+
+  uint64_t rejected_busy() const { return rejected_busy_; }
+
+  uint64_t dispatched_affine() const { return dispatched_affine_; }
+
+  uint64_t dispatched_shared() const { return dispatched_shared_; }
+
+  void GetStats(Stats* stats) const;
+
+ private:
+  void HandleCron() override;
+  void HandleEvent(int fd, IOLoop::Event event) override;
+  void HandleBatch() override;
+  void HandleSocket();
+  void HandleAccept(int connfd);
+  void HandleOutput();
+  void HandleClient(int fd, IOLoop::Event event);
+
+  // Send clients to workers, return the number of clients sent.
+  size_t Dispatch(std::vector<Client*>* clients);
+  // Return the index of the target input and set the quota of client.
+  size_t Route(Client* client);
+  // Callee take ownership of client rejected by workers.
+  void RejectClient(Client* client);
+
+  // Callee take ownership of client.
+  void AddClient(Client* client);
+  // Caller take ownership of client, data received by the ioloop
+  // but not passed yet are moved to unread.
+  Client* TakeClient(int fd, std::string* unread = NULL);
+  void CloseClient(int fd, const char* reason);
+
+ private:
+  Server* server_ {NULL};
+  int id_ {0};
+  Socket socket_;
+  Channel<Client>* output_ {NULL};
+  std::unique_ptr<Channel<Client>::ConsumerToken> output_token_;
+  // Affine inputs of workers, then the shared input.
+  std::vector<Channel<Client>*> targets_;
+  std::vector<Channel<Client>::ProducerToken> target_tokens_;
+  std::vector<std::vector<Client*>> batches_;
+  // Clients with requests, sent to workers after each batch of events.
+  std::vector<Client*> pending_;
+  // Clients waiting for workers to catch up.
+  std::vector<Client*> paused_;
+  std::atomic<size_t> paused_size_ {0};
+  time_t cron_time_ {0};
+  std::shared_ptr<BlockPool> pool_;
+  std::map<int, Client*> clients_;
+  std::atomic<size_t> connections_ {0};
+  std::atomic<uint64_t> send_calls_ {0};
+  std::atomic<uint64_t> send_bytes_ {0};
+  // Rejections by reason.
+  std::atomic<uint64_t> rejected_max_clients_ {0};
+  std::atomic<uint64_t> rejected_paused_ {0};
+  std::atomic<uint64_t> rejected_busy_ {0};
+  // Dispatches by target.
+  std::atomic<uint64_t> dispatched_affine_ {0};
+  std::atomic<uint64_t> dispatched_shared_ {0};
+};
+
+Server::Reactor::Reactor(Server* server, int id)
+    : server_(server), id_(id) {
+  // Workers never drop clients, make room for all of them.
+  output_ = new Channel<Client>(server_->options_.max_clients +
+                                server_->options_.channel_size);
+  output_token_.reset(new Channel<Client>::ConsumerToken(output_->NewConsumerToken()));
+  targets_ = server_->affines_;
+  targets_.push_back(server_->input_);
+  for (auto target : targets_) {
+    target_tokens_.push_back(target->NewProducerToken());
+  }
+  batches_.resize(targets_.size());
+  pool_ = std::make_shared<BlockPool>(server_->options_.block_size);
 }
 
-Server::~Server() {
-  // Call Stop() before Join() to speedup.
-  Stop();
-  worker_.Stop();
+Server::Reactor::~Reactor() {
   Join();
-  worker_.Join();
-  delete input_;
+  for (auto client : pending_) { delete client; }
+  for (auto client : paused_) { delete client; }
+  output_token_.reset();
   delete output_;
   for (auto client : clients_) { delete client.second; }
 }
 
-Result Server::Run(ClientCallback cb) {
-  // Listen socket.
-  NDB_TRY(socket_.Listen(options_.address));
-  NDB_TRY(ioloop_.Add(socket_.fd(), IOLoop::kReadable));
+Result Server::Reactor::Run() {
+  auto r = ioloop_.SetBackend(server_->options_.ioloop);
+  if (!r.ok()) {
+    NDB_LOG_ERROR("*SERVER* reactor %d ioloop %s: %s, fallback to %s",
+                  id_, server_->options_.ioloop.c_str(), r.message(), ioloop_.backend());
+  }
+
+  // Listen socket, share the address with other reactors.
+  bool reuseport = server_->options_.num_reactors > 1;
+  NDB_TRY(socket_.Listen(server_->options_.address, reuseport));
+  if (ioloop_.multishot()) {
+    NDB_TRY(ioloop_.Accept(socket_.fd()));
+  } else {
+    NDB_TRY(ioloop_.Add(socket_.fd(), IOLoop::kReadable));
+  }
 
   // Listen output.
-  input_ = new Channel<Client>(options_.channel_size);
-  output_ = new Channel<Client>(options_.channel_size);
   NDB_TRY(ioloop_.Add(output_->fd(), IOLoop::kReadable));
 
-  worker_.Run(options_.num_workers, cb, input_, output_);
   return Loop();
 }
 
-void Server::HandleCron() {
+void Server::Reactor::HandleCron() {
+  // Check timeouts once a second.
+  auto now = time(NULL);
+  if (now == cron_time_) {
+    return;
+  }
+  cron_time_ = now;
+
   std::vector<int> timeouts;
   for (auto client : clients_) {
     if (client.second->HasTimeout()) {
@@ -43,8 +148,10 @@ void Server::HandleCron() {
   }
 }
 
-void Server::HandleEvent(int fd, IOLoop::Event event) {
-  if (fd == socket_.fd()) {
+void Server::Reactor::HandleEvent(int fd, IOLoop::Event event) {
+  if (IOLoop::Accepted(event)) {
+    HandleAccept(fd);
+  } else if (fd == socket_.fd()) {
     HandleSocket();
   } else if (fd == output_->fd()) {
     HandleOutput();
@@ -53,42 +160,73 @@ void Server::HandleEvent(int fd, IOLoop::Event event) {
   }
 }
 
-void Server::HandleSocket() {
+void Server::Reactor::HandleSocket() {
   int connfd = -1;
   auto r = socket_.Accept(&connfd);
   if (!r.ok()) {
     NDB_LOG_ERROR("*SERVER* accept: %s", r.message());
     return;
   }
+  if (connfd == -1) {
+    // Another reactor may take the connection.
+    return;
+  }
+  HandleAccept(connfd);
+}
 
+void Server::Reactor::HandleAccept(int connfd) {
   auto client = new Client(connfd);
-  NDB_LOG_INFO("*SERVER* accept client %s", client->name());
+  NDB_LOG_INFO("*SERVER* reactor %d accept client %s", id_, client->name());
 
-  if (clients_.size() >= (size_t) options_.max_clients) {
-    NDB_LOG_ERROR("*SERVER* client limit exceed %d", options_.max_clients);
+  if (server_->GetConnections() >= (size_t) server_->options_.max_clients) {
+    NDB_LOG_ERROR("*SERVER* client limit exceed %d", server_->options_.max_clients);
+    rejected_max_clients_++;
     delete client;
     return;
   }
 
+  client->set_reactor(id_);
+  client->set_pool(pool_);
   AddClient(client);
 }
 
-void Server::HandleOutput() {
+void Server::Reactor::HandleOutput() {
+  Client* clients[64];
   while (true) {
-    auto client = output_->Recv();
-    if (client == NULL) {
+    auto n = output_->RecvBulk(clients, 64, output_token_.get());
+    if (n == 0) {
       break;
     }
-    AddClient(client);
+    for (size_t i = 0; i < n; i++) {
+      if (clients[i]->HasRequest()) {
+        // Requests left by the quota.
+        pending_.push_back(clients[i]);
+      } else {
+        AddClient(clients[i]);
+      }
+    }
   }
 }
 
-void Server::HandleClient(int fd, IOLoop::Event event) {
+void Server::Reactor::HandleClient(int fd, IOLoop::Event event) {
   auto client = clients_[fd];
-  auto r = client->HandleEvent(event);
+  auto r = client->HandleEvent(event, ioloop_.received());
+  uint64_t calls = 0, bytes = 0;
+  client->TakeSendStats(&calls, &bytes);
+  send_calls_ += calls;
+  send_bytes_ += bytes;
   if (r.ok()) {
     if (client->HasRequest()) {
-      input_->Send(TakeClient(fd));
+      // Requests received after go with the client.
+      std::string unread;
+      TakeClient(fd, &unread);
+      r = client->HandleEvent(IOLoop::kReceived, unread);
+      if (!r.ok()) {
+        NDB_LOG_INFO("*SERVER* close client %s: %s", client->name(), r.message());
+        delete client;
+        return;
+      }
+      pending_.push_back(client);
       return;
     }
     if (client->HasResponse()) {
@@ -102,16 +240,102 @@ void Server::HandleClient(int fd, IOLoop::Event event) {
   }
 }
 
-void Server::AddClient(Client* client) {
+void Server::Reactor::HandleBatch() {
+  // Paused clients go first, new clients wait behind them.
+  Dispatch(&paused_);
+  if (paused_.empty()) {
+    Dispatch(&pending_);
+  }
+  for (auto client : pending_) {
+    RejectClient(client);
+  }
+  pending_.clear();
+
+  // Retry paused clients soon.
+  paused_size_ = paused_.size();
+  timeout_ = milliseconds(paused_.empty() ? 1000 : 1);
+}
+
+size_t Server::Reactor::Dispatch(std::vector<Client*>* clients) {
+  if (clients->empty()) {
+    return 0;
+  }
+
+  for (auto client : *clients) {
+    batches_[Route(client)].push_back(client);
+  }
+
+  size_t sent = 0;
+  clients->clear();
+  for (size_t i = 0; i < batches_.size(); i++) {
+    auto& batch = batches_[i];
+    if (batch.empty()) {
+      continue;
+    }
+    auto n = targets_[i]->SendBulk(&batch[0], batch.size(), &target_tokens_[i]);
+    if (i + 1 == batches_.size()) {
+      dispatched_shared_ += n;
+    } else {
+      dispatched_affine_ += n;
+    }
+    clients->insert(clients->end(), batch.begin() + n, batch.end());
+    sent += n;
+    batch.clear();
+  }
+  return sent;
+}
+
+size_t Server::Reactor::Route(Client* client) {
+  size_t shared = targets_.size() - 1;
+  client->set_quota(SIZE_MAX);
+  if (shared == 0) {
+    return shared;
+  }
+
+  // Requests without a single key follow the requests before them,
+  // stop at the first request with another target.
+  size_t target = shared, quota = 0;
+  for (const auto& request : client->requests()) {
+    uint64_t hash = 0;
+    if (server_->hash_(request, &hash)) {
+      if (target == shared) {
+        target = hash % shared;
+      } else if (target != hash % shared) {
+        break;
+      }
+    }
+    quota++;
+  }
+  client->set_quota(quota);
+  return target;
+}
+
+void Server::Reactor::RejectClient(Client* client) {
+  if (server_->options_.overload_policy == "busy") {
+    rejected_busy_++;
+    while (client->HasRequest()) {
+      client->PopRequest();
+      client->PutResponse(Response::Busy());
+    }
+    AddClient(client);
+  } else {
+    // Stop reading from the client until workers catch up.
+    rejected_paused_++;
+    paused_.push_back(client);
+  }
+}
+
+void Server::Reactor::AddClient(Client* client) {
   int fd = client->fd();
-  client->set_bufsize(options_.buffer_size);
-  client->set_timeout(seconds(options_.timeout_secs));
+  client->set_bufsize(server_->options_.buffer_size);
+  client->set_timeout(seconds(server_->options_.timeout_secs));
 
+  auto event = client->HasResponse() ? IOLoop::kWritable : IOLoop::kReadable;
   Result r;
-  if (client->HasResponse()) {
-    r = ioloop_.Add(fd, IOLoop::kWritable);
+  if (ioloop_.multishot()) {
+    r = ioloop_.Recv(fd, event);
   } else {
-    r = ioloop_.Add(fd, IOLoop::kReadable);
+    r = ioloop_.Add(fd, event);
   }
   if (!r.ok()) {
     NDB_LOG_ERROR("*SERVER* add client %s: %s", client->name(), r.message());
@@ -120,29 +344,151 @@ void Server::AddClient(Client* client) {
   }
 
   clients_[fd] = client;
+  connections_ = clients_.size();
 }
 
-Client* Server::TakeClient(int fd) {
+Client* Server::Reactor::TakeClient(int fd, std::string* unread) {
   auto client = clients_[fd];
   clients_.erase(fd);
-  ioloop_.Del(fd);
+  connections_ = clients_.size();
+  ioloop_.Del(fd, unread);
   return client;
 }
 
-void Server::CloseClient(int fd, const char* reason) {
+void Server::Reactor::CloseClient(int fd, const char* reason) {
   auto client = TakeClient(fd);
   NDB_LOG_INFO("*SERVER* close client %s: %s", client->name(), reason);
   delete client;
 }
 
+void Server::Reactor::GetStats(Stats* stats) const {
+  auto prefix = "reactor_" + std::to_string(id_) + "_";
+  stats->insert(prefix + "ioloop", ioloop_.backend());
+  stats->insert(prefix + "ioloop_multishot", ioloop_.multishot() ? 1 : 0);
+  stats->insert(prefix + "connections", connections());
+  stats->insert(prefix + "responses", output_->size());
+  stats->insert(prefix + "paused_clients", paused_size_.load());
+  stats->insert(prefix + "used_blocks", pool_->used());
+  stats->insert(prefix + "unused_blocks", pool_->unused());
+}
+
+Server::Server(const Options& options)
+    : options_(options), uptime_(time(NULL)) {
+}
+
+Server::~Server() {
+  // Call Stop() before Join() to speedup.
+  for (auto reactor : reactors_) { reactor->Stop(); }
+  worker_.Stop();
+  for (auto reactor : reactors_) { reactor->Join(); }
+  worker_.Join();
+  for (auto reactor : reactors_) { delete reactor; }
+  for (auto affine : affines_) { delete affine; }
+  delete input_;
+}
+
+Result Server::Run(ClientCallback cb, RequestHash hash) {
+  if (options_.overload_policy != "pause" && options_.overload_policy != "busy") {
+    return Result::Error("Invalid overload policy %s", options_.overload_policy.c_str());
+  }
+  if (options_.dispatch_mode != "shared" && options_.dispatch_mode != "key") {
+    return Result::Error("Invalid dispatch mode %s", options_.dispatch_mode.c_str());
+  }
+
+  input_ = new Channel<Client>(options_.channel_size);
+
+  // Each worker gets its own input for requests routed by key.
+  if (options_.dispatch_mode == "key" && hash) {
+    hash_ = hash;
+    for (int i = 0; i < options_.num_workers; i++) {
+      affines_.push_back(new Channel<Client>(options_.channel_size));
+    }
+  }
+
+  // Clients are sent back to the reactor they belong to.
+  std::vector<Channel<Client>*> outputs;
+  for (int i = 0; i < std::max(options_.num_reactors, 1); i++) {
+    reactors_.push_back(new Reactor(this, i));
+    outputs.push_back(reactors_.back()->output());
+  }
+
+  NDB_TRY(worker_.Run(options_.num_workers, cb, input_, affines_, outputs));
+  for (auto reactor : reactors_) {
+    NDB_TRY(reactor->Run());
+  }
+  return Result::OK();
+}
+
+size_t Server::GetConnections() const {
+  size_t connections = 0;
+  for (auto reactor : reactors_) {
+    connections += reactor->connections();
+  }
+  return connections;
+}
+
 Stats Server::GetStats() const {
   Stats stats;
   stats.insert("pid", getpid());
   stats.insert("uptime", time(NULL) - uptime_);
   stats.insert("address", options_.address);
-  stats.insert("requests", input_->size());
-  stats.insert("responses", output_->size());
-  stats.insert("connections", clients_.size());
+  stats.insert("reactors", reactors_.size());
+  size_t requests = input_->size();
+  for (auto affine : affines_) {
+    requests += affine->size();
+  }
+  stats.insert("requests", requests);
+  size_t responses = 0;
+  for (auto reactor : reactors_) {
+    responses += reactor->output()->size();
+  }
+  stats.insert("responses", responses);
+  // Channel wakeups, less than one per item if coalesced.
+  uint64_t wakeups = input_->wakeups(), items = input_->items();
+  for (auto affine : affines_) {
+    wakeups += affine->wakeups();
+    items += affine->items();
+  }
+  for (auto reactor : reactors_) {
+    wakeups += reactor->output()->wakeups();
+    items += reactor->output()->items();
+  }
+  char wakeups_per_item[32];
+  snprintf(wakeups_per_item, sizeof(wakeups_per_item), "%.3f",
+           items ? (double) wakeups / items : 0.0);
+  stats.insert("channel_wakeups", wakeups);
+  stats.insert("channel_items", items);
+  stats.insert("channel_wakeups_per_item", std::string(wakeups_per_item));
+  stats.insert("connections", GetConnections());
+  uint64_t send_calls = 0, send_bytes = 0;
+  for (auto reactor : reactors_) {
+    send_calls += reactor->send_calls();
+    send_bytes += reactor->send_bytes();
+  }
+  stats.insert("send_calls", send_calls);
+  stats.insert("send_bytes", send_bytes);
+  stats.insert("send_bytes_per_call", send_calls ? send_bytes / send_calls : 0);
+  uint64_t rejected_max_clients = 0, rejected_paused = 0, rejected_busy = 0;
+  for (auto reactor : reactors_) {
+    rejected_max_clients += reactor->rejected_max_clients();
+    rejected_paused += reactor->rejected_paused();
+    rejected_busy += reactor->rejected_busy();
+  }
+  stats.insert("rejected_max_clients", rejected_max_clients);
+  stats.insert("rejected_paused", rejected_paused);
+  stats.insert("rejected_busy", rejected_busy);
+  stats.insert("output_retries", worker_.output_retries());
+  uint64_t dispatched_affine = 0, dispatched_shared = 0;
+  for (auto reactor : reactors_) {
+    dispatched_affine += reactor->dispatched_affine();
+    dispatched_shared += reactor->dispatched_shared();
+  }
+  stats.insert("dispatch_mode", options_.dispatch_mode);
+  stats.insert("dispatched_affine", dispatched_affine);
+  stats.insert("dispatched_shared", dispatched_shared);
+  for (auto reactor : reactors_) {
+    reactor->GetStats(&stats);
+  }
   return stats;
 }
 
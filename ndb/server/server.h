@@ -7,46 +7,52 @@
 
 namespace ndb {
 
-class Server : public Eventd {
+class Server {
  public:
   struct Options {
     std::string address {"0.0.0.0:9736"};
+    int num_reactors {4};
+    // Backend of reactors, "epoll" or "io_uring".
+    std::string ioloop {"epoll"};
     int num_workers {32};
     int max_clients {8192};
     int timeout_secs {60};
     size_t buffer_size {16 << 20};
+    size_t block_size {64 << 10};
     size_t channel_size {4096};
+    // What to do with requests when workers are saturated:
+    // "pause" stops reading until workers catch up,
+    // "busy" replies -BUSY to the requests.
+    std::string overload_policy {"pause"};
+    // How requests are dispatched to workers:
+    // "shared" puts all requests in one queue,
+    // "key" routes requests with one key to a worker by hash of the key.
+    std::string dispatch_mode {"shared"};
   };
 
   Server(const Options& options);
 
   ~Server();
 
-  Result Run(ClientCallback cb);
+  // Requests are routed by hash in the "key" dispatch mode.
+  Result Run(ClientCallback cb, RequestHash hash = RequestHash());
 
   Stats GetStats() const;
 
  private:
-  void HandleCron() override;
-  void HandleEvent(int fd, IOLoop::Event event) override;
-  void HandleSocket();
-  void HandleOutput();
-  void HandleClient(int fd, IOLoop::Event event);
-
-  // Callee take ownership of client.
-  void AddClient(Client* client);
-  // Caller take ownership of client.
-  Client* TakeClient(int fd);
-  void CloseClient(int fd, const char* reason);
+  // Each reactor runs its own ioloop with a listen socket and clients.
+  class Reactor;
+
+  size_t GetConnections() const;
 
  private:
   Options options_;
   time_t uptime_;
-  Socket socket_;
   Worker worker_;
   Channel<Client>* input_ {NULL};
-  Channel<Client>* output_ {NULL};
-  std::map<int, Client*> clients_;
+  std::vector<Channel<Client>*> affines_;
+  RequestHash hash_;
+  std::vector<Reactor*> reactors_;
 };
 
 }  // namespace ndb
@@ -1,62 +1,157 @@
 #include "ndb/server/worker.h"
 
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
 namespace ndb {
 
 class Processor : public Thread {
  public:
+  // Clients taken per wakeup, the rest are left to other processors.
+  static const size_t kBatchSize = 8;
+
   Processor(int epfd,
             ClientCallback cb,
             Channel<Client>* input,
-            Channel<Client>* output)
-      : epfd_(epfd), cb_(cb), input_(input), output_(output) {
+            Channel<Client>* affine,
+            const std::vector<Channel<Client>*>& outputs,
+            std::atomic<uint64_t>* output_retries)
+      : epfd_(epfd), cb_(cb), input_(input), affine_(affine), outputs_(outputs),
+        output_retries_(output_retries),
+        input_token_(input->NewConsumerToken()),
+        pending_(outputs.size()) {
+    if (affine_ != NULL) {
+      affine_token_.reset(new Channel<Client>::ConsumerToken(affine_->NewConsumerToken()));
+    }
+    for (auto output : outputs_) {
+      output_tokens_.push_back(output->NewProducerToken());
+    }
   }
 
   void Main() override;
 
+ private:
+  // Process a batch of clients, return the number of clients.
+  size_t Process(Channel<Client>* input, Channel<Client>::ConsumerToken* token);
+  void Send(size_t i);
+
  private:
   int epfd_ {-1};
   ClientCallback cb_;
   Channel<Client>* input_ {NULL};
-  Channel<Client>* output_ {NULL};
+  Channel<Client>* affine_ {NULL};
+  std::vector<Channel<Client>*> outputs_;
+  std::atomic<uint64_t>* output_retries_ {NULL};
+  Channel<Client>::ConsumerToken input_token_;
+  std::unique_ptr<Channel<Client>::ConsumerToken> affine_token_;
+  std::vector<Channel<Client>::ProducerToken> output_tokens_;
+  // Clients to send back, indexed by reactor.
+  std::vector<std::vector<Client*>> pending_;
 };
 
 void Processor::Main() {
   epoll_event e = {0};
   epoll_wait(epfd_, &e, 1, 1000);
   while (true) {
-    auto client = input_->Recv();
-    if (client == NULL) {
+    // Clients routed to this processor go first.
+    size_t n = 0;
+    if (affine_ != NULL) {
+      n += Process(affine_, affine_token_.get());
+    }
+    n += Process(input_, &input_token_);
+    if (n == 0) {
       break;
     }
-    client = cb_(client);
+  }
+}
+
+size_t Processor::Process(Channel<Client>* input, Channel<Client>::ConsumerToken* token) {
+  Client* clients[kBatchSize];
+  auto n = input->RecvBulk(clients, kBatchSize, token);
+  if (n == 0) {
+    return 0;
+  }
+  if (input == input_ && input_->size() > 0) {
+    input_->Notify();
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    auto client = cb_(clients[i]);
     if (client == NULL) {
       continue;
     }
-    output_->Send(client);
+    pending_[client->reactor()].push_back(client);
   }
-}
 
+  for (size_t i = 0; i < pending_.size(); i++) {
+    Send(i);
+  }
+  return n;
+}
 
-Result Worker::Run(int num_threads,
-                   ClientCallback cb,
-                   Channel<Client>* input,
-                   Channel<Client>* output) {
-  epfd_ = epoll_create(1024);
-  if (epfd_ == -1) {
-    return Result::Errno("epoll_create()");
+void Processor::Send(size_t i) {
+  // Outputs are sized to hold all clients, retry if that is not enough
+  // rather than dropping clients.
+  auto& pending = pending_[i];
+  size_t sent = 0;
+  while (sent < pending.size()) {
+    sent += outputs_[i]->SendBulk(&pending[sent], pending.size() - sent, &output_tokens_[i]);
+    if (sent < pending.size()) {
+      (*output_retries_)++;
+      std::this_thread::yield();
+    }
   }
+  pending.clear();
+}
 
-  // Use edge-triggered mode here to wakeup just one thread at a time.
+static Result AddChannel(int epfd, int fd, uint32_t events) {
   epoll_event e = {0};
-  e.data.fd = input->fd();
-  e.events = EPOLLIN | EPOLLET;
-  if (epoll_ctl(epfd_, EPOLL_CTL_ADD, e.data.fd, &e) == -1) {
+  e.data.fd = fd;
+  e.events = events;
+  if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &e) == -1) {
     return Result::Errno("epoll_ctl()");
   }
+  return Result::OK();
+}
+
+Worker::~Worker() {
+  for (auto thread : threads_) delete thread;
+  for (auto epfd : epfds_) close(epfd);
+}
+
+Result Worker::Run(int num_threads,
+                   ClientCallback cb,
+                   Channel<Client>* input,
+                   const std::vector<Channel<Client>*>& affines,
+                   const std::vector<Channel<Client>*>& outputs) {
+  if (!affines.empty() && affines.size() != (size_t) num_threads) {
+    return Result::Error("Invalid number of affine inputs %zu", affines.size());
+  }
 
-  // All threads share the same epoll and io channel.
   for (int i = 0; i < num_threads; i++) {
-    threads_.push_back(new Processor(epfd_, cb, input, output));
+    if (affines.empty() && !epfds_.empty()) {
+      // All threads share the same epoll and input.
+      threads_.push_back(new Processor(epfds_[0], cb, input, NULL, outputs, &output_retries_));
+      NDB_TRY(threads_.back()->Loop());
+      continue;
+    }
+
+    int epfd = epoll_create(1024);
+    if (epfd == -1) {
+      return Result::Errno("epoll_create()");
+    }
+    epfds_.push_back(epfd);
+
+    // Use edge-triggered mode here to wakeup just one thread at a time.
+    if (affines.empty()) {
+      NDB_TRY(AddChannel(epfd, input->fd(), EPOLLIN | EPOLLET));
+      threads_.push_back(new Processor(epfd, cb, input, NULL, outputs, &output_retries_));
+    } else {
+      NDB_TRY(AddChannel(epfd, affines[i]->fd(), EPOLLIN | EPOLLET));
+      NDB_TRY(AddChannel(epfd, input->fd(), EPOLLIN | EPOLLET | EPOLLEXCLUSIVE));
+      threads_.push_back(new Processor(epfd, cb, input, affines[i], outputs, &output_retries_));
+    }
     NDB_TRY(threads_.back()->Loop());
   }
 
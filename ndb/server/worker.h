@@ -10,21 +10,32 @@ namespace ndb {
 // Return NULL if callee take ownership of client.
 typedef std::function<Client* (Client*)> ClientCallback;
 
+// Set *hash and return true if the request can be routed by hash.
+typedef std::function<bool (const Request&, uint64_t* hash)> RequestHash;
+
 class Worker {
  public:
+  // Threads share the input, and each thread also takes clients from
+  // its own affine input if affines are given.
+  // Clients are sent to the output indexed by their reactor.
   Result Run(int num_threads,
              ClientCallback cb,
              Channel<Client>* input,
-             Channel<Client>* output);
+             const std::vector<Channel<Client>*>& affines,
+             const std::vector<Channel<Client>*>& outputs);
 
-  ~Worker()   { for (auto thread : threads_) delete thread; }
+  ~Worker();
 
   void Stop() { for (auto thread : threads_) thread->Stop(); }
 
   void Join() { for (auto thread : threads_) thread->Join(); }
 
+  // Number of times an output is full and the send is retried.
+  uint64_t output_retries() const { return output_retries_; }
+
  private:
-  int epfd_ {-1};
+  std::vector<int> epfds_;
+  std::atomic<uint64_t> output_retries_ {0};
   std::vector<Thread*> threads_;
 };
 
@@ -0,0 +1,99 @@
+#include "ndb/ndb.h"
+
+namespace ndb {
+
+Result Expirer::Run() {
+  if (options_.expire_rate == 0) {
+    return Result::OK();
+  }
+  return Loop();
+}
+
+void Expirer::HandleCron() {
+  // Spread the rate over crons.
+  size_t budget = std::max<size_t>(options_.expire_rate * kCronMillis / 1000, 1);
+  while (budget > 0) {
+    auto limit = std::min(budget, options_.batch_size);
+    size_t scanned = 0;
+    auto r = ExpireBatch(limit, &scanned);
+    if (!r.ok()) {
+      NDB_LOG_ERROR("*EXPIRER* expire: %s", r.message());
+      return;
+    }
+    if (scanned < limit) {
+      // No more due keys.
+      return;
+    }
+    budget -= scanned;
+  }
+}
+
+Result Expirer::ExpireBatch(size_t limit, size_t* scanned) {
+  auto db = engine_->GetRocksDB();
+  auto index = engine_->GetExpireIndex();
+
+  // Due keys are those expired before now.
+  std::string upper;
+  EncodeUint64(&upper, getmstime());
+  Slice upper_bound(upper);
+  rocksdb::ReadOptions ropts;
+  ropts.iterate_upper_bound = &upper_bound;
+  std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(ropts, index));
+
+  // Index entries are removed whether the keys are expired or not,
+  // keys updated with new expires have been indexed again.
+  rocksdb::WriteBatch batch;
+  for (it->SeekToFirst(); it->Valid() && *scanned < limit; it->Next()) {
+    (*scanned)++;
+    batch.Delete(index, it->key());
+
+    Slice id = it->key(), nsname;
+    uint64_t expire = 0;
+    if (!DecodeExpireKey(&id, &expire, &nsname)) {
+      continue;
+    }
+    auto ns = engine_->GetNamespace(nsname.ToString());
+    if (ns == NULL) {
+      // Namespace has been dropped.
+      continue;
+    }
+    auto r = ExpireKey(ns, id);
+    if (r.ok()) {
+      expired_keys_++;
+    } else if (!r.IsNotFound()) {
+      // Leave the key to the compaction filter.
+      NDB_LOG_ERROR("*EXPIRER* expire key [%s]: %s",
+                    ns->GetName().c_str(), r.message());
+    }
+  }
+  if (!it->status().ok()) {
+    return StatusToResult(it->status());
+  }
+
+  scanned_keys_ += *scanned;
+  if (batch.Count() == 0) {
+    return Result::OK();
+  }
+  return engine_->Write(&batch);
+}
+
+Result Expirer::ExpireKey(NSRef ns, const Slice& id) {
+  auto keys = FormatNamespace(ns->GetName(), id);
+  AutoLock lock(hashlock_->GetLock(std::vector<Slice>(keys.begin(), keys.end())));
+  uint64_t version = 0, cid = 0;
+  NDB_TRY(ns->Expire(id, &version, &cid));
+  if (IsMetaKey(id)) {
+    lazyfree_->Free(ns, id, version, cid);
+  }
+  return Result::OK();
+}
+
+Stats Expirer::GetStats() const {
+  Stats stats;
+  stats.insert("expire_rate", options_.expire_rate);
+  stats.insert("scanned_keys", scanned_keys_.load());
+  stats.insert("expired_keys", expired_keys_.load());
+  return stats;
+}
+
+}  // namespace ndb
@@ -0,0 +1,51 @@
+#ifndef NDB_THREAD_EXPIRER_H_
+#define NDB_THREAD_EXPIRER_H_
+
+#include "ndb/common/common.h"
+
+namespace ndb {
+
+// Delete keys which have expired by scanning the expire index,
+// instead of waiting for compactions to drop them.
+class Expirer : public Eventd {
+ public:
+  struct Options {
+    // Max keys expired per second, 0 to disable active expiry.
+    size_t expire_rate {10000};
+    // Max keys expired per batch.
+    size_t batch_size {100};
+  };
+
+  Expirer(const Options& options, Engine* engine,
+          HashLock* hashlock, LazyFree* lazyfree)
+      : options_(options), engine_(engine),
+        hashlock_(hashlock), lazyfree_(lazyfree) {
+    timeout_ = milliseconds(kCronMillis);
+  }
+
+  Result Run();
+
+  Stats GetStats() const;
+
+ private:
+  void HandleCron() override;
+
+  // Expire due keys in at most limit index entries.
+  Result ExpireBatch(size_t limit, size_t* scanned);
+
+  Result ExpireKey(NSRef ns, const Slice& id);
+
+ private:
+  static const int kCronMillis = 100;
+
+  Options options_;
+  Engine* engine_ {NULL};
+  HashLock* hashlock_ {NULL};
+  LazyFree* lazyfree_ {NULL};
+  std::atomic<uint64_t> scanned_keys_ {0};
+  std::atomic<uint64_t> expired_keys_ {0};
+};
+
+}  // namespace ndb
+
+#endif /* NDB_THREAD_EXPIRER_H_ */
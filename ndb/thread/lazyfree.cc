@@ -0,0 +1,59 @@
+#include "ndb/ndb.h"
+
+namespace ndb {
+
+Result LazyFree::Run() {
+  running_ = true;
+  return Loop();
+}
+
+void LazyFree::Free(NSRef ns, const Slice& kmeta, uint64_t version, uint64_t cid) {
+  if (!running_) return;
+  std::unique_lock<std::mutex> lock(lock_);
+  if (tasks_.size() >= options_.max_pending) {
+    dropped_versions_++;
+    return;
+  }
+  tasks_.push_back({ns, kmeta.ToString(), version, cid});
+}
+
+void LazyFree::HandleCron() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    auto r = FreeVersion(task.ns, task.kmeta, task.version, task.cid);
+    if (!r.ok()) {
+      NDB_LOG_ERROR("*LAZYFREE* free [%s] version %llu: %s",
+                    task.ns->GetName().c_str(),
+                    (unsigned long long) task.version,
+                    r.message());
+      continue;
+    }
+    freed_versions_++;
+  }
+}
+
+Result LazyFree::FreeVersion(NSRef ns, const Slice& kmeta, uint64_t version, uint64_t cid) {
+  // Lock the collection like commands, so it is not created again meanwhile.
+  auto keys = FormatNamespace(ns->GetName(), kmeta);
+  AutoLock lock(hashlock_->GetLock(std::vector<Slice>(keys.begin(), keys.end())));
+  return ns->DeleteVersion(kmeta, version, cid);
+}
+
+Stats LazyFree::GetStats() const {
+  Stats stats;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    stats.insert("pending_versions", tasks_.size());
+  }
+  stats.insert("freed_versions", freed_versions_.load());
+  stats.insert("dropped_versions", dropped_versions_.load());
+  return stats;
+}
+
+}  // namespace ndb
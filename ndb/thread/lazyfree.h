@@ -0,0 +1,55 @@
+#ifndef NDB_THREAD_LAZYFREE_H_
+#define NDB_THREAD_LAZYFREE_H_
+
+#include "ndb/common/common.h"
+
+namespace ndb {
+
+// Delete members of dropped collection versions with range deletions
+// in the background, instead of waiting for compactions to filter them
+// one by one. Pending versions are lost on restart and left to compactions.
+class LazyFree : public Eventd {
+ public:
+  struct Options {
+    // Max pending versions, versions beyond are left to compactions.
+    size_t max_pending {100000};
+  };
+
+  LazyFree(const Options& options, HashLock* hashlock)
+      : options_(options), hashlock_(hashlock) {
+    timeout_ = milliseconds(100);
+  }
+
+  Result Run();
+
+  // Free members of the collection of kmeta at version, or of cid if the
+  // collection has one.
+  void Free(NSRef ns, const Slice& kmeta, uint64_t version, uint64_t cid);
+
+  Stats GetStats() const;
+
+ private:
+  void HandleCron() override;
+
+  Result FreeVersion(NSRef ns, const Slice& kmeta, uint64_t version, uint64_t cid);
+
+ private:
+  struct Task {
+    NSRef ns;
+    std::string kmeta;
+    uint64_t version;
+    uint64_t cid;
+  };
+
+  Options options_;
+  HashLock* hashlock_ {NULL};
+  bool running_ {false};
+  mutable std::mutex lock_;
+  std::deque<Task> tasks_;
+  std::atomic<uint64_t> freed_versions_ {0};
+  std::atomic<uint64_t> dropped_versions_ {0};
+};
+
+}  // namespace ndb
+
+#endif /* NDB_THREAD_LAZYFREE_H_ */
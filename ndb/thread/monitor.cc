@@ -40,11 +40,15 @@ void Monitor::PutRequest(const Client* client) {
   const auto& request = client->GetRequest();
   for (size_t i = 0; i < request.argc(); i++) {
     s.append(" \"");
-    s.append(request.args(i));
+    s.append(request.args(i).data(), request.args(i).size());
     s.append("\"");
   }
   s.append("\r\n");
-  channel_.Send(new Response(s));
+  auto response = new Response(s);
+  if (!channel_.Send(response)) {
+    // Drop the line if monitors fall behind.
+    delete response;
+  }
 }
 
 void Monitor::HandleEvent(int fd, IOLoop::Event event) {
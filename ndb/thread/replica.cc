@@ -92,10 +92,26 @@ Result Replica::ProcessUpdates() {
     }
     auto size = request.argc();
     for (size_t i = 1; i < size; i++) {
-      rocksdb::WriteOptions wopts;
-      rocksdb::WriteBatch batch(request.args(i));
-      auto s = engine_->GetRocksDB()->Write(wopts, &batch);
-      if (!s.ok()) return StatusToResult(s);
+      const auto& data = request.args(i);
+      // Batches start with their fixed64 sequences on the master.
+      if (data.size() < 8) {
+        return Result::Error("Invalid batch size: %zu", data.size());
+      }
+      uint64_t sequence = 0;
+      for (int j = 7; j >= 0; j--) {
+        sequence = (sequence << 8) | static_cast<uint8_t>(data[j]);
+      }
+      // Sequences of writes without WAL on the master are skipped, so both
+      // sides keep the same sequences, which PSYNC resumes from.
+      auto next = GetLatestSequenceNumber() + 1;
+      if (sequence < next) {
+        return Result::Error("sequence unmatch: master=%llu local=%llu",
+                             (unsigned long long) sequence,
+                             (unsigned long long) next);
+      }
+      NDB_TRY(engine_->SkipSequences(sequence - next));
+      rocksdb::WriteBatch batch(data.ToString());
+      NDB_TRY(engine_->Write(&batch));
     }
 
     if (size > 1) {
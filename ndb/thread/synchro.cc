@@ -51,14 +51,17 @@ Response Synchro::Replica::CommandPSYNC(const Request& request) {
   std::vector<std::string> updates {"UPDATES"};
   for (it_->Seek(sequence); it_->Valid(); it_->Next()) {
     auto batch = it_->batch();
-    if (batch.sequence != sequence) {
+    // Writes without WAL, e.g. of namespaces of durability nowal, leave gaps
+    // in sequences. Replicas skip gaps, but not WAL that has been purged.
+    if (batch.sequence < sequence ||
+        (batch.sequence > sequence && !it_->Kept(sequence))) {
       return Result::Error("sequence unmatch: local=%llu request=%llu",
                            (unsigned long long) batch.sequence,
                            (unsigned long long) sequence);
     }
 
     updates.push_back(batch.writeBatchPtr->Data());
-    sequence += batch.writeBatchPtr->Count();
+    sequence = batch.sequence + batch.writeBatchPtr->Count();
     if (limit > 0 && updates.size() > limit) {
       break;
     }
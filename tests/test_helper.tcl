@@ -16,6 +16,7 @@ set ::all_tests {
     unit/expire
     unit/keyspace
     unit/namespace
+    unit/replication
     unit/type/string
     unit/type/incr
     unit/type/list
@@ -172,4 +172,16 @@ start_server {tags {"expire"}} {
         set v5 [r zrange x 0 -1]
         list $v1 $v2 $v3 $v4 $v5
     } {-2 -1 1 0 [2]}
+
+    test {EXPIRE - expired keys are deleted actively} {
+        regexp {expired_keys:(\d+)} [r info expirer] _ n1
+        r set x foo
+        r pexpire x 100
+        wait_for_condition 50 100 {
+            [regexp {expired_keys:(\d+)} [r info expirer] _ n2] && $n2 > $n1
+        } else {
+            fail "Key is not expired actively"
+        }
+        r exists x
+    } {0}
 }
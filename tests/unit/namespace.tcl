@@ -58,6 +58,63 @@ start_server {tags {"namespace"}} {
         list $a $b $c $err
     } {min max min {ERR*}}
 
+    test {NSSET set namespace column family options} {
+        r nsnew ns
+        r nsset ns block_size 16384
+        r nsset ns bloom_bits 16
+        r nsset ns memtable_size 67108864
+        r nsset ns data_block_hash_index 1
+        r nsset ns compression none,lz4,zstd
+        r nsset ns cache_priority high
+        set a [list [r nsget ns block_size] [r nsget ns bloom_bits] \
+                    [r nsget ns memtable_size] [r nsget ns data_block_hash_index] \
+                    [r nsget ns compression] [r nsget ns cache_priority]]
+        catch {r nsset ns compression none,foo} err1
+        catch {r nsset ns cache_priority foo} err2
+        r nsdel ns
+        list $a $err1 $err2
+    } {{16384 16 67108864 1 none,lz4,zstd high} {ERR*} {ERR*}}
+
+    test {NSSET set namespace value cache} {
+        r nsnew ns
+        r nsset ns value_cache_size 1048576
+        r set ns:a 1
+        set a [list [r nsget ns value_cache_size] [r get ns:a] [r get ns:a]]
+        r set ns:a 2
+        lappend a [r get ns:a] [r mget ns:a ns:b]
+        r del ns:a
+        lappend a [r get ns:a]
+        r nsset ns value_cache_size 0
+        r set ns:a 3
+        lappend a [r get ns:a]
+        r nsdel ns
+        set a
+    } {1048576 1 1 2 {2 {}} {} 3}
+
+    test {NSSET set namespace durability} {
+        r nsnew ns
+        set a [r nsget ns durability]
+        r nsset ns durability sync
+        r set ns:a 1
+        lappend a [r nsget ns durability] [r get ns:a]
+        r nsset ns durability nowal
+        r set ns:a 2
+        lappend a [r nsget ns durability] [r get ns:a]
+        catch {r nsset ns durability foo} err
+        r nsdel ns
+        lappend a $err
+    } {normal sync 1 nowal 2 {ERR*}}
+
+    test {NSSET set namespace packed configs} {
+        r nsnew ns
+        set a [list [r nsget ns packed_entries] [r nsget ns packed_value_size]]
+        r nsset ns packed_entries 32
+        r nsset ns packed_value_size 128
+        lappend a [r nsget ns packed_entries] [r nsget ns packed_value_size]
+        r nsdel ns
+        set a
+    } {0 64 32 128}
+
     test {NSSET set invalid config} {
         r nsnew ns
         catch {r nsset ns invalid 123} err
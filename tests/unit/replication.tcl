@@ -0,0 +1,43 @@
+start_server {tags {"replication"}} {
+    set master [srv 0 client]
+    set master_host [srv 0 host]
+    set master_port [srv 0 port]
+
+    start_server [list overrides [list replica.address "$master_host:$master_port"]] {
+        set slave [srv 0 client]
+        # Namespaces are created in the same order on both sides,
+        # so their column families have the same ids.
+        foreach r [list $slave $master] {
+            $r nsnew nowal
+            $r nsnew normal
+        }
+
+        test {Writes without WAL don't stop replication} {
+            $master set normal:a 1
+            $master nsset nowal durability nowal
+            for {set i 0} {$i < 100} {incr i} {
+                $master set nowal:$i $i
+            }
+            $master set normal:b 2
+            wait_for_condition 50 100 {
+                [$slave get normal:b] eq 2
+            } else {
+                fail "Writes after writes without WAL are not replicated"
+            }
+            list [$slave get normal:a] [$slave get nowal:1]
+        } {1 {}}
+
+        test {Writes without WAL are skipped again} {
+            for {set i 0} {$i < 100} {incr i} {
+                $master set nowal:$i $i
+                $master set normal:$i $i
+            }
+            wait_for_condition 50 100 {
+                [$slave get normal:99] eq 99
+            } else {
+                fail "Interleaved writes are not replicated"
+            }
+            list [$slave get normal:50] [$slave get nowal:50]
+        } {50 {}}
+    }
+}
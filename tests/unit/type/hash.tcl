@@ -533,4 +533,24 @@ start_server {tags {"hash"}} {
 #             assert {[r hincrbyfloat myhash float -0.1] eq {1.9}}
 #         }
 #     }
+
+    test {Packed hash and conversion to member keys} {
+        r nsnew packed
+        r nsset packed packed_entries 4
+        r hmset packed:h b 2 a 1 c 3
+        set res [list [r hgetall packed:h] [r hget packed:h b] [r hexists packed:h d]]
+        lappend res [r hincrby packed:h a 10] [r hstrlen packed:h c] [r hdel packed:h c d]
+        lappend res [r hlen packed:h] [r hmget packed:h a c]
+        # Members are unpacked once there are too many.
+        r hmset packed:h c 3 d 4 e 5
+        lappend res [r hkeys packed:h] [r hget packed:h a] [r hlen packed:h]
+        # Or they are too large.
+        r hset packed:l f [string repeat x 100]
+        lappend res [r hstrlen packed:l f] [r hlen packed:l]
+        r del packed:h packed:l
+        lappend res [r hlen packed:h]
+        r nsdel packed
+        set res
+    } {{a 1 b 2 c 3} 2 0 11 1 1 2 {11 {}} {a b c d e} 11 5 100 1 0}
+
 }
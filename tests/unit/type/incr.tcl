@@ -84,6 +84,21 @@ start_server {tags {"incr"}} {
     #     assert {$old eq $new}
     # }
 
+    test {INCRBYNR merges increments without reply} {
+        r del novar
+        r incrbynr novar 1
+        r incrbynr novar 2
+        set a [r get novar]
+        r set novar 100
+        r incrbynr novar -1
+        lappend a [r get novar]
+        r set novar foo
+        r incrbynr novar 1
+        lappend a [r get novar]
+        catch {r incrbynr novar bar} err
+        lappend a $err
+    } {3 99 foo {ERR*}}
+
     # test {INCRBYFLOAT against non existing key} {
     #     r del novar
     #     list    [roundFloat [r incrbyfloat novar 1]] \
@@ -578,4 +578,19 @@ start_server {
             }
         }
     }
+
+    test {Packed set and conversion to member keys} {
+        r nsnew packed
+        r nsset packed packed_entries 4
+        set res [r sadd packed:s c a b a]
+        lappend res [r smembers packed:s] [r sismember packed:s a] [r sismember packed:s d]
+        lappend res [r srem packed:s a d] [r scard packed:s]
+        # Members are unpacked once there are too many.
+        lappend res [r sadd packed:s d e f] [r smembers packed:s] [r sismember packed:s f]
+        r del packed:s
+        lappend res [r scard packed:s]
+        r nsdel packed
+        set res
+    } {3 {a b c} 1 0 1 2 3 {b c d e f} 1 0}
+
 }
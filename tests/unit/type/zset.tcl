@@ -1057,4 +1057,22 @@ start_server {tags {"zset"}} {
     tags {"maxlen"} {
         maxlen
     }
+
+    test {Packed zset and conversion to member keys} {
+        r nsnew packed
+        r nsset packed packed_entries 4
+        set res [r zadd packed:z 3 c 1 a 2 b]
+        lappend res [r zrange packed:z 0 -1 withscores] [r zrevrangebyscore packed:z 2 -inf]
+        lappend res [r zscore packed:z b] [r zincrby packed:z 10 a] [r zrange packed:z 0 -1]
+        lappend res [r zrem packed:z b d] [r zremrangebyscore packed:z 10 20] [r zcard packed:z]
+        # Members are unpacked once there are too many.
+        lappend res [r zadd packed:z 4 d 5 e 6 f 7 g] [r zrange packed:z 0 -1]
+        lappend res [r zrangebyscore packed:z 4 6 limit 1 1] [r zremrangebyrank packed:z 0 1]
+        lappend res [r zrange packed:z 0 -1 withscores]
+        r del packed:z
+        lappend res [r zcard packed:z]
+        r nsdel packed
+        set res
+    } {3 {a 1 b 2 c 3} {b a} 2 11 {b c a} 1 1 1 4 {c d e f g} e 2 {e 5 f 6 g 7} 0}
+
 }
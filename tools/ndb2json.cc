@@ -1,4 +1,5 @@
 #include "ndb/ndb.h"
+#include "ndb/engine/merge.h"
 
 using namespace ndb;
 using namespace rocksdb;
@@ -17,6 +18,7 @@ Result Open(const std::string& dbname, DB** db, std::vector<ColumnFamilyHandle*>
   std::vector<ColumnFamilyDescriptor> cfds;
   for (const auto& name : cfnames) {
     ColumnFamilyOptions cfopts;
+    cfopts.merge_operator.reset(new ndb::MergeOperator());
     cfds.emplace_back(name, cfopts);
   }
 
@@ -73,6 +75,8 @@ int main(int argc, char *argv[])
   NDB_ASSERT_OK(Open(argv[1], &db, &handles));
 
   for (auto handle : handles) {
+    // Skip the expire index.
+    if (handle->GetName() == "__expire__") continue;
     NDB_ASSERT_OK(Convert(db, handle));
   }
 
@@ -1,4 +1,5 @@
 #include "ndb/ndb.h"
+#include "ndb/engine/merge.h"
 
 using namespace ndb;
 
@@ -15,7 +16,14 @@ class Writer {
     if (batch_ == NULL) {
       batch_.reset(new Batch(engine_));
     }
-    batch_->Put(ns, id, value);
+    // Values with expires are put decoded, so they are indexed to expire.
+    ValueView view;
+    Value decoded;
+    if (view.Decode(value).ok() && view.has_expire() && decoded.Decode(value).ok()) {
+      batch_->Put(ns, id, decoded);
+    } else {
+      batch_->Put(ns, id, value);
+    }
     if (batch_->GetDataSize() > (1 << 20)) {
       std::unique_lock<std::mutex> lock(lock_);
       batches_.push_back(batch_.release());
@@ -55,6 +63,84 @@ class Writer {
   std::vector<Batch*> batches_;
 };
 
+// Collections are given cids, and members of their live versions are keyed
+// by cids, members of dropped versions and collections are dropped.
+class Converter {
+ public:
+  // Return false if the key is dropped, otherwise id and value are converted.
+  bool Convert(NSRef ns, std::string* id, std::string* value) {
+    if (IsSimpleKey(*id)) {
+      return true;
+    }
+    if (IsMetaKey(*id)) {
+      return ConvertMeta(ns, id, value);
+    }
+
+    // Collection keys and members keyed by cids are kept as they are.
+    Slice tmp = *id;
+    uint64_t cid = 0;
+    if (DecodeCollectionKey(&tmp, &cid)) {
+      return true;
+    }
+
+    // Metas are followed by their members.
+    tmp = *id;
+    std::string kmeta;
+    uint64_t version = 0;
+    uint8_t type = 0, subtype = 0;
+    if (meta_.cid() == 0 || !DecodePrefix(&tmp, &kmeta, &version, &type, &subtype) ||
+        kmeta != kmeta_ || version != meta_.version()) {
+      dropped_++;
+      return false;
+    }
+    *id = EncodePrefix(kmeta, meta_, type, subtype) + tmp.ToString();
+    return true;
+  }
+
+  // Meta of the last converted collection.
+  const Meta& meta() const { return meta_; }
+
+  // Forget the last collection when the namespace changes.
+  void Reset() {
+    kmeta_.clear();
+    meta_.Clear();
+  }
+
+  size_t collections() const { return collections_; }
+  size_t dropped() const { return dropped_; }
+
+ private:
+  bool ConvertMeta(NSRef ns, std::string* id, std::string* value) {
+    meta_.Clear();
+    kmeta_ = *id;
+    Value vmeta;
+    auto r = vmeta.Decode(*value);
+    if (r.IsNotFound()) {
+      // Deleted or expired.
+      dropped_++;
+      return false;
+    }
+    NDB_ASSERT_OK(r);
+    if (!vmeta.has_meta() || vmeta.meta().cid() != 0) {
+      return true;
+    }
+
+    uint64_t cid = 0;
+    NDB_ASSERT_OK(ns->NewCollectionID(&cid));
+    vmeta.mutable_meta()->set_cid(cid);
+    meta_ = vmeta.meta();
+    *value = vmeta.Encode();
+    collections_++;
+    return true;
+  }
+
+ private:
+  std::string kmeta_;
+  Meta meta_;
+  size_t collections_ {0};
+  size_t dropped_ {0};
+};
+
 void Commit(Writer& writer) {
   while (!writer.IsDone()) {
     auto size = writer.Commit();
@@ -67,34 +153,27 @@ void Commit(Writer& writer) {
   writer.Commit();
 }
 
-int main(int argc, char *argv[])
-{
-  if (argc != 3) {
-    ERROR("Usage: nsconv <srcpath> <dstpath>\n");
+// Convert and put a key of ns, return false if it is dropped.
+bool Put(Writer& writer, Converter& converter, NSRef ns, std::string id, std::string value) {
+  if (!converter.Convert(ns, &id, &value)) {
+    return false;
+  }
+  if (converter.meta().cid() != 0 && IsMetaKey(id)) {
+    // The collection key maps the cid to the meta.
+    writer.Put(ns, EncodeCollectionKey(converter.meta().cid()), Value::FromBytes(id).Encode());
   }
+  writer.Put(ns, id, value);
+  return true;
+}
 
-  // Open src.
-  rocksdb::DB* db = NULL;
-  auto s = rocksdb::DB::OpenForReadOnly(rocksdb::Options(), argv[1], &db);
-  NDB_ASSERT_OK(StatusToResult(s));
-  std::unique_ptr<rocksdb::DB> auto_free(db);
+// Namespaces are parsed from prefixes of keys in the default column family.
+void ConvertPrefixes(rocksdb::DB* db, Engine& engine, Writer& writer, Converter& converter,
+                     std::map<std::string, size_t>* nscount) {
   rocksdb::ReadOptions ropts(false, false);
   std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(ropts));
 
-  // Open dst.
-  Engine::Options options;
-  options.dbname = argv[2];
-  options.WAL_size_limit = 0;
-  options.WAL_ttl_seconds = 0;
-  Engine engine(options);
-  NDB_ASSERT_OK(engine.Open());
-
-  Writer writer(&engine);
-  std::thread commit(Commit, std::ref(writer));
-
   NSRef ns;
   size_t count = 0;
-  std::map<std::string, size_t> nscount;
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     auto k = it->key();
     auto v = it->value();
@@ -126,22 +205,128 @@ int main(int argc, char *argv[])
         printf("Create namespace %s id %s [prefix %s]\n", nsname.c_str(), id.c_str(), prefix.data());
       }
       ns = engine.GetNamespace(nsname);
+      converter.Reset();
     }
 
-    count++;
-    nscount[nsname]++;
-    writer.Put(ns, id, v);
+    if (!Put(writer, converter, ns, id, v.ToString())) {
+      continue;
+    }
 
+    count++;
+    (*nscount)[nsname]++;
     if (count % 10000000 == 0) {
       printf("COUNT: %zu\n", count);
     }
   }
+  NDB_ASSERT_OK(StatusToResult(it->status()));
+}
+
+// Namespaces are column families, the expire index is rebuilt by puts.
+void ConvertFamilies(rocksdb::DB* db, const std::vector<rocksdb::ColumnFamilyHandle*>& handles,
+                     Engine& engine, Writer& writer, Converter& converter,
+                     std::map<std::string, size_t>* nscount) {
+  rocksdb::ReadOptions ropts(false, false);
+  auto ceiling = EncodeCollectionKey(0);
+  size_t count = 0;
+  for (auto handle : handles) {
+    const auto& nsname = handle->GetName();
+    if (nsname == engine.GetExpireIndex()->GetName()) {
+      continue;
+    }
+    if (engine.NewNamespace(nsname).ok()) {
+      printf("Create namespace %s\n", nsname.c_str());
+    }
+    auto ns = engine.GetNamespace(nsname);
+    NDB_ASSERT(ns != NULL);
+    converter.Reset();
+
+    // Cids of collections created after the upgrade are kept, reserve them
+    // before any cid is allocated. Puts are committed asynchronously, so the
+    // ceiling is put here and skipped below.
+    std::string v;
+    auto s = db->Get(ropts, handle, ceiling, &v);
+    if (s.ok()) {
+      Value value;
+      NDB_ASSERT_OK(value.Decode(v));
+      NDB_ASSERT_OK(ns->Put(ceiling, value));
+    } else if (!s.IsNotFound()) {
+      NDB_ASSERT_OK(StatusToResult(s));
+    }
+
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(ropts, handle));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      if (it->key() == ceiling) {
+        continue;
+      }
+      if (!Put(writer, converter, ns, it->key().ToString(), it->value().ToString())) {
+        continue;
+      }
+
+      count++;
+      (*nscount)[nsname]++;
+      if (count % 10000000 == 0) {
+        printf("COUNT: %zu\n", count);
+      }
+    }
+    NDB_ASSERT_OK(StatusToResult(it->status()));
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    ERROR("Usage: nsconv <srcpath> <dstpath>\n");
+  }
+
+  // Open src with all column families, a single default one is the layout
+  // before namespaces were column families.
+  rocksdb::Options srcopts;
+  srcopts.merge_operator.reset(new MergeOperator());
+  std::vector<std::string> cfnames;
+  auto s = rocksdb::DB::ListColumnFamilies(srcopts, argv[1], &cfnames);
+  NDB_ASSERT_OK(StatusToResult(s));
+  std::vector<rocksdb::ColumnFamilyDescriptor> cfds;
+  for (const auto& name : cfnames) {
+    cfds.emplace_back(name, srcopts);
+  }
+  rocksdb::DB* db = NULL;
+  std::vector<rocksdb::ColumnFamilyHandle*> handles;
+  s = rocksdb::DB::OpenForReadOnly(srcopts, argv[1], cfds, &handles, &db);
+  NDB_ASSERT_OK(StatusToResult(s));
+  std::unique_ptr<rocksdb::DB> auto_free(db);
+
+  // Open dst.
+  Engine::Options options;
+  options.dbname = argv[2];
+  options.WAL_size_limit = 0;
+  options.WAL_ttl_seconds = 0;
+  Engine engine(options);
+  NDB_ASSERT_OK(engine.Open());
+
+  Writer writer(&engine);
+  std::thread commit(Commit, std::ref(writer));
+
+  Converter converter;
+  std::map<std::string, size_t> nscount;
+  if (cfnames.size() == 1) {
+    ConvertPrefixes(db, engine, writer, converter, &nscount);
+  } else {
+    ConvertFamilies(db, handles, engine, writer, converter, &nscount);
+  }
 
   // Join commit thread.
   writer.Done();
   commit.join();
+  for (auto handle : handles) {
+    db->DestroyColumnFamilyHandle(handle);
+  }
 
-  printf("DONE: namespaces %zu keys %zu\n", nscount.size(), count);
+  size_t count = 0;
+  for (const auto& it : nscount) {
+    count += it.second;
+  }
+  printf("DONE: namespaces %zu keys %zu collections %zu dropped %zu\n",
+         nscount.size(), count, converter.collections(), converter.dropped());
   for (const auto& it : nscount) {
     printf("namespace %s: keys %zu\n", it.first.c_str(), it.second);
   }
@@ -1,4 +1,5 @@
 #include "ndb/ndb.h"
+#include "ndb/engine/merge.h"
 
 using namespace ndb;
 using namespace rocksdb;
@@ -12,6 +13,7 @@ Result Open(const std::string& dbname, DB** db, std::vector<ColumnFamilyHandle*>
   std::vector<ColumnFamilyDescriptor> cfds;
   for (const auto& name : cfnames) {
     ColumnFamilyOptions cfopts;
+    cfopts.merge_operator.reset(new ndb::MergeOperator());
     cfds.emplace_back(name, cfopts);
   }
 
@@ -1,6 +1,7 @@
 #include <fstream>
 
 #include "ndb/ndb.h"
+#include "ndb/engine/merge.h"
 
 using namespace ndb;
 
@@ -20,7 +21,9 @@ int main(int argc, char *argv[])
 
   // Open db.
   rocksdb::DB* db = NULL;
-  auto s = rocksdb::DB::OpenForReadOnly(rocksdb::Options(), dbname, &db);
+  rocksdb::Options options;
+  options.merge_operator.reset(new MergeOperator());
+  auto s = rocksdb::DB::OpenForReadOnly(options, dbname, &db);
   NDB_ASSERT_OK(StatusToResult(s));
   std::unique_ptr<rocksdb::DB> auto_free(db);
   rocksdb::ReadOptions ropts(true, false);
@@ -30,6 +33,8 @@ int main(int argc, char *argv[])
   std::ofstream file;
 
   size_t count = 0;
+  // Collections with members keyed by kmetas or by cids.
+  size_t legacy_collections = 0, cid_collections = 0;
   for (it->SeekToFirst(); it->Valid(); it->Next(), count++) {
     auto k = it->key();
     auto v = it->value();
@@ -46,7 +51,7 @@ int main(int argc, char *argv[])
       // Simple types
       id.assign(k.data(), k.size());
     } else {
-      // Collection types.
+      // Collection types, members and collection keys are skipped.
       if (k.size() != 0) {
         continue;
       }
@@ -59,6 +64,11 @@ int main(int argc, char *argv[])
       continue;
     }
     NDB_ASSERT_OK(r);
+    if (value.has_meta() && value.meta().cid() != 0) {
+      cid_collections++;
+    } else if (value.has_meta()) {
+      legacy_collections++;
+    }
 
     if (fileno != (int) count / 100000000) {
       fileno = count / 100000000;
@@ -71,5 +81,6 @@ int main(int argc, char *argv[])
   }
 
   printf("count %zu\n", count);
+  printf("collections: legacy %zu cid %zu\n", legacy_collections, cid_collections);
   return 0;
 }
@@ -1,9 +1,15 @@
 #include "units/units.h"
 
-void Send(Channel<char>* channel, int n) {
+int Send(Channel<char>* channel, int n) {
+  int rejected = 0;
   for (int i = 0; i < n; i++) {
-    channel->Send(new char('c'));
+    auto c = new char('c');
+    if (!channel->Send(c)) {
+      delete c;
+      rejected++;
+    }
   }
+  return rejected;
 }
 
 void Recv(Channel<char>* channel, int n) {
@@ -20,8 +26,40 @@ void Recv(Channel<char>* channel, int n) {
   }
 }
 
+void TestBulk() {
+  Channel<int> channel(4);
+  auto producer = channel.NewProducerToken();
+  auto consumer = channel.NewConsumerToken();
+
+  // Items exceed maxsize are left to the caller.
+  int* items[8];
+  for (int i = 0; i < 8; i++) items[i] = new int(i);
+  NDB_ASSERT(channel.SendBulk(items, 8, &producer) == 4);
+  NDB_ASSERT(channel.size() == 4 && channel.items() == 4);
+  for (int i = 4; i < 8; i++) delete items[i];
+  auto full = new int(8);
+  NDB_ASSERT(!channel.Send(full));
+  delete full;
+
+  // Wakeups are coalesced until the channel is found empty.
+  NDB_ASSERT(channel.wakeups() == 1);
+  NDB_ASSERT(channel.RecvBulk(items, 8, &consumer) == 4);
+  for (int i = 0; i < 4; i++) {
+    NDB_ASSERT(*items[i] == i);
+    delete items[i];
+  }
+  NDB_ASSERT(channel.RecvBulk(items, 8, &consumer) == 0);
+  channel.Send(new int(9));
+  NDB_ASSERT(channel.wakeups() == 2);
+  auto item = channel.Recv();
+  NDB_ASSERT(item != NULL && *item == 9);
+  delete item;
+}
+
 int Test(int argc, char *argv[])
 {
+  TestBulk();
+
   Channel<char> channel(4096);
 
   std::thread s1(Send, &channel, 1000);
@@ -33,8 +71,7 @@ int Test(int argc, char *argv[])
   s1.join(), s2.join(), s3.join(), s4.join();
   r1.join(), r2.join();
 
-  std::thread t1(Send, &channel, 8192);
-  t1.join();
+  NDB_ASSERT(Send(&channel, 8192) == 8192 - 4096);
 
   return EXIT_SUCCESS;
 }
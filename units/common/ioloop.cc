@@ -0,0 +1,148 @@
+#include "units/units.h"
+
+void TestBackend(const char* backend) {
+  IOLoop ioloop;
+  auto r = ioloop.SetBackend(backend);
+  if (!r.ok()) {
+    printf("Skip %s: %s\n", backend, r.message());
+    return;
+  }
+  NDB_ASSERT(strcmp(ioloop.backend(), backend) == 0);
+
+  int fds[2];
+  NDB_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+  NDB_ASSERT_OK(ioloop.Add(fds[0], IOLoop::kReadable));
+  NDB_ASSERT_OK(ioloop.Add(fds[1], IOLoop::kWritable));
+
+  int readable = 0, writable = 0;
+  auto cb = [&](int fd, IOLoop::Event event) {
+    if (fd == fds[0]) {
+      NDB_ASSERT(IOLoop::Readable(event));
+      readable++;
+    } else if (fd == fds[1]) {
+      NDB_ASSERT(IOLoop::Writable(event));
+      writable++;
+    }
+  };
+
+  // Writable only.
+  NDB_ASSERT_OK(ioloop.Run(cb, milliseconds(100)));
+  NDB_ASSERT(readable == 0 && writable == 1);
+
+  // Events are level triggered.
+  NDB_ASSERT(write(fds[1], "x", 1) == 1);
+  NDB_ASSERT_OK(ioloop.Mod(fds[1], IOLoop::kReadable));
+  for (int i = 0; i < 3 && readable < 2; i++) {
+    NDB_ASSERT_OK(ioloop.Run(cb, milliseconds(100)));
+  }
+  NDB_ASSERT(readable == 2 && writable == 1);
+
+  // No events after Del.
+  NDB_ASSERT_OK(ioloop.Del(fds[0]));
+  NDB_ASSERT_OK(ioloop.Run(cb, milliseconds(10)));
+  NDB_ASSERT(readable == 2 && writable == 1);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void TestMultishot() {
+  IOLoop ioloop;
+  auto r = ioloop.SetBackend("io_uring");
+  if (!r.ok() || !ioloop.multishot()) {
+    printf("Skip multishot: %s\n", r.ok() ? "not supported" : r.message());
+    return;
+  }
+
+  // Accept.
+  int lfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrlen = sizeof(addr);
+  NDB_ASSERT(bind(lfd, (sockaddr*) &addr, addrlen) == 0);
+  NDB_ASSERT(listen(lfd, 16) == 0);
+  NDB_ASSERT(getsockname(lfd, (sockaddr*) &addr, &addrlen) == 0);
+  NDB_ASSERT_OK(ioloop.Accept(lfd));
+
+  int cfd = socket(AF_INET, SOCK_STREAM, 0);
+  NDB_ASSERT(connect(cfd, (sockaddr*) &addr, addrlen) == 0);
+  int sfd = -1;
+  std::string received;
+  auto cb = [&](int fd, IOLoop::Event event) {
+    if (IOLoop::Accepted(event)) {
+      sfd = fd;
+    } else {
+      NDB_ASSERT(IOLoop::Received(event));
+      received += ioloop.received().ToString();
+    }
+  };
+  for (int i = 0; i < 3 && sfd == -1; i++) {
+    NDB_ASSERT_OK(ioloop.Run(cb, milliseconds(100)));
+  }
+  NDB_ASSERT(sfd != -1 && sfd != lfd);
+
+  // Receive.
+  NDB_ASSERT_OK(ioloop.Recv(sfd, IOLoop::kReadable));
+  NDB_ASSERT(write(cfd, "hello", 5) == 5);
+  for (int i = 0; i < 3 && received.size() < 5; i++) {
+    NDB_ASSERT_OK(ioloop.Run(cb, milliseconds(100)));
+  }
+  NDB_ASSERT(received == "hello");
+
+  // Data received while watched writable are passed in order later.
+  NDB_ASSERT(write(cfd, "world", 5) == 5);
+  usleep(10000);
+  NDB_ASSERT_OK(ioloop.Mod(sfd, IOLoop::kWritable));
+  NDB_ASSERT(write(cfd, "!", 1) == 1);
+  bool writable = false;
+  auto wcb = [&](int fd, IOLoop::Event event) {
+    NDB_ASSERT(fd == sfd && IOLoop::Writable(event));
+    writable = true;
+  };
+  NDB_ASSERT_OK(ioloop.Run(wcb, milliseconds(100)));
+  NDB_ASSERT(writable && received == "hello");
+  NDB_ASSERT_OK(ioloop.Mod(sfd, IOLoop::kReadable));
+  for (int i = 0; i < 3 && received.size() < 11; i++) {
+    NDB_ASSERT_OK(ioloop.Run(cb, milliseconds(100)));
+  }
+  NDB_ASSERT(received == "helloworld!");
+
+  // Data not passed are moved out by Del, the rest stay in the socket.
+  NDB_ASSERT(write(cfd, "tail", 4) == 4);
+  usleep(10000);
+  std::string unread;
+  NDB_ASSERT_OK(ioloop.Del(sfd, &unread));
+  char buf[16];
+  ssize_t n = recv(sfd, buf, sizeof(buf), MSG_DONTWAIT);
+  if (n > 0) unread.append(buf, n);
+  NDB_ASSERT(unread == "tail");
+
+  // EOF is passed as readable.
+  NDB_ASSERT_OK(ioloop.Recv(sfd, IOLoop::kReadable));
+  close(cfd);
+  bool readable = false;
+  auto rcb = [&](int fd, IOLoop::Event event) {
+    NDB_ASSERT(fd == sfd && IOLoop::Readable(event));
+    readable = true;
+  };
+  for (int i = 0; i < 3 && !readable; i++) {
+    NDB_ASSERT_OK(ioloop.Run(rcb, milliseconds(100)));
+  }
+  NDB_ASSERT(readable && read(sfd, buf, sizeof(buf)) == 0);
+  NDB_ASSERT_OK(ioloop.Del(sfd));
+  NDB_ASSERT_OK(ioloop.Del(lfd));
+  close(sfd);
+  close(lfd);
+}
+
+int Test(int argc, char* argv[]) {
+  TestBackend("epoll");
+  TestBackend("io_uring");
+  TestMultishot();
+  IOLoop ioloop;
+  NDB_ASSERT(!ioloop.SetBackend("select").ok());
+  NDB_ASSERT(!ioloop.multishot() && !ioloop.Accept(0).ok());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#include "units/units.h"
+
+void TestLookup(ValueCache* cache) {
+  std::string value;
+  bool found = false;
+  uint64_t generation = 0;
+
+  auto key = ValueCache::Key(1, "meta");
+  NDB_ASSERT(!cache->Lookup(key, &value, &found, &generation));
+  cache->Insert(key, "value", true, generation);
+  NDB_ASSERT(cache->Lookup(key, &value, &found, &generation));
+  NDB_ASSERT(found && value == "value");
+
+  // Keys of other namespaces.
+  auto other = ValueCache::Key(2, "meta");
+  NDB_ASSERT(!cache->Lookup(other, &value, &found, &generation));
+  cache->Insert(other, "", false, generation);
+  NDB_ASSERT(cache->Lookup(other, &value, &found, &generation));
+  NDB_ASSERT(!found);
+
+  cache->Update(key, "update");
+  NDB_ASSERT(cache->Lookup(key, &value, &found, &generation));
+  NDB_ASSERT(found && value == "update");
+
+  cache->Erase(key);
+  NDB_ASSERT(!cache->Lookup(key, &value, &found, &generation));
+}
+
+void TestGeneration(ValueCache* cache) {
+  std::string value;
+  bool found = false;
+  uint64_t generation = 0;
+
+  // A writer commits between a reader's miss and insert.
+  auto key = ValueCache::Key(1, "generation");
+  NDB_ASSERT(!cache->Lookup(key, &value, &found, &generation));
+  cache->Update(key, "new");
+  cache->Insert(key, "old", true, generation);
+  NDB_ASSERT(cache->Lookup(key, &value, &found, &generation));
+  NDB_ASSERT(found && value == "new");
+
+  cache->Erase(key);
+  NDB_ASSERT(!cache->Lookup(key, &value, &found, &generation));
+  cache->Erase(key);
+  cache->Insert(key, "old", true, generation);
+  NDB_ASSERT(!cache->Lookup(key, &value, &found, &generation));
+}
+
+void TestEvict() {
+  ValueCache cache(64 << 10, 1);
+  std::string value(1000, 'v');
+  for (int i = 0; i < 1000; i++) {
+    cache.Update(ValueCache::Key(1, std::to_string(i)), value);
+  }
+  size_t entries = 0;
+  NDB_ASSERT(cache.GetUsage(&entries) <= (64 << 10));
+  NDB_ASSERT(entries > 0 && entries < 1000);
+
+  bool found = false;
+  uint64_t generation = 0;
+  NDB_ASSERT(cache.Lookup(ValueCache::Key(1, "999"), &value, &found, &generation));
+  NDB_ASSERT(!cache.Lookup(ValueCache::Key(1, "0"), &value, &found, &generation));
+}
+
+int Test(int argc, char* argv[]) {
+  ValueCache cache(1 << 20);
+  TestLookup(&cache);
+  TestGeneration(&cache);
+  NDB_ASSERT(cache.hits() > 0 && cache.misses() > 0);
+  TestEvict();
+  return EXIT_SUCCESS;
+}
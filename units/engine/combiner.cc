@@ -0,0 +1,141 @@
+#include "units/units.h"
+
+void TestCombine(rocksdb::DB* db, const WriteCombiner::Options& options,
+                 int nthreads, int nwrites) {
+  WriteCombiner combiner(db, rocksdb::WriteOptions(), options);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; t++) {
+    threads.emplace_back([&combiner, t, nwrites] {
+      for (int i = 0; i < nwrites; i++) {
+        auto key = "key:" + std::to_string(t) + ":" + std::to_string(i);
+        rocksdb::WriteBatch batch;
+        batch.Put(key, key);
+        batch.Put(key + ":copy", key);
+        NDB_ASSERT(combiner.Write(&batch).ok());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  uint64_t total = nthreads * nwrites;
+  NDB_ASSERT(combiner.batches() == total);
+  NDB_ASSERT(combiner.groups() > 0 && combiner.groups() <= total);
+  for (int t = 0; t < nthreads; t++) {
+    for (int i = 0; i < nwrites; i++) {
+      auto key = "key:" + std::to_string(t) + ":" + std::to_string(i);
+      std::string value;
+      NDB_ASSERT(db->Get(rocksdb::ReadOptions(), key, &value).ok() && value == key);
+      NDB_ASSERT(db->Get(rocksdb::ReadOptions(), key + ":copy", &value).ok() && value == key);
+    }
+  }
+}
+
+// A db that rejects batches of more than one record.
+class PickyDB : public rocksdb::StackableDB {
+ public:
+  PickyDB(rocksdb::DB* db)
+      : rocksdb::StackableDB(std::shared_ptr<rocksdb::DB>(db, [](rocksdb::DB*) {})) {}
+
+  Status Write(const rocksdb::WriteOptions& wopts, rocksdb::WriteBatch* batch) override {
+    if (batch->Count() > 1) {
+      return Status::IOError("Picky");
+    }
+    return rocksdb::StackableDB::Write(wopts, batch);
+  }
+};
+
+// Run writes of batches concurrently, so they are combined in one group.
+std::vector<Status> WriteGroup(rocksdb::DB* db, std::vector<rocksdb::WriteBatch>* batches) {
+  WriteCombiner::Options options;
+  options.max_delay_usecs = 100 * 1000;
+  WriteCombiner combiner(db, rocksdb::WriteOptions(), options);
+  std::vector<Status> ss(batches->size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < batches->size(); i++) {
+    threads.emplace_back([&, i] { ss[i] = combiner.Write(&(*batches)[i]); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  NDB_ASSERT(combiner.groups() == 1);
+  return ss;
+}
+
+void TestFailures(rocksdb::DB* db) {
+  // Batches are written alone if the combined one fails.
+  {
+    PickyDB picky(db);
+    std::vector<rocksdb::WriteBatch> batches(4);
+    for (size_t i = 0; i < batches.size(); i++) {
+      batches[i].Put("picky:" + std::to_string(i), "value");
+    }
+    batches[0].Put("picky:more", "value");
+    auto ss = WriteGroup(&picky, &batches);
+    std::string value;
+    NDB_ASSERT(!ss[0].ok());
+    NDB_ASSERT(db->Get(rocksdb::ReadOptions(), "picky:0", &value).IsNotFound());
+    for (size_t i = 1; i < ss.size(); i++) {
+      NDB_ASSERT(ss[i].ok());
+      NDB_ASSERT(db->Get(rocksdb::ReadOptions(), "picky:" + std::to_string(i), &value).ok());
+    }
+  }
+
+  // Records of unknown column families don't fail the others.
+  {
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    rocksdb::DB* other = NULL;
+    NDB_ASSERT(rocksdb::DB::Open(options, "nicedb.other", &other).ok());
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+    for (int i = 0; i < 8; i++) {
+      rocksdb::ColumnFamilyHandle* handle = NULL;
+      NDB_ASSERT(other->CreateColumnFamily(options, "cf" + std::to_string(i), &handle).ok());
+      handles.push_back(handle);
+    }
+
+    std::vector<rocksdb::WriteBatch> batches(2);
+    batches[0].Put("unknown", "good");
+    batches[1].Put(handles.back(), "unknown", "bad");
+    for (const auto& s : WriteGroup(db, &batches)) {
+      NDB_ASSERT(s.ok());
+    }
+    std::string value;
+    NDB_ASSERT(db->Get(rocksdb::ReadOptions(), "unknown", &value).ok() && value == "good");
+
+    for (auto handle : handles) {
+      other->DestroyColumnFamilyHandle(handle);
+    }
+    delete other;
+    system("rm -rf nicedb.other");
+  }
+}
+
+int Test(int argc, char* argv[]) {
+  auto engine = new Engine(Engine::Options());
+  NDB_ASSERT_OK(engine->Open());
+  auto db = engine->GetRocksDB();
+
+  WriteCombiner::Options options;
+  TestCombine(db, options, 8, 1000);
+
+  // Leaders wait for more batches.
+  options.max_delay_usecs = 100;
+  TestCombine(db, options, 8, 100);
+
+  // Every batch exceeds the size, so nothing is combined.
+  options.max_batch_size = 1;
+  TestCombine(db, options, 4, 100);
+
+  // Disabled.
+  options.max_batch_size = 0;
+  TestCombine(db, options, 4, 100);
+
+  TestFailures(db);
+
+  delete engine;
+  system("rm -rf nicedb");
+  return 0;
+}
@@ -1,32 +1,159 @@
 #include "units/units.h"
 #include "ndb/engine/compaction.h"
+#include "ndb/engine/packed.h"
 
-int Test(int argc, char* argv[]) {
-    CompactionMetaCache cache(2);
+void TestCache() {
+  CompactionMetaCache cache(2);
+
+  CompactionMeta tmp;
+  NDB_ASSERT(!cache.Get("meta:1", &tmp));
+
+  CompactionMeta meta;
+  meta.deleted = true;
+  meta.version = 1;
+  cache.Put("meta:1", meta);
+
+  NDB_ASSERT(cache.Get("meta:1", &tmp));
+  NDB_ASSERT(tmp.deleted == true && tmp.version == 1);
+
+  meta.deleted = false;
+  meta.version = 2;
+  cache.Put("meta:2", meta);
+  meta.deleted = true;
+  meta.version = 3;
+  cache.Put("meta:3", meta);
+
+  // NDB_ASSERT(!cache.Get("meta:1", &tmp));
+  NDB_ASSERT(cache.Get("meta:2", &tmp));
+  NDB_ASSERT(tmp.deleted == false && tmp.version == 2);
+  NDB_ASSERT(cache.Get("meta:3", &tmp));
+  NDB_ASSERT(tmp.deleted == true && tmp.version == 3);
+
+  cache.AddCounters(1, 2, 3);
+  cache.AddCounters(1, 2, 3);
+  NDB_ASSERT(cache.hits() == 2 && cache.misses() == 4 && cache.memo_hits() == 6);
+}
+
+// Whether id exists in db, caches are bypassed.
+bool Exists(NSRef ns, const Slice& id) {
+  auto it = ns->NewIterator();
+  it->Seek(id);
+  return it->Valid() && it->key() == id;
+}
+
+void TestPackedMeta(NSRef ns) {
+  PackedMembers members;
+  members.Put("field", Value::FromBytes("value").Encode());
+
+  std::string id = "packed";
+  auto kmeta = EncodeMeta(id);
+  Value meta;
+  meta.mutable_meta()->set_type(Meta::HASH);
+  meta.mutable_meta()->set_version(1);
+  meta.mutable_meta()->set_length(1);
+  meta.mutable_meta()->set_packed(members.Encode());
+  NDB_ASSERT_OK(ns->Put(kmeta, meta));
 
-    CompactionMeta tmp;
-    NDB_ASSERT(!cache.Get("meta:1", &tmp));
+  // Live packed metas have no member keys but are kept.
+  NDB_ASSERT_OK(ns->CompactRange());
+  NDB_ASSERT(Exists(ns, kmeta));
+  Value value;
+  NDB_ASSERT_OK(ns->Get(kmeta, &value));
+  NDB_ASSERT(value.meta().packed() == meta.meta().packed());
 
-    CompactionMeta meta;
-    meta.deleted = true;
-    meta.version = 1;
-    cache.Put("meta:1", meta);
+  // Deleted packed metas are dropped.
+  meta.mutable_meta()->set_deleted(true);
+  NDB_ASSERT_OK(ns->Put(kmeta, meta));
+  NDB_ASSERT_OK(ns->CompactRange());
+  NDB_ASSERT(!Exists(ns, kmeta));
+}
+
+// Deleted collections with cids are dropped with their members.
+void TestDeletedCollection(NSRef ns) {
+  std::string id = "deleted";
+  auto kmeta = EncodeMeta(id);
+  Value meta;
+  meta.mutable_meta()->set_type(Meta::HASH);
+  meta.mutable_meta()->set_version(1);
+  meta.mutable_meta()->set_length(2);
+  NSBatch batch(ns);
+  NDB_ASSERT_OK(batch.NewCollection(kmeta, meta.mutable_meta()));
+  auto ckey = EncodeCollectionKey(meta.meta().cid());
+  auto member0 = EncodePrefix(kmeta, meta.meta(), 1, 0) + "member0";
+  auto member1 = EncodePrefix(kmeta, meta.meta(), 1, 0) + "member1";
+  batch.Put(member0, Value::FromInt64(0));
+  batch.Put(member1, Value::FromInt64(1));
+  batch.Put(kmeta, meta);
+  NDB_ASSERT_OK(batch.Commit());
+
+  // Members of live collections are kept.
+  NDB_ASSERT_OK(ns->CompactRange());
+  NDB_ASSERT(Exists(ns, ckey) && Exists(ns, member0) && Exists(ns, member1));
+
+  // Deleted metas keep their cids until members are dropped.
+  meta.mutable_meta()->set_deleted(true);
+  NDB_ASSERT_OK(ns->Put(kmeta, meta));
+  NDB_ASSERT_OK(ns->CompactRange());
+  NDB_ASSERT(!Exists(ns, ckey) && !Exists(ns, member0) && !Exists(ns, member1));
+  NDB_ASSERT_OK(ns->CompactRange());
+  NDB_ASSERT(!Exists(ns, kmeta));
+}
+
+// Members of dead versions and cids are removed with the rest skipped.
+void TestSkipUntil(NSRef ns) {
+  auto cache = std::make_shared<CompactionMetaCache>(1024);
+  CompactionFilter filter(ns, cache);
+  auto value = Value::FromInt64(0).Encode();
+  std::string new_value, skip_until;
 
-    NDB_ASSERT(cache.Get("meta:1", &tmp));
-    NDB_ASSERT(tmp.deleted == true && tmp.version == 1);
+  std::string id = "skip";
+  auto kmeta = EncodeMeta(id);
+  Value meta;
+  meta.mutable_meta()->set_type(Meta::HASH);
+  meta.mutable_meta()->set_version(2);
+  NDB_ASSERT_OK(ns->Put(kmeta, meta));
 
-    meta.deleted = false;
-    meta.version = 2;
-    cache.Put("meta:2", meta);
-    meta.deleted = true;
-    meta.version = 3;
-    cache.Put("meta:3", meta);
+  // Members of the dropped version skip to the next version.
+  auto member = EncodePrefix(kmeta, 1, 1, 0) + "member";
+  auto decision = filter.FilterV2(0, member, CompactionFilter::ValueType::kValue,
+                                  value, &new_value, &skip_until);
+  NDB_ASSERT(decision == CompactionFilter::Decision::kRemoveAndSkipUntil);
+  NDB_ASSERT(Slice(skip_until).compare(EncodePrefix(kmeta, 1, 31, 7) + "\xff") > 0);
+  NDB_ASSERT(Slice(skip_until).compare(EncodePrefix(kmeta, 2, 0, 0)) <= 0);
+
+  // Members of the live version are kept.
+  member = EncodePrefix(kmeta, 2, 1, 0) + "member";
+  decision = filter.FilterV2(0, member, CompactionFilter::ValueType::kValue,
+                             value, &new_value, &skip_until);
+  NDB_ASSERT(decision == CompactionFilter::Decision::kKeep);
+
+  // Members of a cid without a collection key skip to the next cid.
+  uint64_t cid = 0;
+  NDB_ASSERT_OK(ns->NewCollectionID(&cid));
+  meta.mutable_meta()->set_cid(cid);
+  member = EncodePrefix(kmeta, meta.meta(), 1, 0) + "member";
+  decision = filter.FilterV2(0, member, CompactionFilter::ValueType::kValue,
+                             value, &new_value, &skip_until);
+  NDB_ASSERT(decision == CompactionFilter::Decision::kRemoveAndSkipUntil);
+  NDB_ASSERT(skip_until == EncodeCollectionKey(cid + 1));
+  NDB_ASSERT(Slice(skip_until).compare(member) > 0);
+
+  NDB_ASSERT_OK(ns->Delete(kmeta));
+}
+
+int Test(int argc, char* argv[]) {
+  TestCache();
 
-    // NDB_ASSERT(!cache.Get("meta:1", &tmp));
-    NDB_ASSERT(cache.Get("meta:2", &tmp));
-    NDB_ASSERT(tmp.deleted == false && tmp.version == 2);
-    NDB_ASSERT(cache.Get("meta:3", &tmp));
-    NDB_ASSERT(tmp.deleted == true && tmp.version == 3);
+  auto engine = new Engine(Engine::Options());
+  NDB_ASSERT_OK(engine->Open());
+  NDB_ASSERT_OK(engine->NewNamespace("compaction"));
+  auto ns = engine->GetNamespace("compaction");
+  TestPackedMeta(ns);
+  TestDeletedCollection(ns);
+  TestSkipUntil(ns);
+  NDB_ASSERT_OK(engine->DropNamespace("compaction"));
 
-    return EXIT_SUCCESS;
+  delete engine;
+  system("rm -rf nicedb");
+  return EXIT_SUCCESS;
 }
@@ -30,6 +30,89 @@ void TestEncodePrefix(const std::string& id, uint64_t version, uint8_t type, uin
   NDB_ASSERT(dst.size() == 0);
 }
 
+void TestExtractPrefix(const std::string& id, uint64_t version) {
+  auto kmeta = EncodeMeta(id);
+  auto encoded = EncodePrefix(kmeta, version, 1, 2);
+  auto member = encoded + "member";
+
+  Slice prefix;
+  NDB_ASSERT(ExtractPrefix(member, &prefix));
+  NDB_ASSERT(prefix.size() == encoded.size() - 1);
+  NDB_ASSERT(memcmp(prefix.data(), encoded.data(), prefix.size()) == 0);
+
+  // Prefixes of members with other types are the same.
+  auto other = EncodePrefix(kmeta, version, 2, 1);
+  NDB_ASSERT(ExtractPrefix(other, &prefix));
+  NDB_ASSERT(Slice(member).starts_with(prefix));
+
+  // Simple keys and meta keys are not in the domain.
+  PrefixExtractor extractor;
+  NDB_ASSERT(extractor.InDomain(member));
+  NDB_ASSERT(!extractor.InDomain(id));
+  NDB_ASSERT(!extractor.InDomain(kmeta));
+  NDB_ASSERT(extractor.Transform(member).compare(prefix) == 0);
+}
+
+void TestCollectionKey(uint64_t cid) {
+  auto key = EncodeCollectionKey(cid);
+  NDB_ASSERT(key.size() == kCollectionKeySize);
+  Slice tmp = key;
+  uint64_t cid2 = 0;
+  NDB_ASSERT(DecodeCollectionKey(&tmp, &cid2));
+  NDB_ASSERT(cid2 == cid && tmp.size() == 0);
+
+  // Keys are ordered by cid.
+  if (cid < kMaxCollectionID) {
+    NDB_ASSERT(Slice(key).compare(EncodeCollectionKey(cid + 1)) < 0);
+  }
+
+  // Metas without cids keep the legacy layout.
+  if (cid == 0) return;
+
+  // Members are keyed by the cid, and the collection key is their prefix.
+  Meta meta;
+  meta.set_version(1);
+  meta.set_cid(cid);
+  auto member = EncodePrefix(EncodeMeta("huang"), meta, 1, 2) + "member";
+  Slice prefix;
+  NDB_ASSERT(ExtractPrefix(member, &prefix) && prefix == key);
+  NDB_ASSERT(ExtractPrefix(key, &prefix) && prefix == key);
+  tmp = member;
+  NDB_ASSERT(RemovePrefix(&tmp) && tmp == "member");
+  tmp = key;
+  NDB_ASSERT(!RemovePrefix(&tmp));
+}
+
+void TestLegacyPrefix() {
+  // Members of the empty id are not taken as collection keys.
+  Meta meta;
+  meta.set_version((1ULL << 56) - 1);
+  auto member = EncodePrefix(EncodeMeta(""), meta, 1, 2) + "member";
+  Slice tmp = member;
+  uint64_t cid = 0;
+  NDB_ASSERT(!DecodeCollectionKey(&tmp, &cid));
+  Slice prefix;
+  NDB_ASSERT(ExtractPrefix(member, &prefix));
+  NDB_ASSERT(prefix.size() == member.size() - 1 - strlen("member"));
+  tmp = member;
+  NDB_ASSERT(RemovePrefix(&tmp) && tmp == "member");
+}
+
+void TestEncodeExpireKey(uint64_t expire, const std::string& nsname, const std::string& id) {
+  auto key = EncodeExpireKey(expire, nsname, id);
+  Slice tmp = key, nsname2;
+  uint64_t expire2 = 0;
+  NDB_ASSERT(DecodeExpireKey(&tmp, &expire2, &nsname2));
+  NDB_ASSERT(expire2 == expire && nsname2 == nsname && tmp == id);
+
+  // Keys are ordered by expire.
+  NDB_ASSERT(Slice(key).compare(EncodeExpireKey(expire + 1, "", "")) < 0);
+
+  // Truncated names are invalid.
+  tmp = Slice(key.data(), sizeof(expire) + 1 + nsname.size() / 2);
+  NDB_ASSERT(nsname.empty() || !DecodeExpireKey(&tmp, &expire2, &nsname2));
+}
+
 int Test(int argc, char* argv[]) {
   TestEncodeInt64(0);
   TestEncodeInt64(1);
@@ -44,5 +127,22 @@ int Test(int argc, char* argv[]) {
   TestEncodePrefix("chao", 1ULL << 31, 1 << 2, 3);
   TestEncodePrefix("huang", 1ULL << 63, 1 << 3, 4);
 
+  TestExtractPrefix("0", 0);
+  TestExtractPrefix("hua", 1);
+  TestExtractPrefix("chao", 1ULL << 31);
+  TestExtractPrefix("huang", 1ULL << 63);
+
+  TestCollectionKey(0);
+  TestCollectionKey(1);
+  TestCollectionKey(127);
+  TestCollectionKey(128);
+  TestCollectionKey(1ULL << 40);
+  TestCollectionKey(kMaxCollectionID);
+  TestLegacyPrefix();
+
+  TestEncodeExpireKey(0, "", "0");
+  TestEncodeExpireKey(1, "default", "hua");
+  TestEncodeExpireKey(1ULL << 40, "user", std::string("chao\0", 5));
+
   return EXIT_SUCCESS;
 }
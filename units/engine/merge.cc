@@ -0,0 +1,83 @@
+#include "units/units.h"
+#include "ndb/engine/merge.h"
+
+MergeOperator op;
+
+Result Merge(const Value* existing, const std::vector<Value>& operands, Value* result) {
+  std::string existing_value;
+  if (existing != NULL) existing_value = existing->Encode();
+  std::vector<std::string> encoded;
+  for (const auto& operand : operands) encoded.push_back(operand.Encode());
+  std::vector<Slice> operand_list(encoded.begin(), encoded.end());
+
+  Slice key("key"), existing_slice(existing_value), existing_operand(NULL, 0);
+  std::string new_value;
+  rocksdb::MergeOperator::MergeOperationInput in(
+      key, existing != NULL ? &existing_slice : NULL, operand_list, NULL);
+  rocksdb::MergeOperator::MergeOperationOutput out(new_value, existing_operand);
+
+  NDB_ASSERT(op.FullMergeV2(in, &out));
+  if (existing_operand.data() != NULL) {
+    new_value = existing_operand.ToString();
+  }
+  return result->Decode(new_value);
+}
+
+Value Increment(int64_t i, uint64_t expire = 0) {
+  auto value = Value::FromInt64(i);
+  if (expire > 0) value.set_expire(expire);
+  return value;
+}
+
+void TestMergeInt64() {
+  Value result;
+  NDB_ASSERT_OK(Merge(NULL, {Increment(1), Increment(2)}, &result));
+  NDB_ASSERT(result.int64() == 3 && !result.has_expire());
+
+  auto existing = Value::FromInt64(10);
+  NDB_ASSERT_OK(Merge(&existing, {Increment(-3)}, &result));
+  NDB_ASSERT(result.int64() == 7);
+
+  // Bytes encoded integers are converted.
+  existing = Value::FromBytes("100");
+  NDB_ASSERT_OK(Merge(&existing, {Increment(1)}, &result));
+  NDB_ASSERT(result.has_int64() && result.int64() == 101);
+}
+
+void TestMergeInvalid() {
+  Value result;
+  auto existing = Value::FromBytes("foo");
+  auto dropped = op.dropped();
+  NDB_ASSERT_OK(Merge(&existing, {Increment(1), Increment(2)}, &result));
+  NDB_ASSERT(result.bytes() == "foo");
+  NDB_ASSERT(op.dropped() == dropped + 2);
+
+  // Overflowed increments are dropped.
+  existing = Value::FromInt64(INT64_MAX - 1);
+  NDB_ASSERT_OK(Merge(&existing, {Increment(1), Increment(1), Increment(-2)}, &result));
+  NDB_ASSERT(result.int64() == INT64_MAX - 2);
+  NDB_ASSERT(op.dropped() == dropped + 3);
+}
+
+void TestMergeExpire() {
+  Value result;
+  auto future = getmstime() + 3600 * 1000;
+
+  // Expire of the existing value is kept.
+  auto existing = Value::FromInt64(1);
+  existing.set_expire(future);
+  NDB_ASSERT_OK(Merge(&existing, {Increment(1, future + 1)}, &result));
+  NDB_ASSERT(result.int64() == 2 && result.expire() == future);
+
+  // Expired values start from 0 with the expire of increments.
+  existing.set_expire(1);
+  NDB_ASSERT_OK(Merge(&existing, {Increment(1), Increment(1, future)}, &result));
+  NDB_ASSERT(result.int64() == 2 && result.expire() == future);
+}
+
+int Test(int argc, char* argv[]) {
+  TestMergeInt64();
+  TestMergeInvalid();
+  TestMergeExpire();
+  return 0;
+}
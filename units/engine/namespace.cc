@@ -75,6 +75,92 @@ void TestMultiGet(NSRef ns, int n, int step) {
     NDB_ASSERT_OK(results[i]);
     NDB_ASSERT(values[i].int64() == (int64_t) i * step);
   }
+
+  // Views are decoded in place of pinned values.
+  members.push_back("not_exists");
+  std::vector<PinnableSlice> pins;
+  std::vector<ValueView> views;
+  results = ns->MultiGet(members, &pins, &views);
+  NDB_ASSERT(results.back().IsNotFound());
+  for (size_t i = 0; i + 1 < results.size(); i++) {
+    NDB_ASSERT_OK(results[i]);
+    NDB_ASSERT(views[i].int64() == (int64_t) i * step);
+  }
+  NDB_ASSERT(ns->MultiGet(members, NULL).back().IsNotFound());
+}
+
+void TestExpire(NSRef ns) {
+  uint64_t version = 0, cid = 0;
+  auto value = Value::FromInt64(1);
+  value.set_expire(getmstime() + 3600 * 1000);
+  NDB_ASSERT_OK(ns->Put("expire", value));
+  NDB_ASSERT(ns->Expire("expire", &version, &cid).IsNotFound());
+
+  value.set_expire(1);
+  NDB_ASSERT_OK(ns->Put("expire", value));
+  NDB_ASSERT_OK(ns->Expire("expire", &version, &cid));
+  NDB_ASSERT(ns->Expire("expire", &version, &cid).IsNotFound());
+  NDB_ASSERT(ns->Get("expire", NULL).IsNotFound());
+}
+
+void TestDeleteVersion(NSRef ns) {
+  std::string id = "collection";
+  auto kmeta = EncodeMeta(id);
+  auto member0 = EncodePrefix(kmeta, 0, 1, 0) + "member";
+  auto member1 = EncodePrefix(kmeta, 1, 1, 0) + "member";
+  NDB_ASSERT_OK(ns->Put(member0, Value::FromInt64(0)));
+  NDB_ASSERT_OK(ns->Put(member1, Value::FromInt64(1)));
+
+  // Only the dropped version is deleted if the collection is alive.
+  Value meta;
+  meta.mutable_meta()->set_version(1);
+  NDB_ASSERT_OK(ns->Put(kmeta, meta));
+  NDB_ASSERT_OK(ns->DeleteVersion(kmeta, 0, 0));
+  NDB_ASSERT(ns->Get(member0, NULL).IsNotFound());
+  NDB_ASSERT_OK(ns->Get(member1, NULL));
+
+  // All versions are deleted if the collection is deleted.
+  NDB_ASSERT_OK(ns->Put(member0, Value::FromInt64(0)));
+  meta.mutable_meta()->set_deleted(true);
+  NDB_ASSERT_OK(ns->Put(kmeta, meta));
+  NDB_ASSERT_OK(ns->DeleteVersion(kmeta, 1, 0));
+  NDB_ASSERT(ns->Get(member0, NULL).IsNotFound());
+  NDB_ASSERT(ns->Get(member1, NULL).IsNotFound());
+  NDB_ASSERT(ns->Get(kmeta, NULL).IsNotFound());
+  NDB_ASSERT_OK(ns->Delete(kmeta));
+}
+
+void TestCollectionID(NSRef ns) {
+  std::string id = "collection";
+  auto kmeta = EncodeMeta(id);
+  Meta meta;
+  meta.set_version(1);
+  uint64_t cid1 = 0;
+  NSBatch batch(ns);
+  NDB_ASSERT_OK(batch.NewCollection(kmeta, &meta));
+  NDB_ASSERT_OK(ns->NewCollectionID(&cid1));
+  auto cid0 = meta.cid();
+  NDB_ASSERT(cid0 > 0 && cid1 == cid0 + 1);
+
+  // The collection key maps the cid to kmeta, once the batch is committed.
+  Value value;
+  NDB_ASSERT(ns->Get(EncodeCollectionKey(cid0), NULL).IsNotFound());
+  NDB_ASSERT_OK(batch.Commit());
+  NDB_ASSERT_OK(ns->Get(EncodeCollectionKey(cid0), &value));
+  NDB_ASSERT(value.has_bytes() && value.bytes() == kmeta);
+
+  auto member0 = EncodePrefix(kmeta, meta, 1, 0) + "member";
+  meta.set_cid(cid1);
+  auto member1 = EncodePrefix(kmeta, meta, 1, 0) + "member";
+  NDB_ASSERT_OK(ns->Put(member0, Value::FromInt64(0)));
+  NDB_ASSERT_OK(ns->Put(member1, Value::FromInt64(1)));
+
+  // Only keys of the cid are deleted.
+  NDB_ASSERT_OK(ns->DeleteVersion(kmeta, 1, cid0));
+  NDB_ASSERT(ns->Get(EncodeCollectionKey(cid0), NULL).IsNotFound());
+  NDB_ASSERT(ns->Get(member0, NULL).IsNotFound());
+  NDB_ASSERT_OK(ns->Get(member1, NULL));
+  NDB_ASSERT_OK(ns->Delete(member1));
 }
 
 void TestRangeGet(NSRef ns, int n, int offset, int count, bool reverse) {
@@ -126,17 +212,124 @@ void TestNamespace(Engine* engine, const std::string& name) {
   TestRangeGet(ns, n, 10, 10, true);
   TestRangeGet(ns, n, 10, 10, false);
   TestDelete(ns, 0, n);
+  TestExpire(ns);
+  TestDeleteVersion(ns);
+  TestCollectionID(ns);
 
   NDB_ASSERT_OK(engine->DropNamespace(name));
 }
 
+// Batches of several namespaces are written with the strictest durability.
+void TestBatchDurability(Engine* engine) {
+  NDB_ASSERT_OK(engine->NewNamespace("normal"));
+  NDB_ASSERT_OK(engine->NewNamespace("sync"));
+  auto normal = engine->GetNamespace("normal");
+  auto sync = engine->GetNamespace("sync");
+  auto configs = sync->GetConfigs();
+  configs.set_durability(pb::SYNC);
+  NDB_ASSERT_OK(sync->PutConfigs(configs));
+
+  auto statistics = engine->GetRocksDB()->GetDBOptions().statistics;
+  auto synced = statistics->getTickerCount(rocksdb::WAL_FILE_SYNCED);
+  {
+    Batch batch(engine);
+    batch.Put(normal, "key", Value::FromInt64(1));
+    NDB_ASSERT_OK(batch.Commit());
+  }
+  NDB_ASSERT(statistics->getTickerCount(rocksdb::WAL_FILE_SYNCED) == synced);
+  {
+    Batch batch(engine);
+    batch.Put(normal, "key", Value::FromInt64(2));
+    batch.Put(sync, "key", Value::FromInt64(2));
+    batch.Delete(normal, "key");
+    NDB_ASSERT_OK(batch.Commit());
+  }
+  NDB_ASSERT(statistics->getTickerCount(rocksdb::WAL_FILE_SYNCED) > synced);
+  NDB_ASSERT(normal->Get("key", NULL).IsNotFound());
+  NDB_ASSERT_OK(sync->Get("key", NULL));
+
+  NDB_ASSERT_OK(engine->DropNamespace("normal"));
+  NDB_ASSERT_OK(engine->DropNamespace("sync"));
+}
+
+// Configs take effect again after the engine is reopened.
+void TestReopen(Engine** engine) {
+  NDB_ASSERT_OK((*engine)->NewNamespace("reopen"));
+  auto configs = (*engine)->GetNamespace("reopen")->GetConfigs();
+  configs.set_durability(pb::SYNC);
+  configs.set_value_cache_size(1 << 20);
+  NDB_ASSERT_OK((*engine)->GetNamespace("reopen")->PutConfigs(configs));
+
+  delete *engine;
+  *engine = new Engine(Engine::Options());
+  NDB_ASSERT_OK((*engine)->Open());
+  auto ns = (*engine)->GetNamespace("reopen");
+  NDB_ASSERT(ns != NULL);
+  std::string stats = ns->GetStats().Print();
+  NDB_ASSERT(stats.find("durability = sync") != std::string::npos);
+  NDB_ASSERT(stats.find("value_cache_hits") != std::string::npos);
+
+  // The same configs are still applied.
+  configs = ns->GetConfigs();
+  NDB_ASSERT_OK(ns->PutConfigs(configs));
+  stats = ns->GetStats().Print();
+  NDB_ASSERT(stats.find("durability = sync") != std::string::npos);
+  NDB_ASSERT_OK((*engine)->DropNamespace("reopen"));
+}
+
+// Expires of merges of an id in the expire index.
+std::vector<uint64_t> MergeExpires(Engine* engine, const Slice& id) {
+  std::vector<uint64_t> expires;
+  std::unique_ptr<rocksdb::Iterator> it(
+      engine->GetRocksDB()->NewIterator(rocksdb::ReadOptions(), engine->GetExpireIndex()));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    auto key = it->key();
+    uint64_t expire = 0;
+    Slice nsname;
+    NDB_ASSERT(DecodeExpireKey(&key, &expire, &nsname));
+    if (nsname == "merge" && key == id) expires.push_back(expire);
+  }
+  return expires;
+}
+
+// Merges of an id index a rounded expire once.
+void TestMergeExpire(Engine* engine) {
+  NDB_ASSERT_OK(engine->NewNamespace("merge"));
+  auto ns = engine->GetNamespace("merge");
+  auto unit = Namespace::kMergeExpireUnit;
+  auto expire = (getmstime() / unit + 3600) * unit + 1;
+
+  auto value = Value::FromInt64(1);
+  value.set_expire(expire);
+  NDB_ASSERT_OK(ns->Merge("counter", value));
+  value.set_expire(expire + 1);
+  NDB_ASSERT_OK(ns->Merge("counter", value));
+  NDB_ASSERT(MergeExpires(engine, "counter") == std::vector<uint64_t>{expire - 1 + unit});
+
+  // The value has the expire of the first merge, rounded up.
+  Value result;
+  NDB_ASSERT_OK(ns->Get("counter", &result));
+  NDB_ASSERT(result.int64() == 2 && result.expire() == expire - 1 + unit);
+
+  // Expires in other units are indexed again.
+  value.set_expire(expire + unit);
+  NDB_ASSERT_OK(ns->Merge("counter", value));
+  NDB_ASSERT(MergeExpires(engine, "counter").size() == 2);
+  NDB_ASSERT_OK(engine->DropNamespace("merge"));
+}
+
 int Test(int argc, char* argv[]) {
   auto engine = new Engine(Engine::Options());
   NDB_ASSERT_OK(engine->Open());
+  NDB_ASSERT(engine->GetExpireIndex() != NULL);
+  NDB_ASSERT(!engine->NewNamespace("__expire__").ok());
 
   TestNamespace(engine, "user");
   TestNamespace(engine, "show");
   TestNamespace(engine, "like");
+  TestBatchDurability(engine);
+  TestMergeExpire(engine);
+  TestReopen(&engine);
 
   delete engine;
   system("rm -rf nicedb");
@@ -0,0 +1,89 @@
+#include "units/units.h"
+#include "ndb/engine/packed.h"
+
+void TestPackedMembers() {
+  PackedMembers members;
+  NDB_ASSERT(members.Put("b", Value::FromBytes("2").Encode()));
+  NDB_ASSERT(members.Put("a", Value::FromInt64(1).Encode()));
+  NDB_ASSERT(members.Put("c", Slice()));
+  NDB_ASSERT(!members.Put("b", Value::FromBytes("22").Encode()));
+  NDB_ASSERT(members.Delete("c"));
+  NDB_ASSERT(!members.Delete("c"));
+  NDB_ASSERT(members.size() == 2);
+
+  // Members are encoded in the order of fields.
+  auto encoded = members.Encode();
+  Slice in = encoded, field, value;
+  ValueView view;
+  NDB_ASSERT(PackedMembers::Next(&in, &field, &value) && field == "a");
+  NDB_ASSERT_OK(view.Decode(value));
+  NDB_ASSERT(view.has_int64() && view.int64() == 1);
+  NDB_ASSERT(PackedMembers::Next(&in, &field, &value) && field == "b");
+  NDB_ASSERT_OK(view.Decode(value));
+  NDB_ASSERT(view.has_bytes() && view.bytes() == "22");
+  NDB_ASSERT(in.size() == 0);
+
+  NDB_ASSERT_OK(PackedMembers::Find(encoded, "b", &value));
+  NDB_ASSERT(PackedMembers::Find(encoded, "0", &value).IsNotFound());
+  NDB_ASSERT(PackedMembers::Find(encoded, "c", &value).IsNotFound());
+
+  PackedMembers decoded;
+  NDB_ASSERT_OK(decoded.Decode(encoded));
+  NDB_ASSERT(decoded.members() == members.members());
+  NDB_ASSERT(decoded.Get("a") != NULL && decoded.Get("c") == NULL);
+
+  // Truncated members are invalid.
+  encoded.pop_back();
+  NDB_ASSERT(!decoded.Decode(encoded).ok());
+  NDB_ASSERT(!PackedMembers::Find(encoded, "c", &value).ok());
+}
+
+void TestFits() {
+  PackedMembers members;
+  members.Put("a", "1");
+  members.Put("b", std::string(8, 'b'));
+  NDB_ASSERT(members.Fits(2, 8));
+  NDB_ASSERT(!members.Fits(1, 8));
+  NDB_ASSERT(!members.Fits(2, 7));
+  members.Put(std::string(9, 'c'), "3");
+  NDB_ASSERT(!members.Fits(3, 8));
+}
+
+void TestPackedMeta() {
+  PackedMembers members;
+  members.Put("field", Value::FromBytes("value").Encode());
+
+  Value meta;
+  meta.mutable_meta()->set_type(Meta::HASH);
+  meta.mutable_meta()->set_version(3);
+  meta.mutable_meta()->set_length(1);
+  meta.mutable_meta()->set_packed(members.Encode());
+
+  // Packed members follow the fixed meta in both formats.
+  for (const auto& encoded : {meta.Encode(), meta.SerializeAsString()}) {
+    ValueView view;
+    NDB_ASSERT_OK(view.Decode(encoded));
+    NDB_ASSERT(view.meta_has_packed() && view.meta_packed() == meta.meta().packed());
+    NDB_ASSERT(view.meta_version() == 3 && view.meta_length() == 1);
+    if (!view.legacy()) NDB_ASSERT(view.Encode() == encoded);
+
+    Value value;
+    NDB_ASSERT_OK(value.Decode(encoded));
+    NDB_ASSERT(value.meta().packed() == meta.meta().packed());
+  }
+
+  // Metas without packed members are unchanged.
+  meta.mutable_meta()->clear_packed();
+  ValueView view;
+  NDB_ASSERT_OK(view.Decode(meta.Encode()));
+  NDB_ASSERT(!view.meta_has_packed() && view.meta_packed().size() == 0);
+  auto trailing = meta.Encode() + "x";
+  NDB_ASSERT(!view.Decode(trailing).ok());
+}
+
+int Test(int argc, char* argv[]) {
+  TestPackedMembers();
+  TestFits();
+  TestPackedMeta();
+  return 0;
+}
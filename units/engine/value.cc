@@ -1,5 +1,149 @@
 #include "units/units.h"
 
+void TestFormat(const Value& value) {
+  auto encoded = value.Encode();
+
+  // Compact format.
+  Value a;
+  if (value.IsDeleted()) {
+    NDB_ASSERT(a.Decode(encoded).IsNotFound());
+  } else {
+    NDB_ASSERT_OK(a.Decode(encoded));
+    NDB_ASSERT(a.SerializeAsString() == value.SerializeAsString());
+  }
+  ValueView v;
+  NDB_ASSERT_OK(v.Decode(encoded));
+  NDB_ASSERT(!v.legacy());
+  NDB_ASSERT(v.has_expire() == value.has_expire() && v.expire() == value.expire());
+  NDB_ASSERT(v.has_int64() == value.has_int64() && v.int64() == value.int64());
+  NDB_ASSERT(v.has_bytes() == value.has_bytes() && v.bytes() == value.bytes());
+  NDB_ASSERT(v.has_meta() == value.has_meta());
+  NDB_ASSERT(v.meta_version() == value.meta().version());
+  NDB_ASSERT(v.meta_cid() == value.meta().cid());
+  NDB_ASSERT(v.IsDeleted() == value.IsDeleted());
+
+  // Legacy format.
+  std::string legacy;
+  NDB_ASSERT(value.SerializeToString(&legacy));
+  Value b;
+  if (value.IsDeleted()) {
+    NDB_ASSERT(b.Decode(legacy).IsNotFound());
+  } else {
+    NDB_ASSERT_OK(b.Decode(legacy));
+    NDB_ASSERT(b.SerializeAsString() == value.SerializeAsString());
+  }
+  ValueView w;
+  NDB_ASSERT_OK(w.Decode(legacy));
+  NDB_ASSERT(legacy.size() == 0 || w.legacy());
+  NDB_ASSERT(w.has_expire() == value.has_expire() && w.expire() == value.expire());
+  NDB_ASSERT(w.has_int64() == value.has_int64() && w.int64() == value.int64());
+  NDB_ASSERT(w.has_bytes() == value.has_bytes() && w.bytes() == value.bytes());
+  NDB_ASSERT(w.has_meta() == value.has_meta());
+  NDB_ASSERT(w.meta_version() == value.meta().version());
+  NDB_ASSERT(w.meta_cid() == value.meta().cid());
+  NDB_ASSERT(w.IsDeleted() == value.IsDeleted());
+
+  // Legacy values are migrated by the view without protobuf.
+  NDB_ASSERT(w.Encode() == encoded);
+}
+
+void TestFormats() {
+  TestFormat(Value());
+  TestFormat(Value::FromInt64(0));
+  TestFormat(Value::FromInt64(-1));
+  TestFormat(Value::FromInt64(INT64_MAX));
+  TestFormat(Value::FromBytes(""));
+  TestFormat(Value::FromBytes("value"));
+
+  auto value = Value::FromBytes("expire");
+  value.set_expire(getmstime() + 1000);
+  TestFormat(value);
+
+  Value meta;
+  meta.mutable_meta()->set_type(Meta::LIST);
+  meta.mutable_meta()->set_version(1 << 20);
+  meta.mutable_meta()->set_length(10);
+  meta.mutable_meta()->set_minindex(1);
+  meta.mutable_meta()->set_maxindex(10);
+  TestFormat(meta);
+  meta.mutable_meta()->set_maxlen(1024);
+  meta.mutable_meta()->set_pruning(Pruning::MAX);
+  TestFormat(meta);
+  meta.mutable_meta()->set_cid(1ULL << 40);
+  TestFormat(meta);
+  meta.mutable_meta()->set_packed("packed");
+  TestFormat(meta);
+  meta.mutable_meta()->clear_packed();
+  meta.SetLength(0);
+  TestFormat(meta);
+
+  // Cids are dropped with deleted collections.
+  Value deleted;
+  NDB_ASSERT(deleted.Decode(meta.Encode()).IsNotFound());
+  NDB_ASSERT(deleted.meta().cid() == 0);
+
+  ValueView v;
+  NDB_ASSERT(!v.Decode(std::string("\xc1\x01", 2)).ok());
+  NDB_ASSERT(!v.Decode(std::string("\xc3\x01", 2)).ok());
+}
+
+void TestLegacy() {
+  Value value;
+  value.set_int64(1);
+  auto legacy = value.SerializeAsString();
+
+  // Unknown fields are skipped and the last one of a oneof wins.
+  Value unknown;
+  unknown.mutable_meta()->set_type(Meta::HASH);
+  unknown.mutable_meta()->set_version(2);
+  legacy.append("\x2a\x03" "foo", 5);  // Field 5, length delimited.
+  legacy.append("\x35\x00\x00\x00\x00", 5);  // Field 6, fixed32.
+  legacy.append(unknown.SerializeAsString());
+  ValueView v;
+  NDB_ASSERT_OK(v.Decode(legacy));
+  NDB_ASSERT(v.legacy() && v.has_meta() && !v.has_int64());
+  NDB_ASSERT(v.meta_type() == Meta::HASH && v.meta_version() == 2);
+  Value w;
+  NDB_ASSERT_OK(w.Decode(legacy));
+  NDB_ASSERT(v.Encode() == w.Encode());
+
+  // Metas without types are invalid.
+  legacy = std::string("\x1a\x02\x18\x01", 4);
+  NDB_ASSERT(!v.Decode(legacy).ok());
+  NDB_ASSERT(!w.Decode(legacy).ok());
+
+  // Truncated values are invalid.
+  legacy = Value::FromBytes("bytes").SerializeAsString();
+  legacy.resize(legacy.size() - 1);
+  NDB_ASSERT(!v.Decode(legacy).ok());
+}
+
+// Decoded bytes and packed members refer to the encoded data.
+void TestInPlace() {
+  auto within = [](const Slice& part, const std::string& s) {
+    return part.data() >= s.data() && part.data() + part.size() <= s.data() + s.size();
+  };
+
+  auto bytes = Value::FromBytes("bytes");
+  ValueView v;
+  auto compact = bytes.Encode();
+  NDB_ASSERT_OK(v.Decode(compact));
+  NDB_ASSERT(v.bytes() == "bytes" && within(v.bytes(), compact));
+  auto legacy = bytes.SerializeAsString();
+  NDB_ASSERT_OK(v.Decode(legacy));
+  NDB_ASSERT(v.bytes() == "bytes" && within(v.bytes(), legacy));
+
+  Value meta;
+  meta.mutable_meta()->set_type(Meta::HASH);
+  meta.mutable_meta()->set_packed("packed");
+  compact = meta.Encode();
+  NDB_ASSERT_OK(v.Decode(compact));
+  NDB_ASSERT(v.meta_packed() == "packed" && within(v.meta_packed(), compact));
+  legacy = meta.SerializeAsString();
+  NDB_ASSERT_OK(v.Decode(legacy));
+  NDB_ASSERT(v.meta_packed() == "packed" && within(v.meta_packed(), legacy));
+}
+
 int Test(int argc, char* argv[]) {
   Configs configs;
   configs.set_expire(4096);
@@ -53,5 +197,9 @@ int Test(int argc, char* argv[]) {
   NDB_ASSERT(d.meta().deleted());
   NDB_ASSERT(d.meta().length() == 0);
 
+  TestFormats();
+  TestLegacy();
+  TestInPlace();
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,94 @@
+#include "units/units.h"
+
+void TestRecvBuf() {
+  int fds[2];
+  NDB_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+
+  auto pool = std::make_shared<BlockPool>(16, 4);
+  RecvBuf rbuf;
+  rbuf.set_pool(pool);
+
+  // Nothing to read.
+  size_t n = 0;
+  NDB_ASSERT_OK(rbuf.Recv(fds[0], 0, &n));
+  NDB_ASSERT(n == 0 && rbuf.size() == 0);
+
+  // Fill the first block.
+  const char message[] = "0123456789abcdefghij";
+  NDB_ASSERT(write(fds[1], message, 20) == 20);
+  NDB_ASSERT_OK(rbuf.Recv(fds[0], 0, &n));
+  NDB_ASSERT(n == 16 && rbuf.size() == 16);
+  auto first = rbuf.chunk();
+  NDB_ASSERT(pool->used() == 1);
+
+  // The unparsed tail moves to the next block, the first one is kept.
+  rbuf.Skip(10);
+  NDB_ASSERT_OK(rbuf.Recv(fds[0], 0, &n));
+  NDB_ASSERT(n == 4 && rbuf.size() == 10);
+  NDB_ASSERT(memcmp(rbuf.data(), "abcdefghij", 10) == 0);
+  NDB_ASSERT(memcmp(first->data(), "0123456789", 10) == 0);
+  NDB_ASSERT(pool->used() == 2);
+  first.reset();
+  NDB_ASSERT(pool->used() == 1 && pool->unused() == 1);
+
+  // Large element gets its own chunk.
+  std::string large(100, 'x');
+  NDB_ASSERT(write(fds[1], large.data(), large.size()) == (ssize_t) large.size());
+  NDB_ASSERT_OK(rbuf.Recv(fds[0], 10 + large.size(), &n));
+  NDB_ASSERT_OK(rbuf.Recv(fds[0], 10 + large.size(), &n));
+  NDB_ASSERT(rbuf.size() == 10 + large.size());
+  NDB_ASSERT(rbuf.chunk()->capacity() == 10 + large.size());
+  NDB_ASSERT(pool->used() == 0 && pool->unused() == 2);
+
+  // Release the chunk when everything is parsed.
+  rbuf.Skip(rbuf.size());
+  NDB_ASSERT(!rbuf.chunk());
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void TestRequestAcrossBlocks() {
+  int fds[2];
+  NDB_ASSERT(pipe2(fds, O_NONBLOCK) == 0);
+
+  RecvBuf rbuf;
+  rbuf.set_pool(std::make_shared<BlockPool>(8, 4));
+  RequestBuilder builder;
+  std::vector<Request> requests;
+
+  const char message[] = "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$16\r\n0123456789abcdef\r\n";
+  NDB_ASSERT(write(fds[1], message, sizeof(message)-1) == sizeof(message)-1);
+
+  while (true) {
+    size_t n = 0;
+    NDB_ASSERT_OK(rbuf.Recv(fds[0], builder.Needed(), &n));
+    if (n == 0) break;
+    size_t pos = 0;
+    while (pos < rbuf.size()) {
+      auto size = builder.Parse(rbuf.data() + pos, rbuf.size() - pos, rbuf.chunk());
+      NDB_ASSERT(size >= 0);
+      pos += size;
+      if (!builder.IsFinished()) break;
+      requests.push_back(builder.Finish());
+      builder.Reset();
+    }
+    rbuf.Skip(pos);
+  }
+
+  NDB_ASSERT(requests.size() == 1);
+  const auto& request = requests[0];
+  NDB_ASSERT(request.argc() == 3);
+  NDB_ASSERT(request.args(0) == "SET");
+  NDB_ASSERT(request.args(1) == "foo");
+  NDB_ASSERT(request.args(2) == "0123456789abcdef");
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int Test(int argc, char* argv[]) {
+  TestRecvBuf();
+  TestRequestAcrossBlocks();
+  return EXIT_SUCCESS;
+}
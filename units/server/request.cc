@@ -5,15 +5,15 @@ int Test(int argc, char* argv[]) {
 
   // Inline.
   {
-    char message[] = "PING";
+    static char message[] = "PING";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == 0);
   }
   {
-    char message[] = "PING\n";
+    static char message[] = "PING\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) < 0);
   }
   {
-    char message[] = "PING\r\n";
+    static char message[] = "PING\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
     NDB_ASSERT(builder.IsFinished());
     auto request = builder.Finish();
@@ -22,7 +22,7 @@ int Test(int argc, char* argv[]) {
     builder.Reset();
   }
   {
-    char message[] = "ECHO message\r\n";
+    static char message[] = "ECHO message\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
     NDB_ASSERT(builder.IsFinished());
     auto request = builder.Finish();
@@ -34,35 +34,35 @@ int Test(int argc, char* argv[]) {
 
   // MultiBulk
   {
-    char message[] = "*3";
+    static char message[] = "*3";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == 0);
   }
   {
-    char message[] = "*3\n";
+    static char message[] = "*3\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) < 0);
   }
   {
-    char message[] = "$3\r\n";
+    static char message[] = "$3\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) < 0);
   }
   {
-    char message[] = "*3\r\n";
+    static char message[] = "*3\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
   }
   {
-    char message[] = "$3\r\n";
+    static char message[] = "$3\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
   }
   {
-    char message[] = "SET\r\n";
+    static char message[] = "SET\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
   }
   {
-    char message[] = "$3\r\nfoo\r\n";
+    static char message[] = "$3\r\nfoo\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
   }
   {
-    char message[] = "$3\r\nbar\r\n";
+    static char message[] = "$3\r\nbar\r\n";
     NDB_ASSERT(builder.Parse(message, sizeof(message)) == sizeof(message)-1);
   }
   {
@@ -72,6 +72,24 @@ int Test(int argc, char* argv[]) {
     NDB_ASSERT(request.args(0) == "SET");
     NDB_ASSERT(request.args(1) == "foo");
     NDB_ASSERT(request.args(2) == "bar");
+    builder.Reset();
+  }
+
+  // Arguments refer to the chunk.
+  {
+    const char message[] = "*2\r\n$4\r\necho\r\n$5\r\nhello\r\n";
+    auto chunk = std::make_shared<Chunk>(sizeof(message));
+    memcpy(chunk->data(), message, sizeof(message));
+    auto size = builder.Parse(chunk->data(), sizeof(message), chunk);
+    NDB_ASSERT(size == sizeof(message)-1);
+    NDB_ASSERT(builder.IsFinished());
+    auto request = builder.Finish();
+    builder.Reset();
+    NDB_ASSERT(chunk.use_count() == 2);
+    chunk.reset();
+    NDB_ASSERT(request.argc() == 2);
+    NDB_ASSERT(request.args(0) == "ECHO");
+    NDB_ASSERT(request.args(1) == "hello");
   }
 
   return EXIT_SUCCESS;
@@ -0,0 +1,50 @@
+#include "units/units.h"
+
+std::string ToString(const Response& res) {
+  return std::string(res.data(), res.size());
+}
+
+int Test(int argc, char* argv[]) {
+  // Constants.
+  NDB_ASSERT(ToString(Response::OK()) == "+OK\r\n");
+  NDB_ASSERT(ToString(Response::Null()) == "$-1\r\n");
+  NDB_ASSERT(ToString(Response::Size(0)) == "*0\r\n");
+  NDB_ASSERT(Response::OK().IsOK() && Response(Result::OK()).IsOK());
+  NDB_ASSERT(Response::Null().IsNull() && Response(Result::NotFound()).IsNull());
+
+  // Integers.
+  NDB_ASSERT(ToString(Response::Int(0)) == ":0\r\n");
+  NDB_ASSERT(ToString(Response::Int(1)) == ":1\r\n");
+  NDB_ASSERT(ToString(Response::Int(-1)) == ":-1\r\n");
+  NDB_ASSERT(ToString(Response::Int(1234567)) == ":1234567\r\n");
+  NDB_ASSERT(ToString(Response::Int(INT64_MAX)) == ":" + std::to_string(INT64_MAX) + "\r\n");
+  NDB_ASSERT(ToString(Response::Int(INT64_MIN)) == ":" + std::to_string(INT64_MIN) + "\r\n");
+  NDB_ASSERT(ToString(Response::Bulk(-42)) == "$3\r\n-42\r\n");
+
+  // Appending to a constant copies it.
+  auto res = Response::Int(1);
+  res.AppendInt(10);
+  NDB_ASSERT(ToString(res) == ":1\r\n:10\r\n");
+  NDB_ASSERT(ToString(Response::Int(1)) == ":1\r\n");
+
+  // Sizes match the encoding.
+  NDB_ASSERT(Response::SizeOfInt(-100) == Response::Int(-100).size());
+  NDB_ASSERT(Response::SizeOfBulk(INT64_MIN) == Response::Bulk(INT64_MIN).size());
+  NDB_ASSERT(Response::SizeOfBulk("hello", 5) == Response::Bulk("hello", 5).size());
+  NDB_ASSERT(Response::SizeOfSize(12) == Response::Size(12).size());
+
+  std::vector<std::string> bulks = {"a", "bc", ""};
+  NDB_ASSERT(ToString(Response::Bulks(bulks)) == "*3\r\n$1\r\na\r\n$2\r\nbc\r\n$0\r\n\r\n");
+
+  // Reserves of large elements are capped.
+  std::string large(64 << 10, 'x');
+  res = Response::Size(2);
+  auto mark = res.size();
+  res.AppendBulk(large);
+  res.ReserveMore(mark, SIZE_MAX / 2);
+  res.AppendBulk("y", 1);
+  NDB_ASSERT(res.size() == mark + Response::SizeOfBulk(large.data(), large.size()) +
+             Response::SizeOfBulk("y", 1));
+
+  return EXIT_SUCCESS;
+}
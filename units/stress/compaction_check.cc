@@ -1,4 +1,5 @@
 #include "ndb/ndb.h"
+#include "ndb/engine/merge.h"
 
 using namespace ndb;
 using namespace rocksdb;
@@ -12,6 +13,7 @@ Result Open(const std::string& dbname, DB** db, std::vector<ColumnFamilyHandle*>
   std::vector<ColumnFamilyDescriptor> cfds;
   for (const auto& name : cfnames) {
     ColumnFamilyOptions cfopts;
+    cfopts.merge_operator.reset(new ndb::MergeOperator());
     cfds.emplace_back(name, cfopts);
   }
 
@@ -101,6 +103,29 @@ void CheckType(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
   std::unique_ptr<Iterator> it(db->NewIterator(ropts, handle));
   it->SeekToFirst();
 
+  // Collection keys and members keyed by cids sort first, collect them
+  // to check them with their metas.
+  std::map<uint64_t, std::string> ckeys;
+  std::map<uint64_t, int> cmembers;
+  for (; it->Valid() && it->key().starts_with(Slice("\0", 1)); it->Next()) {
+    auto key = it->key();
+    uint64_t cid = 0;
+    NDB_ASSERT(DecodeCollectionKey(&key, &cid));
+    // The ceiling of reserved cids.
+    if (cid == 0) continue;
+    if (key.size() == 0) {
+      Value value;
+      NDB_ASSERT_OK(value.Decode(it->value()));
+      NDB_ASSERT(value.has_bytes());
+      ckeys[cid] = value.bytes();
+    } else {
+      // Collection keys are prefixes of their members.
+      NDB_ASSERT(ckeys.count(cid) == 1);
+      NDB_ASSERT(static_cast<uint8_t>(key[0]) >> 3 == type);
+      cmembers[cid]++;
+    }
+  }
+
   for (int i = 0; i < count; i++) {
     // Deleted
     if (i % 3 == 0) continue;
@@ -120,6 +145,16 @@ void CheckType(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
     NDB_ASSERT_OK(vmeta.Decode(it->value()));
     NDB_ASSERT(vmeta.has_meta() && vmeta.meta().version() == version);
 
+    auto cid = vmeta.meta().cid();
+    if (cid != 0) {
+      NDB_ASSERT(ckeys[cid] == std::string(id, sizeof(id)));
+      NDB_ASSERT(cmembers[cid] == members);
+      ckeys.erase(cid);
+      cmembers.erase(cid);
+      it->Next();
+      continue;
+    }
+
     for (int i = 0; i < members; i++) {
       it->Next();
       NDB_ASSERT(it->Valid());
@@ -136,6 +171,8 @@ void CheckType(DB* db, const std::vector<ColumnFamilyHandle*>& handles,
     it->Next();
   }
 
+  // Keys of dead cids have been filtered.
+  NDB_ASSERT(ckeys.empty() && cmembers.empty());
   NDB_ASSERT(!it->Valid());
   printf("Check %s OK\n", nsname);
 }
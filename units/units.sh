@@ -33,14 +33,23 @@ run "common/channel"
 run "common/logger"
 run "common/encode"
 run "common/socket $ADDRESS"
+run "common/ioloop"
 run "common/eventd $ADDRESS"
 
+run "server/buffer"
 run "server/request"
+run "server/response"
 run "server/server $ADDRESS"
 
 run "engine/encode"
+run "engine/value"
 run "engine/backup"
 run "engine/hashlock"
+run "engine/cache"
+run "engine/merge"
+run "engine/combiner"
+run "engine/packed"
+run "engine/compaction"
 run "engine/namespace"
 
 run "command/common"